@@ -33,8 +33,10 @@ using KeyPair = std::pair<uint64_t, uint64_t>;
 using namespace thrill; // NOLINT
 
 std::string title;
+std::string hashtable = "probing";
 uint64_t size = 64 * 1024 * 1024;
 unsigned int workers = 100;
+uint64_t limit_memory = 256 * 1024 * 1024;
 
 uint64_t item_range = std::numeric_limits<Key>::max();
 
@@ -66,6 +68,7 @@ void RunBenchmark(api::Context& ctx, core::DefaultReduceConfig& base_config) {
         core::DefaultReduceConfigSelect<table_impl> >
     stage(ctx, 0, key_ex, red_fn, emit_fn,
           config);
+    stage.Initialize(limit_memory);
 
     common::StatsTimerStart timer;
 
@@ -81,6 +84,8 @@ void RunBenchmark(api::Context& ctx, core::DefaultReduceConfig& base_config) {
         << " benchmark=" << title
         << " size=" << size
         << " workers=" << workers
+        << " hashtable=" << hashtable
+        << " memory=" << limit_memory
         << " max_partition_fill_rate=" << config.limit_partition_fill_rate()
         << " bucket_rate=" << config.bucket_rate()
         << " time=" << timer.Milliseconds()
@@ -93,16 +98,17 @@ int main(int argc, char* argv[]) {
 
     core::DefaultReduceConfig config;
 
-    std::string hashtable;
-
     clp.AddBytes('s', "size", "S", size,
                  "Set amount of bytes to be inserted, default = 64 MiB");
 
     clp.AddString('t', "title", "T", title,
                   "Load in byte to be inserted");
 
-    clp.AddString('h', "hash-table", "H", hashtable,
-                  "Set hashtable: probing or bucket");
+    clp.AddString('H', "hash-table", "H", hashtable,
+                  "Set hashtable: probing, bucket or swiss");
+
+    clp.AddBytes('m', "memory", "M", limit_memory,
+                 "Set memory limit of the hash table, default = 256 MiB");
 
     clp.AddUInt('w', "workers", "W", workers,
                 "Open hashtable with W workers, default = 1.");
@@ -127,6 +133,8 @@ int main(int argc, char* argv[]) {
         [&](api::Context& ctx) {
             if (hashtable == "bucket")
                 return RunBenchmark<core::ReduceTableImpl::BUCKET>(ctx, config);
+            else if (hashtable == "swiss")
+                return RunBenchmark<core::ReduceTableImpl::SWISS>(ctx, config);
             else
                 return RunBenchmark<core::ReduceTableImpl::PROBING>(ctx, config);
         });
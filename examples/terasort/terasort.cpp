@@ -17,6 +17,7 @@
 #include <thrill/common/string.hpp>
 
 #include <algorithm>
+#include <array>
 #include <random>
 #include <string>
 #include <utility>
@@ -38,6 +39,15 @@ struct Record {
 
 static_assert(sizeof(Record) == 100, "struct Record packing incorrect.");
 
+//! key extractor for SortByKey(), which radix sorts the 10-byte keys.
+struct RecordKey {
+    std::array<uint8_t, 10> operator () (const Record& r) const {
+        std::array<uint8_t, 10> key;
+        std::copy(r.key, r.key + 10, key.begin());
+        return key;
+    }
+};
+
 struct RecordSigned {
     char key[10];
     char value[90];
@@ -167,7 +177,7 @@ int main(int argc, char* argv[]) {
 
                 auto r =
                     Generate(ctx, GenerateRecord(), size / sizeof(Record))
-                    .Sort();
+                    .SortByKey(RecordKey());
 
                 if (output.size())
                     r.WriteBinary(output);
@@ -184,7 +194,8 @@ int main(int argc, char* argv[]) {
                         r.Execute();
                 }
                 else {
-                    auto r = ReadBinary<Record>(ctx, input).Sort();
+                    auto r = ReadBinary<Record>(ctx, input)
+                             .SortByKey(RecordKey());
 
                     if (output.size())
                         r.WriteBinary(output);
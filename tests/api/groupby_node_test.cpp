@@ -20,7 +20,9 @@
 #include <algorithm>
 #include <cstdlib>
 #include <limits>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
 using namespace thrill; // NOLINT
@@ -165,4 +167,293 @@ TEST(GroupByNode, GroupToIndexCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+class HashGroupByConfig : public api::DefaultGroupByConfig
+{
+public:
+    static constexpr bool use_hash_grouping_ = true;
+};
+
+//! key type without operator <, which can only be grouped by hashing.
+struct ModKey {
+    size_t a, b;
+    bool operator == (const ModKey& o) const { return a == o.a && b == o.b; }
+};
+
+struct ModKeyHash {
+    size_t operator () (const ModKey& k) const noexcept {
+        return std::hash<size_t>()(k.a * 31 + k.b);
+    }
+};
+
+TEST(GroupByNode, HashGroupingSum) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+            static constexpr size_t m = 7;
+
+            auto sizets = Generate(ctx, n);
+
+            auto key_fn = [](size_t in) { return ModKey { in % m, in % 2 }; };
+
+            auto sum_fn =
+                [](auto& r, const ModKey& key) {
+                    size_t res = 0;
+                    while (r.HasNext()) {
+                        size_t v = r.Next();
+                        EXPECT_EQ(key.a, v % m);
+                        EXPECT_EQ(key.b, v % 2);
+                        res += v;
+                    }
+                    return res;
+                };
+
+            auto reduced =
+                sizets.GroupByKey<size_t, decltype(key_fn), decltype(sum_fn),
+                                  ModKeyHash>(
+                    key_fn, sum_fn, HashGroupByConfig());
+            std::vector<size_t> out_vec = reduced.AllGather();
+
+            // compute vector with expected results
+            std::vector<size_t> res_vec(2 * m, 0);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[2 * (t % m) + t % 2] += t;
+            }
+
+            std::sort(out_vec.begin(), out_vec.end());
+            std::sort(res_vec.begin(), res_vec.end());
+
+            ASSERT_EQ(res_vec, out_vec);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! group n items, of which three quarters belong to one heavy group.
+static void SplitHeavyGroupsSum(Context& ctx, size_t n) {
+    static constexpr size_t m = 51;
+
+    using KeySum = std::pair<size_t, size_t>;
+
+    auto sizets = Generate(ctx, n);
+
+    // three quarters of the items belong to the group of key 0.
+    auto key_fn = [](size_t in) { return in % 4 == 0 ? in % m : 0; };
+
+    auto sum_fn =
+        [&key_fn](auto& r, const size_t& key) {
+            size_t res = 0;
+            while (r.HasNext()) {
+                size_t v = r.Next();
+                EXPECT_EQ(key, key_fn(v));
+                res += v;
+            }
+            return KeySum(key, res);
+        };
+
+    auto combine_fn =
+        [](const KeySum& a, const KeySum& b) {
+            EXPECT_EQ(a.first, b.first);
+            return KeySum(a.first, a.second + b.second);
+        };
+
+    auto reduced = sizets.GroupByKey<KeySum>(
+        SplitGroupsTag, key_fn, sum_fn, combine_fn);
+    std::vector<KeySum> out_vec = reduced.AllGather();
+    std::sort(out_vec.begin(), out_vec.end());
+
+    // compute vector with expected results
+    std::vector<KeySum> res_vec(m);
+    for (size_t k = 0; k < m; ++k) res_vec[k].first = k;
+    for (size_t t = 0; t < n; ++t) {
+        res_vec[key_fn(t)].second += t;
+    }
+
+    ASSERT_EQ(res_vec, out_vec);
+}
+
+TEST(GroupByNode, SplitHeavyGroupsSum) {
+    api::RunLocalTests(
+        [](Context& ctx) { SplitHeavyGroupsSum(ctx, 20000); });
+}
+
+TEST(GroupByNode, SplitHeavyGroupsExceedingMemory) {
+    // the parts of the heavy group exceed the memory limit of the workers,
+    // hence partial results are emitted early.
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(
+        mem_config, 2, 1,
+        [](Context& ctx) { SplitHeavyGroupsSum(ctx, 4000000); });
+}
+
+//! merge the runs in parallel, also on machines with few cores
+class ParallelMergeGroupByConfig : public api::DefaultGroupByConfig
+{
+public:
+    static constexpr size_t merge_threads_ = 2;
+    static constexpr size_t parallel_merge_min_items_ = 1024;
+};
+
+TEST(GroupByNode, ParallelMergeSum) {
+    // enough items to create multiple sorted runs in the memory limit
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(
+        mem_config, 2, 1,
+        [](Context& ctx) {
+            size_t n = 4000000;
+            static constexpr size_t m = 1000;
+
+            auto sizets = Generate(ctx, n);
+
+            auto key_fn = [](size_t in) { return in % m; };
+
+            auto sum_fn =
+                [&key_fn](auto& r, const size_t& key) {
+                    size_t res = 0;
+                    while (r.HasNext()) {
+                        size_t v = r.Next();
+                        EXPECT_EQ(key, key_fn(v));
+                        res += v;
+                    }
+                    return res;
+                };
+
+            auto reduced = sizets.GroupByKey<size_t>(
+                key_fn, sum_fn, ParallelMergeGroupByConfig());
+            std::vector<size_t> out_vec = reduced.AllGather();
+
+            // compute vector with expected results
+            std::vector<size_t> res_vec(m, 0);
+            for (size_t t = 0; t < n; ++t) {
+                res_vec[key_fn(t)] += t;
+            }
+
+            std::sort(out_vec.begin(), out_vec.end());
+            std::sort(res_vec.begin(), res_vec.end());
+
+            ASSERT_EQ(res_vec, out_vec);
+        });
+}
+
+TEST(GroupByNode, LocalCombineWordCount) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 10000;
+            static constexpr size_t m = 13;
+
+            using WordCount = std::pair<size_t, size_t>;
+
+            auto words = Generate(
+                ctx, [](size_t i) { return WordCount(i % m, 1); }, n);
+
+            auto count_fn =
+                [&ctx](auto& r, const size_t& word) {
+                    size_t items = 0, count = 0;
+                    while (r.HasNext()) {
+                        WordCount wc = r.Next();
+                        EXPECT_EQ(word, wc.first);
+                        count += wc.second;
+                        ++items;
+                    }
+                    // each worker sent at most one combined item per word
+                    EXPECT_LE(items, ctx.num_workers());
+                    return WordCount(word, count);
+                };
+
+            auto combine_fn =
+                [](const WordCount& a, const WordCount& b) {
+                    return WordCount(a.first, a.second + b.second);
+                };
+
+            auto counts = words.GroupByKey<WordCount>(
+                LocalCombineTag,
+                [](const WordCount& wc) { return wc.first; },
+                count_fn, combine_fn);
+            std::vector<WordCount> out_vec = counts.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(m, out_vec.size());
+            for (size_t k = 0; k < m; ++k) {
+                ASSERT_EQ(k, out_vec[k].first);
+                ASSERT_EQ(n / m + (k < n % m ? 1 : 0), out_vec[k].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! key type without std::hash specialization, hashed by CustomKeyHash.
+struct CustomKey {
+    size_t id;
+
+    bool operator == (const CustomKey& b) const { return id == b.id; }
+    bool operator != (const CustomKey& b) const { return id != b.id; }
+    bool operator < (const CustomKey& b) const { return id < b.id; }
+
+    friend std::ostream& operator << (std::ostream& os, const CustomKey& k) {
+        return os << k.id;
+    }
+};
+
+struct CustomKeyHash {
+    size_t operator () (const CustomKey& k) const noexcept {
+        return std::hash<size_t>()(k.id);
+    }
+};
+
+TEST(GroupByNode, LocalCombineCustomHash) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 10000;
+            static constexpr size_t m = 13;
+
+            using KeyCount = std::pair<CustomKey, size_t>;
+
+            auto items = Generate(
+                ctx, [](size_t i) { return KeyCount(CustomKey { i % m }, 1); },
+                n);
+
+            auto key_fn = [](const KeyCount& kc) { return kc.first; };
+
+            auto count_fn =
+                [](auto& r, const CustomKey& key) {
+                    size_t count = 0;
+                    while (r.HasNext()) {
+                        KeyCount kc = r.Next();
+                        EXPECT_EQ(key.id, kc.first.id);
+                        count += kc.second;
+                    }
+                    return std::make_pair(key.id, count);
+                };
+
+            auto combine_fn =
+                [](const KeyCount& a, const KeyCount& b) {
+                    return KeyCount(a.first, a.second + b.second);
+                };
+
+            using Pair = std::pair<size_t, size_t>;
+
+            auto counts = items.GroupByKey<
+                Pair, decltype(key_fn), decltype(count_fn),
+                decltype(combine_fn), CustomKeyHash>(
+                LocalCombineTag, key_fn, count_fn, combine_fn);
+            std::vector<Pair> out_vec = counts.AllGather();
+            std::sort(out_vec.begin(), out_vec.end());
+
+            ASSERT_EQ(m, out_vec.size());
+            for (size_t k = 0; k < m; ++k) {
+                ASSERT_EQ(k, out_vec[k].first);
+                ASSERT_EQ(n / m + (k < n % m ? 1 : 0), out_vec[k].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
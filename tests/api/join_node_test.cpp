@@ -0,0 +1,227 @@
+/*******************************************************************************
+ * tests/api/join_node_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/api/all_gather.hpp>
+#include <thrill/api/generate.hpp>
+#include <thrill/api/inner_join.hpp>
+#include <thrill/api/size.hpp>
+#include <thrill/api/sum.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace thrill; // NOLINT
+
+using Pair = std::pair<size_t, size_t>;
+
+TEST(JoinNode, InnerJoinUniqueKeys) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 1000;
+
+            // keys 0..999 on the left, only even keys on the right
+            auto left = Generate(ctx, n);
+            auto right = Generate(
+                ctx, [](size_t i) { return Pair(2 * i, 3 * i); }, n / 2);
+
+            auto joined = left.InnerJoin(
+                right,
+                [](const size_t& a) { return a; },
+                [](const Pair& b) { return b.first; },
+                [](const size_t& a, const Pair& b) {
+                    return Pair(a, b.second);
+                });
+
+            std::vector<Pair> out = joined.AllGather();
+            std::sort(out.begin(), out.end());
+
+            ASSERT_EQ(n / 2, out.size());
+            for (size_t i = 0; i < out.size(); ++i) {
+                ASSERT_EQ(2 * i, out[i].first);
+                ASSERT_EQ(3 * i, out[i].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(JoinNode, InnerJoinDuplicateKeys) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 600;
+            static constexpr size_t m = 7;
+            static constexpr size_t k = 5;
+
+            auto left = Generate(ctx, n);
+            auto right = Generate(ctx, 4 * m);
+
+            // each key i < m of the right side occurs four times, key k of
+            // the left side occurs n / k times.
+            auto joined = InnerJoin(
+                left, right,
+                [](const size_t& a) { return a % k; },
+                [](const size_t& b) { return b % m; },
+                [](const size_t& a, const size_t& b) {
+                    return Pair(a, b);
+                });
+
+            std::vector<Pair> out = joined.AllGather();
+            std::sort(out.begin(), out.end());
+
+            std::vector<Pair> check;
+            for (size_t a = 0; a < n; ++a) {
+                for (size_t b = 0; b < 4 * m; ++b) {
+                    if (a % k == b % m) check.emplace_back(a, b);
+                }
+            }
+
+            ASSERT_EQ(check, out);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(JoinNode, InnerJoinEmptySide) {
+
+    auto start_func =
+        [](Context& ctx) {
+            auto left = Generate(ctx, 100);
+            auto right = Generate(ctx, 0);
+
+            auto joined = left.InnerJoin(
+                right,
+                [](const size_t& a) { return a; },
+                [](const size_t& b) { return b; },
+                [](const size_t& a, const size_t& b) { return a + b; });
+
+            ASSERT_EQ(0u, joined.Size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! few partitions and levels, such that the tests reach BlockJoin quickly.
+class SpillingJoinConfig : public api::DefaultInnerJoinConfig
+{
+public:
+    static constexpr size_t spill_partitions_ = 4;
+    static constexpr size_t max_spill_levels_ = 2;
+};
+
+TEST(JoinNode, InnerJoinSpilling) {
+    // the build side's hash table exceeds the memory limit of the workers,
+    // hence both sides are partitioned on level 0.
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(
+        mem_config, 2, 1,
+        [](Context& ctx) {
+            static constexpr size_t n = 1000000;
+
+            auto left = Generate(ctx, n);
+            auto right = Generate(
+                ctx, [](size_t i) { return Pair(2 * i, 3 * i); }, n / 2);
+
+            auto joined = InnerJoin(
+                left, right,
+                [](const size_t& a) { return a; },
+                [](const Pair& b) { return b.first; },
+                [](const size_t& a, const Pair& b) {
+                    return Pair(a, b.second);
+                },
+                std::hash<size_t>(), SpillingJoinConfig());
+
+            std::vector<Pair> out = joined.AllGather();
+            std::sort(out.begin(), out.end());
+
+            ASSERT_EQ(n / 2, out.size());
+            for (size_t i = 0; i < out.size(); ++i) {
+                ASSERT_EQ(2 * i, out[i].first);
+                ASSERT_EQ(3 * i, out[i].second);
+            }
+        });
+}
+
+TEST(JoinNode, InnerJoinFrequentKey) {
+    // a single key on the build side exceeds the memory limit, which cannot be
+    // split by partitioning, hence it is joined block-wise.
+    api::MemoryConfig mem_config;
+    mem_config.setup(64 * 1024 * 1024llu);
+
+    api::RunLocalMock(
+        mem_config, 2, 1,
+        [](Context& ctx) {
+            static constexpr size_t n = 600000;
+            static constexpr size_t m = 100;
+
+            // keys 0..m-1 on the left, key 0 in all but m items on the right
+            auto left = Generate(ctx, m);
+            auto right = Generate(
+                ctx, [](size_t i) { return Pair(i < n - m ? 0 : i % m, i); },
+                n);
+
+            auto joined = InnerJoin(
+                left, right,
+                [](const size_t& a) { return a; },
+                [](const Pair& b) { return b.first; },
+                [](const size_t& a, const Pair& b) {
+                    return Pair(a, b.second);
+                },
+                std::hash<size_t>(), SpillingJoinConfig());
+
+            // check the number of pairs and the sum of their right items
+            size_t sum = joined.Map([](const Pair& p) { return p.second; })
+                         .Sum();
+
+            ASSERT_EQ(n, joined.Size());
+            ASSERT_EQ(n * (n - 1) / 2, sum);
+        });
+}
+
+TEST(JoinNode, BroadcastInnerJoin) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 1000;
+            static constexpr size_t m = 10;
+
+            auto large = Generate(ctx, n);
+            auto small = Generate(
+                ctx, [](size_t i) { return Pair(i % m, i); }, 2 * m);
+
+            auto joined = large.InnerJoin(
+                BroadcastTag, small,
+                [](const size_t& a) { return a % (2 * m); },
+                [](const Pair& b) { return b.first; },
+                [](const size_t& a, const Pair& b) {
+                    return Pair(a, b.second);
+                });
+
+            std::vector<Pair> out = joined.AllGather();
+            std::sort(out.begin(), out.end());
+
+            std::vector<Pair> check;
+            for (size_t a = 0; a < n; ++a) {
+                for (size_t b = 0; b < 2 * m; ++b) {
+                    if (a % (2 * m) == b % m) check.emplace_back(a, b);
+                }
+            }
+
+            ASSERT_EQ(check, out);
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+/******************************************************************************/
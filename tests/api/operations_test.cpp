@@ -28,6 +28,7 @@
 #include <thrill/api/size.hpp>
 #include <thrill/api/sort.hpp>
 #include <thrill/api/sum.hpp>
+#include <thrill/api/top_k.hpp>
 #include <thrill/api/union.hpp>
 #include <thrill/api/window.hpp>
 #include <thrill/api/write_binary.hpp>
@@ -903,6 +904,59 @@ TEST(Operations, Sample) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Operations, TopK) {
+
+    auto start_func =
+        [](Context& ctx) {
+            size_t n = 9999;
+
+            // permutation of [0,n), since n and 7919 are coprime
+            auto input =
+                Generate(ctx, [n](size_t i) { return (i * 7919) % n; }, n)
+                .Keep();
+
+            // k smallest items
+            {
+                std::vector<size_t> out_vec = input.Keep().TopK(100).AllGather();
+
+                ASSERT_EQ(100u, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i)
+                    ASSERT_EQ(i, out_vec[i]);
+            }
+
+            // k largest items
+            {
+                std::vector<size_t> out_vec =
+                    input.Keep().TopK(10, std::greater<size_t>()).AllGather();
+
+                ASSERT_EQ(10u, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i)
+                    ASSERT_EQ(n - 1 - i, out_vec[i]);
+            }
+
+            // k larger than the input
+            {
+                std::vector<size_t> out_vec = input.TopK(20000).AllGather();
+
+                ASSERT_EQ(n, out_vec.size());
+                ASSERT_TRUE(std::is_sorted(out_vec.begin(), out_vec.end()));
+            }
+
+            // many equal items
+            {
+                std::vector<size_t> out_vec =
+                    Generate(ctx, [](size_t i) { return i % 3; }, 1000)
+                    .TopK(50).AllGather();
+
+                ASSERT_EQ(50u, out_vec.size());
+                for (size_t i = 0; i < out_vec.size(); ++i)
+                    ASSERT_EQ(0u, out_vec[i]);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 TEST(Operations, ForLoop) {
 
     auto start_func =
@@ -169,4 +169,155 @@ TEST(ReduceNode, ReduceToIndexCorrectResults) {
     api::RunLocalTests(start_func);
 }
 
+struct HotKeyReduceConfig : public api::DefaultReduceConfig {
+    static constexpr bool use_hot_key_detection_ = true;
+};
+
+//! Test ReduceByKey and ReducePair with hot key detection on input where most
+//! items have key 0.
+TEST(ReduceNode, ReduceSkewedKeysWithHotKeyDetection) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 20000;
+            static constexpr size_t m = 100;
+
+            auto key = [](size_t i) { return i % 4 == 0 ? (i / 4) % m : 0; };
+
+            auto pairs = Generate(
+                ctx,
+                [&](const size_t& index) {
+                    return std::make_pair(key(index), size_t(1));
+                },
+                n);
+
+            auto reduced = pairs.ReduceByKey(
+                [](const std::pair<size_t, size_t>& p) { return p.first; },
+                [](const std::pair<size_t, size_t>& a,
+                   const std::pair<size_t, size_t>& b) {
+                    return std::make_pair(a.first, a.second + b.second);
+                },
+                HotKeyReduceConfig());
+
+            auto reduced_pair = pairs.ReducePair(
+                [](const size_t& a, const size_t& b) { return a + b; },
+                HotKeyReduceConfig());
+
+            std::vector<size_t> check(m, 0);
+            for (size_t i = 0; i < n; ++i)
+                ++check[key(i)];
+
+            for (auto out : { reduced.AllGather(), reduced_pair.AllGather() }) {
+                std::sort(out.begin(), out.end());
+                ASSERT_EQ(m, out.size());
+                for (size_t i = 0; i < m; ++i) {
+                    ASSERT_EQ(i, out[i].first);
+                    ASSERT_EQ(check[i], out[i].second);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+struct BypassReduceConfig : public api::DefaultReduceConfig {
+    static constexpr bool use_adaptive_bypass_ = true;
+    static constexpr size_t bypass_window_ = 128;
+};
+
+//! Test ReduceByKey with adaptive bypass on input with unique keys followed by
+//! few repeated keys.
+TEST(ReduceNode, ReduceUniqueKeysWithAdaptiveBypass) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 4000;
+            static constexpr size_t m = 10;
+
+            auto key = [](size_t i) { return i < n / 2 ? i : i % m; };
+
+            auto pairs = Generate(
+                ctx,
+                [&](const size_t& index) {
+                    return std::make_pair(key(index), size_t(1));
+                },
+                n);
+
+            auto reduced = pairs.ReduceByKey(
+                [](const std::pair<size_t, size_t>& p) { return p.first; },
+                [](const std::pair<size_t, size_t>& a,
+                   const std::pair<size_t, size_t>& b) {
+                    return std::make_pair(a.first, a.second + b.second);
+                },
+                BypassReduceConfig());
+
+            std::vector<size_t> check(n / 2, 0);
+            for (size_t i = 0; i < n; ++i)
+                ++check[key(i)];
+
+            std::vector<std::pair<size_t, size_t> > out = reduced.AllGather();
+            std::sort(out.begin(), out.end());
+            ASSERT_EQ(n / 2, out.size());
+            for (size_t i = 0; i < n / 2; ++i) {
+                ASSERT_EQ(i, out[i].first);
+                ASSERT_EQ(check[i], out[i].second);
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+struct SortFallbackReduceConfig : public api::DefaultReduceConfig {
+    static constexpr bool use_sort_fallback_ = true;
+    static constexpr size_t sort_fallback_sample_ = 128;
+    static constexpr double sort_fallback_min_fill_ = 0.0;
+};
+
+//! Test ReduceByKey and ReducePair with sort fallback on input with mostly
+//! unique keys, which switches the post stage to sorting.
+TEST(ReduceNode, ReduceUniqueKeysWithSortFallback) {
+
+    auto start_func =
+        [](Context& ctx) {
+            static constexpr size_t n = 4000;
+            static constexpr size_t m = n / 2;
+
+            auto key = [](size_t i) { return (i * 7919) % m; };
+
+            auto pairs = Generate(
+                ctx,
+                [&](const size_t& index) {
+                    return std::make_pair(key(index), index);
+                },
+                n);
+
+            auto reduced = pairs.ReduceByKey(
+                [](const std::pair<size_t, size_t>& p) { return p.first; },
+                [](const std::pair<size_t, size_t>& a,
+                   const std::pair<size_t, size_t>& b) {
+                    return std::make_pair(a.first, a.second + b.second);
+                },
+                SortFallbackReduceConfig());
+
+            auto reduced_pair = pairs.ReducePair(
+                [](const size_t& a, const size_t& b) { return a + b; },
+                SortFallbackReduceConfig());
+
+            std::vector<size_t> check(m, 0);
+            for (size_t i = 0; i < n; ++i)
+                check[key(i)] += i;
+
+            for (auto out : { reduced.AllGather(), reduced_pair.AllGather() }) {
+                std::sort(out.begin(), out.end());
+                ASSERT_EQ(m, out.size());
+                for (size_t i = 0; i < m; ++i) {
+                    ASSERT_EQ(i, out[i].first);
+                    ASSERT_EQ(check[i], out[i].second);
+                }
+            }
+        };
+
+    api::RunLocalTests(start_func);
+}
+
 /******************************************************************************/
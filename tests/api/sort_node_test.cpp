@@ -12,10 +12,12 @@
 #include <thrill/api/generate.hpp>
 #include <thrill/api/read_binary.hpp>
 #include <thrill/api/sort.hpp>
+#include <thrill/common/parallel_sort.hpp>
 
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <string>
 #include <utility>
 #include <vector>
@@ -163,6 +165,385 @@ TEST(Sort, SortRandomIntIntStructs) {
     api::RunLocalTests(start_func);
 }
 
+TEST(Sort, SortByKeyRandomSignedIntegers) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(-100000, 100000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> IntIntStruct {
+                    return IntIntStruct {
+                        distribution(generator), distribution(generator)
+                    };
+                },
+                100000);
+
+            auto sorted = integers.SortByKey(
+                [](const IntIntStruct& s) { return s.a; });
+
+            std::vector<IntIntStruct> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i + 1 < out_vec.size(); i++) {
+                ASSERT_FALSE(out_vec[i + 1].a < out_vec[i].a);
+            }
+
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortByKeyRandomByteStrings) {
+
+    using Key = std::array<uint8_t, 10>;
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            // few distinct values, such that keys share long prefixes
+            std::uniform_int_distribution<int> distribution(0, 2);
+
+            auto keys = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> Key {
+                    Key k;
+                    for (size_t i = 0; i < k.size(); ++i)
+                        k[i] = static_cast<uint8_t>(distribution(generator));
+                    return k;
+                },
+                100000);
+
+            auto sorted = keys.SortByKey([](const Key& k) { return k; });
+
+            std::vector<Key> out_vec = sorted.AllGather();
+
+            ASSERT_TRUE(std::is_sorted(out_vec.begin(), out_vec.end()));
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+class TreeReduceSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr api::SortSplitterSelection splitter_selection_ =
+        api::SortSplitterSelection::TREE_REDUCE;
+
+    //! use a small bound such that downsampling happens on each level
+    static constexpr size_t tree_samples_per_worker_ = 4;
+};
+
+TEST(Sort, SortRandomIntegersTreeReduceSplitters) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(0, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                100000);
+
+            auto sorted = integers.Sort(
+                std::less<int>(), api::DefaultSortAlgorithm(),
+                TreeReduceSortConfig());
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomIntegersParallelSampleSort) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(0, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                100000);
+
+            // sort runs in parallel using the host-wide thread pool
+            auto sorted = integers.Sort(
+                std::less<int>(),
+                common::ParallelSampleSort(ctx.thread_pool(), 1024));
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+class PipelinedSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr bool use_background_thread_ = true;
+};
+
+TEST(Sort, SortRandomIntegersPipelined) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(0, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                100000);
+
+            auto sorted = integers.Sort(
+                std::less<int>(), api::DefaultSortAlgorithm(),
+                PipelinedSortConfig());
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+//! a SortConfig with mutable members, set at run-time
+class MutableSortConfig : public api::DefaultSortConfig
+{
+public:
+    api::SortSplitterSelection splitter_selection_ =
+        api::SortSplitterSelection::GATHER_ROOT;
+    size_t tree_samples_per_worker_ = 64;
+    size_t sort_levels_ = 1;
+    bool use_background_thread_ = false;
+    size_t merge_threads_ = 0;
+    size_t parallel_merge_min_items_ = 65536;
+    size_t merge_prefetch_per_disk_ = 4;
+    bool use_forecast_prefetch_ = true;
+};
+
+TEST(Sort, SortRandomIntegersMutableConfig) {
+
+    auto start_func =
+        [](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<int> distribution(0, 10000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> int {
+                    return distribution(generator);
+                },
+                100000);
+
+            MutableSortConfig config;
+            config.splitter_selection_ =
+                api::SortSplitterSelection::TREE_REDUCE;
+            config.use_background_thread_ = true;
+
+            auto sorted = integers.Sort(
+                std::less<int>(), api::DefaultSortAlgorithm(), config);
+
+            std::vector<int> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i < out_vec.size() - 1; i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(100000u, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+template <size_t Levels>
+class MultiLevelSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr size_t sort_levels_ = Levels;
+};
+
+template <size_t Levels>
+void TestMultiLevelSort(size_t test_size) {
+
+    auto start_func =
+        [test_size](Context& ctx) {
+
+            std::default_random_engine generator(std::random_device { } ());
+            std::uniform_int_distribution<size_t> distribution(0, 1000);
+
+            auto integers = Generate(
+                ctx,
+                [&distribution, &generator](const size_t&) -> size_t {
+                    return distribution(generator);
+                },
+                test_size);
+
+            auto sorted = integers.Sort(
+                std::less<size_t>(), api::DefaultSortAlgorithm(),
+                MultiLevelSortConfig<Levels>());
+
+            std::vector<size_t> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i + 1 < out_vec.size(); i++) {
+                ASSERT_FALSE(out_vec[i + 1] < out_vec[i]);
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortRandomIntegersTwoLevels) {
+    TestMultiLevelSort<2>(100000);
+}
+
+TEST(Sort, SortRandomIntegersThreeLevels) {
+    TestMultiLevelSort<3>(100000);
+}
+
+TEST(Sort, SortFewIntegersThreeLevels) {
+    TestMultiLevelSort<3>(3);
+}
+
+template <typename SortConfig>
+void TestSortStable(size_t test_size) {
+
+    auto start_func =
+        [test_size](Context& ctx) {
+
+            using Pair = std::pair<size_t, size_t>;
+
+            // few distinct keys, the second component is the input position
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) -> Pair {
+                    return Pair((index * 7919) % 17, index);
+                },
+                test_size);
+
+            auto sorted = pairs.SortStable(
+                [](const Pair& a, const Pair& b) {
+                    return a.first < b.first;
+                },
+                api::DefaultStableSortAlgorithm(), SortConfig());
+
+            std::vector<Pair> out_vec = sorted.AllGather();
+
+            for (size_t i = 0; i + 1 < out_vec.size(); i++) {
+                ASSERT_TRUE(out_vec[i] < out_vec[i + 1]);
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        };
+
+    api::RunLocalTests(start_func);
+}
+
+TEST(Sort, SortStable) {
+    TestSortStable<api::DefaultSortConfig>(100000);
+}
+
+TEST(Sort, SortStablePipelined) {
+    TestSortStable<PipelinedSortConfig>(100000);
+}
+
+TEST(Sort, SortStableThreeLevels) {
+    TestSortStable<MultiLevelSortConfig<3> >(100000);
+}
+
+//! merge the runs in parallel, also on machines with few cores
+class ParallelMergeSortConfig : public api::DefaultSortConfig
+{
+public:
+    static constexpr size_t merge_threads_ = 2;
+    static constexpr size_t parallel_merge_min_items_ = 1024;
+};
+
+//! sort enough items to create multiple runs in the memory limit
+static void SortParallelMerge(bool stable) {
+    api::MemoryConfig mem_config;
+    mem_config.setup(128 * 1024 * 1024llu);
+
+    api::RunLocalMock(
+        mem_config, 2, 1,
+        [stable](Context& ctx) {
+            const size_t test_size = 2000000;
+            using Pair = std::pair<size_t, size_t>;
+
+            // few distinct keys, the second component is the input position
+            auto pairs = Generate(
+                ctx,
+                [](const size_t& index) -> Pair {
+                    return Pair((index * 7919) % 1000, index);
+                },
+                test_size);
+
+            auto compare_fn = [](const Pair& a, const Pair& b) {
+                                  return a.first < b.first;
+                              };
+
+            std::vector<Pair> out_vec =
+                stable ? pairs.SortStable(
+                    compare_fn, api::DefaultStableSortAlgorithm(),
+                    ParallelMergeSortConfig()).AllGather()
+                : pairs.Sort(
+                    compare_fn, api::DefaultSortAlgorithm(),
+                    ParallelMergeSortConfig()).AllGather();
+
+            for (size_t i = 0; i + 1 < out_vec.size(); i++) {
+                if (stable)
+                    ASSERT_TRUE(out_vec[i] < out_vec[i + 1]);
+                else
+                    ASSERT_FALSE(out_vec[i + 1].first < out_vec[i].first);
+            }
+
+            ASSERT_EQ(test_size, out_vec.size());
+        });
+}
+
+TEST(Sort, SortParallelMerge) {
+    SortParallelMerge(/* stable */ false);
+}
+
+TEST(Sort, SortStableParallelMerge) {
+    SortParallelMerge(/* stable */ true);
+}
+
 TEST(Sort, SortZeros) {
 
     auto start_func =
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * tests/common/numa_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/common/numa.hpp>
+
+#include <vector>
+
+using namespace thrill;
+
+TEST(NumaTopology, ParseCpuList) {
+    using common::NumaTopology;
+    ASSERT_EQ(std::vector<size_t>({ 0 }), NumaTopology::ParseCpuList("0"));
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 8, 10, 11 }),
+              NumaTopology::ParseCpuList("0-3,8,10-11\n"));
+    ASSERT_EQ(std::vector<size_t>(), NumaTopology::ParseCpuList(""));
+}
+
+TEST(NumaTopology, CompactWorkerPlacement) {
+    // two nodes with interleaved cpus, and an empty memory-only node
+    common::NumaTopology topo({ { 0, 2 }, { }, { 1, 3 } }, { 0, 1, 2 });
+    ASSERT_EQ(2u, topo.num_nodes());
+    ASSERT_EQ(4u, topo.num_cpus());
+
+    // consecutive workers fill node 0 first, then node 1, then wrap around
+    std::vector<size_t> cpus, nodes;
+    for (size_t w = 0; w < 6; ++w) {
+        cpus.push_back(topo.worker_cpu(w));
+        nodes.push_back(topo.worker_node(w));
+    }
+    ASSERT_EQ(std::vector<size_t>({ 0, 2, 1, 3, 0, 2 }), cpus);
+    ASSERT_EQ(std::vector<size_t>({ 0, 0, 1, 1, 0, 0 }), nodes);
+}
+
+TEST(NumaTopology, PhysicalCoresBeforeSiblings) {
+    // two nodes with two cores each, the cpus 4-7 are SMT siblings of 0-3.
+    common::NumaTopology topo(
+        { { 0, 1, 4, 5 }, { 2, 3, 6, 7 } }, { 0, 1 },
+        { 0, 0, 0, 0, 1, 1, 1, 1 });
+    ASSERT_EQ(8u, topo.num_cpus());
+
+    // all physical cores compactly by node, then the siblings
+    std::vector<size_t> cpus, nodes;
+    for (size_t w = 0; w < 8; ++w) {
+        cpus.push_back(topo.worker_cpu(w));
+        nodes.push_back(topo.worker_node(w));
+    }
+    ASSERT_EQ(std::vector<size_t>({ 0, 1, 2, 3, 4, 5, 6, 7 }), cpus);
+    ASSERT_EQ(std::vector<size_t>({ 0, 0, 1, 1, 0, 0, 1, 1 }), nodes);
+}
+
+TEST(NumaTopology, Detect) {
+    const common::NumaTopology& topo = common::NumaTopology::Get();
+    ASSERT_LE(1u, topo.num_nodes());
+    ASSERT_LE(1u, topo.num_cpus());
+    ASSERT_LT(topo.worker_node(0), topo.num_nodes());
+}
+
+/******************************************************************************/
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * tests/common/parallel_sort_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/parallel_sort.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace thrill;
+
+TEST(ParallelSort, RandomIntegers) {
+
+    std::default_random_engine rng(std::random_device { } ());
+    common::ThreadPool pool(4);
+
+    size_t test_size = 1000000 + rng() % 20480;
+    std::vector<size_t> vec;
+    vec.reserve(test_size);
+
+    for (size_t i = 0; i < test_size; ++i)
+        vec.emplace_back(rng() % 1000);
+
+    std::vector<size_t> check = vec;
+    std::sort(check.begin(), check.end());
+
+    common::parallel_sample_sort(
+        vec.begin(), vec.end(), std::less<size_t>(), pool);
+
+    ASSERT_EQ(check, vec);
+}
+
+TEST(ParallelSort, RandomStrings) {
+
+    std::default_random_engine rng(std::random_device { } ());
+    common::ThreadPool pool(4);
+
+    size_t test_size = 100000;
+    std::vector<std::string> vec;
+    vec.reserve(test_size);
+
+    for (size_t i = 0; i < test_size; ++i)
+        vec.emplace_back(std::to_string(rng()));
+
+    std::vector<std::string> check = vec;
+    std::sort(check.begin(), check.end());
+
+    // sort with descending comparator and small minimum parallel size
+    common::parallel_sample_sort(
+        vec.begin(), vec.end(), std::greater<std::string>(), pool, 1024);
+    std::reverse(vec.begin(), vec.end());
+
+    ASSERT_EQ(check, vec);
+}
+
+TEST(ParallelSort, SingleKey) {
+
+    common::ThreadPool pool(4);
+
+    std::vector<size_t> vec(100000, 42);
+    common::parallel_sample_sort(
+        vec.begin(), vec.end(), std::less<size_t>(), pool, 1024);
+
+    ASSERT_EQ(std::vector<size_t>(100000, 42), vec);
+}
+
+/******************************************************************************/
@@ -13,7 +13,9 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <array>
 #include <random>
+#include <utility>
 #include <vector>
 
 using namespace thrill;
@@ -51,4 +53,55 @@ TEST(RadixSort, RandomStrings) {
     ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
 }
 
+TEST(RadixSort, RandomIntegerKeys) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    size_t test_size = 1024000 + rng() % 20480;
+    std::vector<std::pair<int64_t, size_t> > vec;
+    vec.reserve(test_size);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        vec.emplace_back(
+            static_cast<int64_t>(rng()) - static_cast<int64_t>(rng()), i);
+    }
+
+    common::radix_sort_key(
+        vec.begin(), vec.end(),
+        [](const std::pair<int64_t, size_t>& p) { return p.first; });
+
+    ASSERT_TRUE(std::is_sorted(
+                    vec.begin(), vec.end(),
+                    [](const std::pair<int64_t, size_t>& a,
+                       const std::pair<int64_t, size_t>& b) {
+                        return a.first < b.first;
+                    }));
+}
+
+TEST(RadixSort, RandomByteStringKeys) {
+
+    std::default_random_engine rng(std::random_device { } ());
+
+    size_t test_size = 1024000 + rng() % 20480;
+    std::vector<MyString> vec;
+    vec.reserve(test_size);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        vec.emplace_back(MyString());
+        for (size_t j = 0; j < 16; ++j) {
+            vec.back().chars[j] = static_cast<uint8_t>(rng() % 4);
+        }
+    }
+
+    common::radix_sort_key(
+        vec.begin(), vec.end(),
+        [](const MyString& s) {
+            std::array<uint8_t, 16> key;
+            std::copy(s.chars, s.chars + 16, key.begin());
+            return key;
+        });
+
+    ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+}
+
 /******************************************************************************/
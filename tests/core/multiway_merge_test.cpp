@@ -11,8 +11,10 @@
 #include <gtest/gtest.h>
 
 #include <thrill/common/function_traits.hpp>
+#include <thrill/core/forecast_prefetcher.hpp>
 #include <thrill/core/multiway_merge.hpp>
 #include <thrill/core/multiway_merge_attic.hpp>
+#include <thrill/core/parallel_multiway_merge.hpp>
 #include <thrill/data/file.hpp>
 
 #include <thrill/common/logger.hpp>
@@ -133,4 +135,118 @@ TEST_F(MultiwayMerge, GetMultiwayMergePuller) {
     ASSERT_FALSE(puller.HasNext());
 }
 
+template <typename Type, typename Generator>
+void TestParallelMultiwayMerge(data::BlockPool& block_pool,
+                               size_t num_files, size_t num_parts,
+                               const Generator& generator) {
+    std::mt19937 gen(0);
+
+    std::vector<data::File> in;
+    std::vector<Type> ref;
+
+    for (size_t i = 0; i < num_files; ++i) {
+        // some files are empty
+        size_t size = (i % 3 == 2) ? 0 : gen() % 20000;
+        std::vector<Type> tmp;
+        for (size_t j = 0; j < size; ++j)
+            tmp.push_back(generator(gen));
+        std::sort(tmp.begin(), tmp.end());
+        ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+        data::File f(block_pool, 0, /* dia_id */ 0);
+        {
+            auto w = f.GetWriter();
+            for (auto& t : tmp) {
+                w.Put(t);
+            }
+        }
+        in.emplace_back(std::move(f));
+    }
+
+    std::sort(ref.begin(), ref.end());
+
+    common::ThreadPool pool(4);
+    core::ParallelMultiwayMergeTree<Type, std::less<Type> > puller(
+        in.begin(), in.end(), /* consume */ false, std::less<Type>(), pool,
+        num_parts,
+        block_pool, 0, /* dia_id */ 0);
+
+    for (size_t i = 0; i < ref.size(); ++i) {
+        ASSERT_TRUE(puller.HasNext());
+        ASSERT_EQ(ref[i], puller.Next());
+    }
+    ASSERT_FALSE(puller.HasNext());
+}
+
+TEST_F(MultiwayMerge, ParallelMergeIntegers) {
+    TestParallelMultiwayMerge<size_t>(
+        block_pool_, 8, 4, [](std::mt19937& gen) { return gen() % 1000; });
+}
+
+TEST_F(MultiwayMerge, ParallelMergeStrings) {
+    TestParallelMultiwayMerge<std::string>(
+        block_pool_, 5, 3, [](std::mt19937& gen) {
+            return std::to_string(gen() % 100000);
+        });
+}
+
+TEST_F(MultiwayMerge, ParallelMergeSingleKey) {
+    TestParallelMultiwayMerge<size_t>(
+        block_pool_, 4, 4, [](std::mt19937&) { return size_t(42); });
+}
+
+TEST_F(MultiwayMerge, ForecastPrefetch) {
+    std::mt19937 gen(0);
+
+    const size_t num_files = 7;
+    std::vector<data::File> in;
+    std::vector<std::vector<size_t> > triggers(num_files);
+    std::vector<size_t> ref;
+
+    for (size_t i = 0; i < num_files; ++i) {
+        size_t size = gen() % 5000;
+        std::vector<size_t> tmp;
+        for (size_t j = 0; j < size; ++j)
+            tmp.push_back(gen() % 100000);
+        std::sort(tmp.begin(), tmp.end());
+        ref.insert(ref.end(), tmp.begin(), tmp.end());
+
+        // write small Blocks and record the first item of each
+        data::File f(block_pool_, 0, /* dia_id */ 0);
+        {
+            auto w = f.GetWriter(256);
+            core::TriggerRecorder<size_t> recorder(f, triggers[i]);
+            for (auto& t : tmp) {
+                recorder.Put(w, t);
+            }
+            w.Close();
+            recorder.Finish();
+        }
+        ASSERT_EQ(f.num_blocks(), triggers[i].size());
+        in.emplace_back(std::move(f));
+    }
+
+    std::sort(ref.begin(), ref.end());
+
+    std::vector<data::File::ConsumeReader> seq;
+    std::vector<const std::vector<size_t>*> trigger_ptrs;
+    for (size_t i = 0; i < num_files; ++i) {
+        seq.emplace_back(in[i].GetConsumeReader(0));
+        trigger_ptrs.push_back(&triggers[i]);
+    }
+
+    core::ForecastPrefetcher<size_t, std::less<size_t> > forecast(
+        seq, trigger_ptrs, /* max_prefetch */ 4, std::less<size_t>());
+
+    auto puller = core::make_multiway_merge_tree<size_t>(
+        seq.begin(), seq.end(), std::less<size_t>());
+
+    for (size_t i = 0; i < ref.size(); ++i) {
+        ASSERT_TRUE(puller.HasNext());
+        ASSERT_EQ(ref[i], puller.Next());
+        forecast.Poll();
+    }
+    ASSERT_FALSE(puller.HasNext());
+}
+
 /******************************************************************************/
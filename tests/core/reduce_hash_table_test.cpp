@@ -12,6 +12,7 @@
 #include <thrill/core/reduce_bucket_hash_table.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 
 #include <thrill/core/reduce_pre_stage.hpp>
 
@@ -136,4 +137,11 @@ TEST(ReduceHashTable, ProbingAddIntegers) {
         });
 }
 
+TEST(ReduceHashTable, SwissAddIntegers) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructModulo<core::ReduceSwissHashTable>(ctx);
+        });
+}
+
 /******************************************************************************/
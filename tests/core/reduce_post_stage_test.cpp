@@ -10,6 +10,7 @@
 
 #include <thrill/core/reduce_by_hash_post_stage.hpp>
 #include <thrill/core/reduce_by_index_post_stage.hpp>
+#include <thrill/core/reduce_by_sort_post_stage.hpp>
 
 #include <gtest/gtest.h>
 
@@ -109,6 +110,190 @@ TEST(ReduceHashStage, ProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReduceHashStage, SwissAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
+//! reduce many distinct keys in little RAM, which requires recursive
+//! re-reducing of spilled partitions.
+template <core::ReduceTableImpl table_impl>
+static void TestManyKeysByHash(Context& ctx) {
+    static constexpr size_t mod_size = 20000;
+    static constexpr size_t test_size = 2 * mod_size;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    std::vector<MyStruct> result;
+
+    auto emit_fn = [&result](const MyStruct& in) {
+                       result.emplace_back(in);
+                   };
+
+    using Stage = core::ReduceByHashPostStage<
+              MyStruct, size_t, MyStruct,
+              decltype(key_ex), decltype(red_fn), decltype(emit_fn), false,
+              core::DefaultReduceConfigSelect<table_impl> >;
+
+    Stage stage(ctx, 0, key_ex, red_fn, emit_fn);
+    stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+
+    for (size_t i = 0; i < test_size; ++i) {
+        stage.Insert(MyStruct { i, i });
+    }
+
+    stage.PushData(/* consume */ true);
+
+    // spilled partitions of the first level fit into RAM on the second.
+    ASSERT_LE(1u, stage.max_spill_level());
+    ASSERT_GE(2u, stage.max_spill_level());
+
+    std::sort(result.begin(), result.end());
+
+    ASSERT_EQ(mod_size, result.size());
+    for (size_t i = 0; i < result.size(); ++i) {
+        ASSERT_EQ(i, result[i].key % mod_size);
+        ASSERT_EQ(2 * i + mod_size, result[i].value);
+    }
+}
+
+TEST(ReduceHashStage, ProbingManyKeysByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestManyKeysByHash<core::ReduceTableImpl::PROBING>(ctx);
+        });
+}
+
+TEST(ReduceHashStage, SwissManyKeysByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestManyKeysByHash<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
+//! hash function mapping all keys to the same value
+struct CollidingHash {
+    size_t operator () (const size_t& /* key */) const { return 42; }
+};
+
+//! reduce many distinct keys whose hash values all collide: re-reducing with
+//! new seeds cannot separate them, hence the stage must stop after
+//! max_spill_levels_ and reduce the remaining items by sorting.
+TEST(ReduceHashStage, ProbingCollidingHash) {
+    static constexpr size_t mod_size = 5000;
+    static constexpr size_t test_size = 2 * mod_size;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    api::RunLocalSameThread(
+        [&](Context& ctx) {
+            std::vector<MyStruct> result;
+
+            auto emit_fn = [&result](const MyStruct& in) {
+                               result.emplace_back(in);
+                           };
+
+            using Stage = core::ReduceByHashPostStage<
+                      MyStruct, size_t, MyStruct,
+                      decltype(key_ex), decltype(red_fn), decltype(emit_fn),
+                      false, core::DefaultReduceConfig,
+                      core::ReduceByHash<size_t, CollidingHash> >;
+
+            Stage stage(ctx, 0, key_ex, red_fn, emit_fn);
+            stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+
+            for (size_t i = 0; i < test_size; ++i) {
+                stage.Insert(MyStruct { i, i });
+            }
+
+            stage.PushData(/* consume */ true);
+
+            ASSERT_EQ(size_t(core::DefaultReduceConfig::max_spill_levels_),
+                      stage.max_spill_level());
+
+            // the reduce function keeps either key of a pair
+            std::sort(result.begin(), result.end(),
+                      [](const MyStruct& a, const MyStruct& b) {
+                          return a.key % mod_size < b.key % mod_size;
+                      });
+
+            ASSERT_EQ(mod_size, result.size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                ASSERT_EQ(i, result[i].key % mod_size);
+                ASSERT_EQ(2 * i + mod_size, result[i].value);
+            }
+        });
+}
+
+/******************************************************************************/
+
+TEST(ReduceSortStage, ManyKeysBySort) {
+    static constexpr size_t mod_size = 20000;
+    static constexpr size_t test_size = 4 * mod_size;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    api::RunLocalSameThread(
+        [&](Context& ctx) {
+            std::vector<MyStruct> result;
+
+            auto emit_fn = [&result](const MyStruct& in) {
+                               result.emplace_back(in);
+                           };
+
+            using Stage = core::ReduceBySortPostStage<
+                      MyStruct, size_t, MyStruct,
+                      decltype(key_ex), decltype(red_fn), decltype(emit_fn)>;
+
+            Stage stage(ctx, 0, key_ex, red_fn, emit_fn);
+            stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+
+            for (size_t i = 0; i < test_size; ++i) {
+                stage.Insert(MyStruct { i, i });
+            }
+
+            // the items do not fit into RAM, hence runs are merged and the
+            // second PushData() reads the cached output.
+            stage.PushData(/* consume */ false);
+            ASSERT_LT(1u, stage.num_runs());
+            stage.PushData(/* consume */ true);
+
+            ASSERT_EQ(2 * mod_size, result.size());
+            for (size_t i = 0; i < mod_size; ++i) {
+                // merged output is sorted by key
+                ASSERT_EQ(i, result[i].key % mod_size);
+                ASSERT_EQ(4 * i + 6 * mod_size, result[i].value);
+                ASSERT_EQ(result[i].value, result[mod_size + i].value);
+            }
+        });
+}
+
 /******************************************************************************/
 
 TEST(ReduceHashStage, PostReduceByIndex) {
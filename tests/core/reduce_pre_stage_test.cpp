@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <map>
 #include <utility>
 #include <vector>
 
@@ -126,6 +127,13 @@ TEST(ReducePreStage, ProbingAddMyStructByHash) {
         });
 }
 
+TEST(ReducePreStage, SwissAddMyStructByHash) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            TestAddMyStructByHash<core::ReduceTableImpl::SWISS>(ctx);
+        });
+}
+
 /******************************************************************************/
 
 template <core::ReduceTableImpl table_impl>
@@ -217,3 +225,156 @@ TEST(ReducePreStage, ProbingAddMyStructByIndex) {
 }
 
 /******************************************************************************/
+
+struct HotKeyReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_hot_key_detection_ = true;
+};
+
+//! reduce items of which every second has key 0 in a small table, check the
+//! result and return the number of items emitted for key 0.
+template <typename ReduceConfig>
+static size_t TestSkewedKeys(Context& ctx) {
+    static constexpr size_t mod_size = 601;
+    static constexpr size_t test_size = mod_size * 100;
+
+    auto key_ex = [](const MyStruct& in) {
+                      return in.key % mod_size;
+                  };
+
+    auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                      return MyStruct {
+                                 in1.key, in1.value + in2.value
+                      };
+                  };
+
+    const size_t num_partitions = 13;
+
+    std::vector<data::File> files;
+    for (size_t i = 0; i < num_partitions; ++i)
+        files.emplace_back(ctx.GetFile(nullptr));
+
+    std::vector<data::DynBlockWriter> emitters;
+    for (size_t i = 0; i < num_partitions; ++i)
+        emitters.emplace_back(files[i].GetDynWriter());
+
+    using Stage = core::ReducePreStage<
+              MyStruct, size_t, MyStruct,
+              decltype(key_ex), decltype(red_fn),
+              /* VolatileKey */ false, ReduceConfig>;
+
+    Stage stage(ctx, 0, num_partitions, key_ex, red_fn, emitters);
+
+    // small table, which is flushed many times.
+    stage.Initialize(/* limit_memory_bytes */ 16 * 1024);
+
+    std::map<size_t, size_t> check;
+    for (size_t i = 0; i < test_size; ++i) {
+        MyStruct item { i % 2 == 0 ? 0 : i, 1 };
+        ++check[key_ex(item)];
+        stage.Insert(item);
+    }
+
+    if (ReduceConfig::use_hot_key_detection_) {
+        EXPECT_EQ(1u, stage.num_hot_keys());
+    }
+
+    stage.FlushAll();
+    stage.CloseAll();
+
+    std::map<size_t, size_t> result;
+    size_t hot_key_items = 0;
+
+    for (size_t i = 0; i < num_partitions; ++i) {
+        data::File::Reader r = files[i].GetReader(/* consume */ true);
+        while (r.HasNext()) {
+            MyStruct item = r.Next<MyStruct>();
+            result[key_ex(item)] += item.value;
+            if (key_ex(item) == 0) ++hot_key_items;
+        }
+    }
+
+    EXPECT_EQ(check, result);
+    return hot_key_items;
+}
+
+TEST(ReducePreStage, HotKeyDetection) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            size_t plain = TestSkewedKeys<core::DefaultReduceConfig>(ctx);
+            size_t hot = TestSkewedKeys<HotKeyReduceConfig>(ctx);
+            // only items flushed before the detection remain.
+            ASSERT_LT(10 * hot, plain);
+        });
+}
+
+struct BypassReduceConfig : public core::DefaultReduceConfig {
+    static constexpr bool use_adaptive_bypass_ = true;
+};
+
+TEST(ReducePreStage, AdaptiveBypass) {
+    api::RunLocalSameThread(
+        [](Context& ctx) {
+            static constexpr size_t window = BypassReduceConfig::bypass_window_;
+            static constexpr size_t unique_size = 50 * window;
+            static constexpr size_t local_size = 50 * window;
+
+            auto key_ex = [](const MyStruct& in) { return in.key; };
+
+            auto red_fn = [](const MyStruct& in1, const MyStruct& in2) {
+                              return MyStruct {
+                                         in1.key, in1.value + in2.value
+                              };
+                          };
+
+            const size_t num_partitions = 13;
+
+            std::vector<data::File> files;
+            for (size_t i = 0; i < num_partitions; ++i)
+                files.emplace_back(ctx.GetFile(nullptr));
+
+            std::vector<data::DynBlockWriter> emitters;
+            for (size_t i = 0; i < num_partitions; ++i)
+                emitters.emplace_back(files[i].GetDynWriter());
+
+            using Stage = core::ReducePreStage<
+                      MyStruct, size_t, MyStruct,
+                      decltype(key_ex), decltype(red_fn),
+                      /* VolatileKey */ false, BypassReduceConfig>;
+
+            Stage stage(ctx, 0, num_partitions, key_ex, red_fn, emitters);
+            stage.Initialize(/* limit_memory_bytes */ 64 * 1024);
+
+            // first unique keys, which cannot be reduced, then few keys with
+            // high locality.
+            std::map<size_t, size_t> check;
+            for (size_t i = 0; i < unique_size + local_size; ++i) {
+                MyStruct item { i < unique_size ? i + 1000 : i % 10, 1 };
+                ++check[item.key];
+                stage.Insert(item);
+            }
+
+            // the unique keys are mostly bypassed, the local keys after the
+            // next measurement go into the table again.
+            ASSERT_LE(unique_size / 2, stage.num_bypassed());
+            ASSERT_GE(
+                unique_size +
+                (BypassReduceConfig::bypass_probe_interval_ + 1) * window,
+                stage.num_bypassed());
+
+            stage.FlushAll();
+            stage.CloseAll();
+
+            std::map<size_t, size_t> result;
+            for (size_t i = 0; i < num_partitions; ++i) {
+                data::File::Reader r = files[i].GetReader(/* consume */ true);
+                while (r.HasNext()) {
+                    MyStruct item = r.Next<MyStruct>();
+                    result[item.key] += item.value;
+                }
+            }
+
+            ASSERT_EQ(check, result);
+        });
+}
+
+/******************************************************************************/
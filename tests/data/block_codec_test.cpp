@@ -0,0 +1,73 @@
+/*******************************************************************************
+ * tests/data/block_codec_test.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <thrill/data/block_codec.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace thrill;
+
+static void TestRoundTrip(const std::vector<uint8_t>& input) {
+    std::vector<uint8_t> compressed(input.size() + input.size() / 64 + 16);
+    size_t csize = data::BlockCompress(
+        data::BlockCodec::LZ4, input.data(), input.size(),
+        compressed.data(), compressed.size());
+    ASSERT_LT(0u, csize);
+
+    std::vector<uint8_t> output(input.size());
+    size_t dsize = data::BlockDecompress(
+        data::BlockCodec::LZ4, compressed.data(), csize,
+        output.data(), output.size());
+    ASSERT_EQ(input.size(), dsize);
+    ASSERT_EQ(input, output);
+}
+
+TEST(BlockCodec, RoundTripSmall) {
+    for (size_t size = 0; size < 64; ++size) {
+        std::vector<uint8_t> input(size);
+        for (size_t i = 0; i < size; ++i)
+            input[i] = static_cast<uint8_t>(i % 3);
+        TestRoundTrip(input);
+    }
+}
+
+TEST(BlockCodec, CompressesSortedIntegers) {
+    std::vector<uint8_t> input(64 * 1024);
+    uint64_t* items = reinterpret_cast<uint64_t*>(input.data());
+    for (size_t i = 0; i < input.size() / sizeof(uint64_t); ++i)
+        items[i] = i / 4;
+
+    std::vector<uint8_t> compressed(input.size());
+    size_t csize = data::BlockCompress(
+        data::BlockCodec::LZ4, input.data(), input.size(),
+        compressed.data(), compressed.size());
+    ASSERT_LT(0u, csize);
+    ASSERT_GT(input.size() / 2, csize);
+
+    TestRoundTrip(input);
+}
+
+TEST(BlockCodec, LongRunsAndRandomData) {
+    std::default_random_engine rng(std::random_device { } ());
+
+    std::vector<uint8_t> input(256 * 1024);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = (i / 10000) % 2 ? static_cast<uint8_t>(rng()) : 42;
+    TestRoundTrip(input);
+
+    // random data does not fit into its own size
+    for (uint8_t& b : input) b = static_cast<uint8_t>(rng());
+    std::vector<uint8_t> compressed(input.size());
+    ASSERT_EQ(0u, data::BlockCompress(
+                  data::BlockCodec::LZ4, input.data(), input.size(),
+                  compressed.data(), compressed.size()));
+}
+
+/******************************************************************************/
@@ -11,8 +11,11 @@
 #include <gtest/gtest.h>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
+#include <thrill/data/eviction_policy.hpp>
 
+#include <memory>
 #include <string>
+#include <vector>
 
 using namespace thrill;
 
@@ -109,4 +112,136 @@ TEST_F(BlockPoolTest, EvictBlock) {
     ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
 }
 
+TEST_F(BlockPoolTest, EvictCompressedBlock) {
+    static constexpr size_t size = 64 * 1024;
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(size, 0);
+        for (size_t i = 0; i < size; ++i)
+            block->begin()[i] = static_cast<data::Byte>((i / 16) % 7);
+        block->set_codec(data::BlockCodec::LZ4);
+        data::PinnedBlock pinned_block(std::move(block), 0, size, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    // evict block, which is compressed while written
+    block_pool_.EvictBlock(unpinned_block.byte_block().get());
+    ASSERT_EQ(1u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
+    // swap block back in by pinning it, which decompresses it.
+    data::PinnedBlock pinned = unpinned_block.PinWait(0);
+    ASSERT_EQ(0u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(static_cast<data::Byte>((i / 16) % 7),
+                  pinned.data_begin()[i]);
+    }
+}
+
+
+TEST_F(BlockPoolTest, CostAwareEvictionPolicy) {
+    std::vector<data::PinnedByteBlockPtr> blocks;
+    for (size_t i = 0; i < 5; ++i)
+        blocks.emplace_back(block_pool_.AllocateByteBlock(4096, 0));
+
+    blocks[0]->set_eviction_hint(data::EvictionHint::WillReread);
+    blocks[3]->set_eviction_hint(data::EvictionHint::ConsumeOnce);
+    blocks[4]->set_eviction_hint(data::EvictionHint::Hot);
+
+    data::CostAwareEvictionPolicy policy;
+    for (size_t i = 0; i < 5; ++i)
+        policy.Put(blocks[i].get());
+    ASSERT_EQ(5u, policy.size());
+
+    policy.Erase(blocks[2].get());
+    ASSERT_FALSE(policy.Exists(blocks[2].get()));
+    policy.Put(blocks[2].get());
+
+    // Default and ConsumeOnce blocks age faster than WillReread and Hot ones,
+    // hence the oldest block 0 is evicted after the more recent blocks 1 and 3.
+    ASSERT_EQ(blocks[1].get(), policy.Pop());
+    ASSERT_EQ(blocks[3].get(), policy.Pop());
+    ASSERT_EQ(blocks[0].get(), policy.Pop());
+    ASSERT_EQ(blocks[2].get(), policy.Pop());
+    ASSERT_EQ(blocks[4].get(), policy.Pop());
+    ASSERT_EQ(0u, policy.size());
+}
+
+TEST_F(BlockPoolTest, SetEvictionPolicy) {
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    ASSERT_EQ(1u, block_pool_.unpinned_blocks());
+    block_pool_.set_eviction_policy(
+        std::make_unique<data::LruEvictionPolicy>());
+    ASSERT_EQ(1u, block_pool_.unpinned_blocks());
+    block_pool_.EvictNextBlock();
+    ASSERT_EQ(0u, block_pool_.unpinned_blocks());
+    ASSERT_EQ(1u, block_pool_.writing_blocks() + block_pool_.swapped_blocks());
+}
+
+TEST_F(BlockPoolTest, ReuseFreedDataOnSameNode) {
+    block_pool_.set_worker_numa_node(0, 1);
+    ASSERT_EQ(1u, block_pool_.worker_numa_node(0));
+
+    const data::Byte* first;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        first = block->data();
+    }
+    {
+        // freed memory of node 1 is reused by the worker on node 1
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        ASSERT_EQ(first, block->data());
+    }
+    {
+        // but not for Blocks placed on another node
+        data::PinnedByteBlockPtr block =
+            block_pool_.AllocateByteBlock(4096, 0, 0);
+        ASSERT_NE(first, block->data());
+    }
+}
+
+TEST_F(BlockPoolTest, ReadAheadWindow) {
+    // without measured reads, read ahead one Block
+    ASSERT_EQ(1u, block_pool_.ReadAheadWindow(4096, 1e-6));
+
+    data::Block unpinned_block;
+    {
+        data::PinnedByteBlockPtr block = block_pool_.AllocateByteBlock(4096, 0);
+        data::PinnedBlock pinned_block(std::move(block), 0, 4096, 0, 0, false);
+        unpinned_block = pinned_block.ToBlock();
+    }
+    block_pool_.EvictBlock(unpinned_block.byte_block().get());
+    // wait for the write, such that pinning reads the Block back.
+    while (io::RequestPtr req = block_pool_.GetAnyWriting())
+        req->wait();
+    data::PinnedBlock pinned = unpinned_block.PinWait(0);
+
+    double latency = block_pool_.read_latency();
+    ASSERT_LT(0, latency);
+
+    // a reader consuming Blocks eight times faster than they are read needs
+    // about eight Blocks in flight, a slow reader only one.
+    size_t window = block_pool_.ReadAheadWindow(4096, latency / 8);
+    ASSERT_GE(window, 8u);
+    ASSERT_LE(window, 9u);
+    ASSERT_EQ(1u, block_pool_.ReadAheadWindow(4096, 2 * latency));
+    ASSERT_EQ(size_t(data::BlockPool::max_read_ahead),
+              block_pool_.ReadAheadWindow(4096, 0));
+}
+
+TEST(BlockPool, ReadAheadWindowMemoryLimit) {
+    data::BlockPool block_pool(64 * 1024, 64 * 1024, nullptr, nullptr, 1);
+
+    // a quarter of the unpinned memory may be read ahead
+    ASSERT_EQ(4u, block_pool.ReadAheadWindow(4096, 0));
+    {
+        data::PinnedByteBlockPtr block =
+            block_pool.AllocateByteBlock(32 * 1024, 0);
+        ASSERT_EQ(2u, block_pool.ReadAheadWindow(4096, 0));
+    }
+    ASSERT_EQ(4u, block_pool.ReadAheadWindow(4096, 0));
+}
+
 /******************************************************************************/
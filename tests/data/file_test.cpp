@@ -247,6 +247,32 @@ TEST_F(File, SerializeSomeItemsConsumeReader) {
     ASSERT_EQ(0u, file.num_items());
 }
 
+TEST_F(File, ReadEvictedFileWithReadAhead) {
+    static constexpr size_t size = 100000;
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    {
+        data::File::Writer fw = file.GetWriter(4096);
+        for (size_t i = 0; i < size; ++i)
+            fw.Put<size_t>(i);
+    }
+
+    // read twice, once keeping and once consuming the File.
+    for (bool consume : { false, true }) {
+        // evict all Blocks, such that the reader must read ahead from disk.
+        for (size_t b = 0; b < file.num_blocks(); ++b)
+            block_pool_.EvictBlock(file.block(b).byte_block().get());
+
+        data::File::Reader fr = file.GetReader(consume);
+        for (size_t i = 0; i < size; ++i) {
+            ASSERT_TRUE(fr.HasNext());
+            ASSERT_EQ(i, fr.Next<size_t>());
+        }
+        ASSERT_FALSE(fr.HasNext());
+    }
+    ASSERT_TRUE(file.empty());
+}
+
 TEST_F(File, RandomGetIndexOf) {
     static constexpr size_t size = 500;
 
@@ -330,14 +356,20 @@ TEST_F(File, TieGetIndexOfWithDuplicates) {
     }
 }
 
-TEST_F(File, SeekReadSlicesOfFiles) {
+template <data::IntegerEncoding Encoding>
+void SeekReadSlicesOfFiles(data::BlockPool& block_pool_) {
     static constexpr bool debug = false;
 
+    using Writer = data::BlockWriter<data::File, Encoding>;
+    using KeepReader = data::BlockReader<data::KeepFileBlockSource, Encoding>;
+    using ConsumeReader =
+              data::BlockReader<data::ConsumeBlockQueueSource, Encoding>;
+
     // construct a small-block File with lots of items.
     data::File file(block_pool_, 0, /* dia_id */ 0);
 
     // yes, this is a prime number as block size. -tb
-    data::File::Writer fw = file.GetWriter(/* block_size */ 53);
+    Writer fw(file.GetWriter(/* block_size */ 53));
     for (size_t i = 0; i < 1000; ++i) {
         fw.Put(i);
     }
@@ -346,10 +378,10 @@ TEST_F(File, SeekReadSlicesOfFiles) {
     ASSERT_EQ(1000u, file.num_items());
 
     // read complete File
-    data::File::KeepReader fr = file.GetKeepReader();
+    KeepReader fr(file.GetKeepReader());
     for (size_t i = 0; i < 1000; ++i) {
         ASSERT_TRUE(fr.HasNext());
-        ASSERT_EQ(i, fr.Next<size_t>());
+        ASSERT_EQ(i, fr.template Next<size_t>());
     }
     ASSERT_FALSE(fr.HasNext());
 
@@ -359,13 +391,13 @@ TEST_F(File, SeekReadSlicesOfFiles) {
             LOG << "Test range [" << begin << "," << end << ")";
 
             // seek in File to begin.
-            data::File::KeepReader fr = file.GetReaderAt<size_t>(begin);
+            KeepReader fr = file.GetReaderAt<size_t, Encoding>(begin);
 
             // read a few items
             if (end - begin > 5 && !at_end) {
                 for (size_t i = 0; i < 5; ++i) {
                     ASSERT_TRUE(fr.HasNext());
-                    ASSERT_EQ(begin, fr.Next<size_t>());
+                    ASSERT_EQ(begin, fr.template Next<size_t>());
                     ++begin;
                 }
             }
@@ -375,7 +407,7 @@ TEST_F(File, SeekReadSlicesOfFiles) {
             // read the items [begin,end)
             {
                 std::vector<data::Block> blocks
-                    = fr.GetItemBatch<size_t>(end - begin);
+                    = fr.template GetItemBatch<size_t>(end - begin);
 
                 LOG << "GetItemBatch -> " << blocks.size() << " blocks";
 
@@ -388,12 +420,12 @@ TEST_F(File, SeekReadSlicesOfFiles) {
                     queue.AppendPinnedBlock(b.PinWait(0));
                 queue.Close();
 
-                data::BlockQueue::ConsumeReader qr = queue.GetConsumeReader(0);
+                ConsumeReader qr(queue.GetConsumeReader(0));
 
                 for (size_t i = begin; i < end; ++i) {
                     ASSERT_TRUE(qr.HasNext());
                     sLOG << "index" << i;
-                    ASSERT_EQ(i, qr.Next<size_t>());
+                    ASSERT_EQ(i, qr.template Next<size_t>());
                 }
                 ASSERT_FALSE(qr.HasNext());
             }
@@ -406,7 +438,7 @@ TEST_F(File, SeekReadSlicesOfFiles) {
             // read the items [end, end + more)
             {
                 std::vector<data::Block> blocks
-                    = fr.GetItemBatch<size_t>(more);
+                    = fr.template GetItemBatch<size_t>(more);
 
                 data::BlockQueue queue(block_pool_, 0, /* dia_id */ 0);
 
@@ -414,11 +446,11 @@ TEST_F(File, SeekReadSlicesOfFiles) {
                     queue.AppendPinnedBlock(b.PinWait(0));
                 queue.Close();
 
-                data::BlockQueue::ConsumeReader qr = queue.GetConsumeReader(0);
+                ConsumeReader qr(queue.GetConsumeReader(0));
 
                 for (size_t i = end; i < end + more; ++i) {
                     ASSERT_TRUE(qr.HasNext());
-                    ASSERT_EQ(i, qr.Next<size_t>());
+                    ASSERT_EQ(i, qr.template Next<size_t>());
                 }
                 ASSERT_FALSE(qr.HasNext());
             }
@@ -441,6 +473,50 @@ TEST_F(File, SeekReadSlicesOfFiles) {
     check_range(1000, 1000, true);
 }
 
+TEST_F(File, SeekReadSlicesOfFiles) {
+    SeekReadSlicesOfFiles<data::IntegerEncoding::None>(block_pool_);
+}
+
+TEST_F(File, SeekReadSlicesOfEncodedFiles) {
+    SeekReadSlicesOfFiles<data::IntegerEncoding::FrameOfReference>(
+        block_pool_);
+}
+
+TEST_F(File, EncodedIntegerPairs) {
+    static constexpr size_t size = 100000;
+
+    static constexpr auto Encoding = data::IntegerEncoding::FrameOfReference;
+
+    data::File file(block_pool_, 0, /* dia_id */ 0);
+    {
+        data::BlockWriter<data::File, Encoding> fw(file.GetWriter(4096));
+        for (size_t i = 0; i < size; ++i)
+            fw.Put(std::make_pair(1000000000000 + 3 * i, (i * 7) % 100));
+    }
+
+    ASSERT_EQ(size, file.num_items());
+    // the two 8-byte integers are encoded in at most five bytes
+    const size_t typecode_size =
+        data::File::Writer::self_verify ? sizeof(size_t) : 0;
+    ASSERT_GE(size * (5 + typecode_size), file.size_bytes());
+
+    using Pair = std::pair<size_t, size_t>;
+
+    data::BlockReader<data::KeepFileBlockSource, Encoding> fr(
+        file.GetKeepReader());
+    for (size_t i = 0; i < size; ++i) {
+        ASSERT_TRUE(fr.HasNext());
+        ASSERT_EQ(Pair(1000000000000 + 3 * i, (i * 7) % 100), fr.Next<Pair>());
+    }
+    ASSERT_FALSE(fr.HasNext());
+
+    // random access via per-block bases
+    for (size_t i = 0; i < size; i += 997) {
+        Pair p = file.GetItemAt<Pair, Encoding>(i);
+        ASSERT_EQ(Pair(1000000000000 + 3 * i, (i * 7) % 100), p);
+    }
+}
+
 //! A derivative of File which only contains a limited amount of Blocks
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -36,6 +36,8 @@ struct MultiplexerHeaderTest : public ::testing::Test {
         candidate.size = 4;
         candidate.num_items = 5;
         candidate.sender_worker = 6;
+        candidate.codec = data::BlockCodec::LZ4;
+        candidate.raw_size = 7;
     }
 
     data::StreamMultiplexerHeader candidate;
@@ -54,6 +56,9 @@ TEST_F(MultiplexerHeaderTest, ParsesAndSerializesHeader) {
     ASSERT_EQ(candidate.size, result.size);
     ASSERT_EQ(candidate.num_items, result.num_items);
     ASSERT_EQ(candidate.sender_worker, result.sender_worker);
+    ASSERT_EQ(candidate.codec, result.codec);
+    ASSERT_EQ(candidate.raw_size, result.raw_size);
+    ASSERT_EQ(size_t(data::MultiplexerHeader::total_size), b.size());
 }
 
 TEST_F(MultiplexerHeaderTest, HeaderIsEnd) {
@@ -161,7 +166,8 @@ struct Multiplexer : public ::testing::Test {
 
 // open a Stream via data::Multiplexer, and send a short message to all workers,
 // receive and check the message.
-void TalkAllToAllViaCatStream(net::Group* net) {
+void TalkAllToAllViaCatStreamWithCodec(
+    net::Group* net, data::BlockCodec codec) {
     common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
 
     unsigned char send_buffer[123];
@@ -183,9 +189,11 @@ void TalkAllToAllViaCatStream(net::Group* net) {
 
         // open Writers and send a message to all workers
 
-        auto writers = multiplexer.GetOrCreateCatStream(
-            id, my_local_worker_id, /* dia_id */ 0)
-                       ->GetWriters(test_block_size);
+        data::CatStreamPtr stream = multiplexer.GetOrCreateCatStream(
+            id, my_local_worker_id, /* dia_id */ 0);
+        stream->set_codec(codec);
+
+        auto writers = stream->GetWriters(test_block_size);
 
         for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
             writers[tgt].Put("hello I am " + std::to_string(net->my_host_rank())
@@ -229,6 +237,14 @@ void TalkAllToAllViaCatStream(net::Group* net) {
     }
 }
 
+void TalkAllToAllViaCatStream(net::Group* net) {
+    TalkAllToAllViaCatStreamWithCodec(net, data::BlockCodec::None);
+}
+
+void TalkAllToAllViaCompressedCatStream(net::Group* net) {
+    TalkAllToAllViaCatStreamWithCodec(net, data::BlockCodec::LZ4);
+}
+
 TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     // test for all network mesh sizes 1, 2, 5, 9:
     net::RunLoopbackGroupTest(1, TalkAllToAllViaCatStream);
@@ -237,6 +253,63 @@ TEST_F(Multiplexer, TalkAllToAllViaCatStreamForManyNetSizes) {
     net::RunLoopbackGroupTest(9, TalkAllToAllViaCatStream);
 }
 
+// send encoded integers to all workers, with and without a Block codec.
+void TalkAllToAllViaIntegerEncodedCatStream(net::Group* net) {
+    common::NameThisThread("chmp" + mem::to_string(net->my_host_rank()));
+
+    static constexpr size_t items = 10000;
+    static constexpr auto Encoding = data::IntegerEncoding::FrameOfReference;
+    size_t my_local_worker_id = 0;
+    size_t num_workers_per_host = 1;
+
+    mem::Manager mem_manager(nullptr, "Benchmark");
+    data::BlockPool block_pool;
+    data::Multiplexer multiplexer(mem_manager, block_pool, num_workers_per_host, *net);
+
+    for (data::BlockCodec codec :
+         { data::BlockCodec::None, data::BlockCodec::LZ4 })
+    {
+        data::StreamId id = multiplexer.AllocateCatStreamId(my_local_worker_id);
+
+        data::CatStreamPtr stream = multiplexer.GetOrCreateCatStream(
+            id, my_local_worker_id, /* dia_id */ 0);
+        stream->set_codec(codec);
+
+        auto writers = stream->GetWriters(test_block_size);
+
+        for (size_t tgt = 0; tgt != writers.size(); ++tgt) {
+            data::BlockWriter<data::BlockSink, Encoding> writer(
+                std::move(writers[tgt]));
+            for (size_t i = 0; i < items; ++i)
+                writer.Put(net->my_host_rank() * 1000000000000 + 5 * i);
+            writer.Close();
+        }
+
+        auto readers = stream->GetReaders();
+
+        for (size_t src = 0; src != readers.size(); ++src) {
+            data::BlockReader<data::CatStream::BlockQueueSource, Encoding>
+            reader(std::move(readers[src]));
+            for (size_t i = 0; i < items; ++i) {
+                ASSERT_TRUE(reader.HasNext());
+                ASSERT_EQ(src * 1000000000000 + 5 * i,
+                          reader.Next<size_t>());
+            }
+            ASSERT_FALSE(reader.HasNext());
+        }
+    }
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaIntegerEncodedCatStream) {
+    net::RunLoopbackGroupTest(1, TalkAllToAllViaIntegerEncodedCatStream);
+    net::RunLoopbackGroupTest(3, TalkAllToAllViaIntegerEncodedCatStream);
+}
+
+TEST_F(Multiplexer, TalkAllToAllViaCompressedCatStream) {
+    net::RunLoopbackGroupTest(2, TalkAllToAllViaCompressedCatStream);
+    net::RunLoopbackGroupTest(5, TalkAllToAllViaCompressedCatStream);
+}
+
 TEST_F(Multiplexer, ReadCompleteCatStream) {
     auto w0 =
         [](data::Multiplexer& multiplexer) {
@@ -43,6 +43,9 @@ public:
         : Super(parent.ctx(), "Cache", { parent.id() }, { parent.node() }),
           parent_stack_empty_(ParentDIA::stack_empty) {
 
+        // cached data is read again by each consumer
+        file_.set_eviction_hint(data::EvictionHint::WillReread);
+
         auto save_fn = [this](const ValueType& input) {
                            writer_.Put(input);
                        };
@@ -54,6 +57,7 @@ public:
         if (!parent_stack_empty_) return false;
         assert(file_.num_items() == 0);
         file_ = file.Copy();
+        file_.set_eviction_hint(data::EvictionHint::WillReread);
         return true;
     }
 
@@ -16,6 +16,7 @@
 #include <thrill/common/linux_proc_stats.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/common/profile_thread.hpp>
 #include <thrill/common/string.hpp>
@@ -129,10 +130,16 @@ RunLoopbackThreads(
     // launch thread for each of the workers on this host.
     std::vector<std::thread> threads(num_hosts * workers_per_host);
 
+    // pin consecutive workers compactly to NUMA nodes, such that the workers
+    // of a host share a node if possible, and place their Blocks there.
+    const common::NumaTopology& topology = common::NumaTopology::Get();
+
     for (size_t host = 0; host < num_hosts; ++host) {
         mem::by_string log_prefix = "host " + mem::to_string(host);
         for (size_t worker = 0; worker < workers_per_host; ++worker) {
             size_t id = host * workers_per_host + worker;
+            host_contexts[host]->block_pool().set_worker_numa_node(
+                worker, topology.worker_node(id));
             threads[id] = common::CreateThread(
                 [&host_contexts, &job_startpoint, host, worker, log_prefix] {
                     Context ctx(*host_contexts[host], worker);
@@ -141,7 +148,7 @@ RunLoopbackThreads(
 
                     ctx.Launch(job_startpoint);
                 });
-            common::SetCpuAffinity(threads[id], id);
+            common::SetCpuAffinity(threads[id], topology.worker_cpu(id));
         }
     }
 
@@ -476,7 +483,12 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
     std::vector<std::thread> threads(workers_per_host);
 
+    // pin workers compactly to NUMA nodes, and place their Blocks there.
+    const common::NumaTopology& topology = common::NumaTopology::Get();
+
     for (size_t worker = 0; worker < workers_per_host; worker++) {
+        host_context.block_pool().set_worker_numa_node(
+            worker, topology.worker_node(worker));
         threads[worker] = common::CreateThread(
             [&host_context, &job_startpoint, worker] {
                 Context ctx(host_context, worker);
@@ -484,7 +496,7 @@ int RunBackendTcp(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        common::SetCpuAffinity(threads[worker], topology.worker_cpu(worker));
     }
 
     // join worker threads
@@ -560,7 +572,12 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
     // launch worker threads
     std::vector<std::thread> threads(workers_per_host);
 
+    // pin workers compactly to NUMA nodes, and place their Blocks there.
+    const common::NumaTopology& topology = common::NumaTopology::Get();
+
     for (size_t worker = 0; worker < workers_per_host; worker++) {
+        host_context.block_pool().set_worker_numa_node(
+            worker, topology.worker_node(worker));
         threads[worker] = common::CreateThread(
             [&host_context, &job_startpoint, worker] {
                 Context ctx(host_context, worker);
@@ -569,7 +586,7 @@ int RunBackendMpi(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        common::SetCpuAffinity(threads[worker], topology.worker_cpu(worker));
     }
 
     // join worker threads
@@ -645,7 +662,12 @@ int RunBackendIb(const std::function<void(Context&)>& job_startpoint) {
     // launch worker threads
     std::vector<std::thread> threads(workers_per_host);
 
+    // pin workers compactly to NUMA nodes, and place their Blocks there.
+    const common::NumaTopology& topology = common::NumaTopology::Get();
+
     for (size_t worker = 0; worker < workers_per_host; worker++) {
+        host_context.block_pool().set_worker_numa_node(
+            worker, topology.worker_node(worker));
         threads[worker] = common::CreateThread(
             [&host_context, &job_startpoint, worker] {
                 Context ctx(host_context, worker);
@@ -654,7 +676,7 @@ int RunBackendIb(const std::function<void(Context&)>& job_startpoint) {
 
                 ctx.Launch(job_startpoint);
             });
-        common::SetCpuAffinity(threads[worker], worker);
+        common::SetCpuAffinity(threads[worker], topology.worker_cpu(worker));
     }
 
     // join worker threads
@@ -981,6 +1003,17 @@ std::string HostContext::MakeHostLogPath(size_t host_rank) {
     return output + "-host-" + std::to_string(host_rank) + ".json";
 }
 
+common::ThreadPool& HostContext::thread_pool() {
+    std::unique_lock<std::mutex> lock(thread_pool_mutex_);
+    if (!thread_pool_) {
+        // use all cores, but at least one thread per worker
+        size_t num_threads = std::max<size_t>(
+            std::thread::hardware_concurrency(), workers_per_host_);
+        thread_pool_ = std::make_unique<common::ThreadPool>(num_threads);
+    }
+    return *thread_pool_;
+}
+
 /******************************************************************************/
 // Context methods
 
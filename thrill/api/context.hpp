@@ -18,6 +18,7 @@
 #include <thrill/common/defines.hpp>
 #include <thrill/common/json_logger.hpp>
 #include <thrill/common/profile_task.hpp>
+#include <thrill/common/thread_pool.hpp>
 #include <thrill/data/block_pool.hpp>
 #include <thrill/data/cat_stream.hpp>
 #include <thrill/data/file.hpp>
@@ -29,9 +30,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <exception>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace thrill {
@@ -132,6 +138,46 @@ public:
     //! data multiplexer transmits large amounts of data asynchronously.
     data::Multiplexer& data_multiplexer() { return data_multiplexer_; }
 
+    //! host-wide thread pool shared by all workers, e.g. for parallel local
+    //! sorting. The threads are started on first use.
+    common::ThreadPool& thread_pool();
+
+    /*!
+     * Returns an object shared by all workers of this host. Exactly one worker
+     * calls this method with build = true and constructs the object using
+     * make(), which must return a std::shared_ptr<Type>, all other workers wait
+     * until they receive the same object. The object is constructed outside the
+     * host-wide lock, hence other ids are not blocked. The id must be the same
+     * on all workers, e.g. a DIA id, and each worker must call this method
+     * exactly once per id, since the entry is removed once all workers have
+     * received the object.
+     */
+    template <typename Type, typename MakeFunction>
+    std::shared_ptr<Type> GetHostShared(
+        size_t id, bool build, const MakeFunction& make) {
+        std::promise<std::shared_ptr<void> > promise;
+        std::shared_future<std::shared_ptr<void> > future;
+        {
+            std::unique_lock<std::mutex> lock(host_shared_mutex_);
+            HostShared& entry = host_shared_[id];
+            if (build)
+                promise = std::move(entry.promise);
+            future = entry.future;
+            if (++entry.count == workers_per_host_)
+                host_shared_.erase(id);
+        }
+
+        if (build) {
+            try {
+                promise.set_value(make());
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+        return std::static_pointer_cast<Type>(future.get());
+    }
+
 private:
     //! memory configuration
     MemoryConfig mem_config_;
@@ -196,6 +242,30 @@ private:
         mem_manager_, block_pool_, workers_per_host_,
         net_manager_.GetDataGroup()
     };
+
+    //! mutex protecting the lazy construction of thread_pool_
+    std::mutex thread_pool_mutex_;
+
+    //! host-wide thread pool, constructed on first use by thread_pool().
+    std::unique_ptr<common::ThreadPool> thread_pool_;
+
+    //! object shared among the workers by GetHostShared()
+    struct HostShared {
+        //! promise fulfilled by the worker constructing the object
+        std::promise<std::shared_ptr<void> > promise;
+        //! the shared object, once it is constructed
+        std::shared_future<std::shared_ptr<void> > future {
+            promise.get_future().share()
+        };
+        //! number of workers which called GetHostShared()
+        size_t count = 0;
+    };
+
+    //! mutex protecting host_shared_
+    std::mutex host_shared_mutex_;
+
+    //! objects shared among the workers, removed once all received them.
+    std::unordered_map<size_t, HostShared> host_shared_;
 };
 
 /*!
@@ -210,7 +280,8 @@ class Context
 {
 public:
     Context(HostContext& host_context, size_t local_worker_id)
-        : local_host_id_(host_context.local_host_id()),
+        : host_context_(host_context),
+          local_host_id_(host_context.local_host_id()),
           local_worker_id_(local_worker_id),
           workers_per_host_(host_context.workers_per_host()),
           mem_limit_(host_context.worker_mem_limit()),
@@ -330,6 +401,18 @@ public:
     //! the block manager keeps all data blocks moving through the system.
     data::BlockPool& block_pool() { return block_pool_; }
 
+    //! host-wide thread pool shared by all workers on this host. Can be used
+    //! to parallelize local work, e.g. with common::ParallelSampleSort.
+    common::ThreadPool& thread_pool() { return host_context_.thread_pool(); }
+
+    //! Returns an object shared by all workers on this host, constructed by
+    //! local worker 0. See HostContext::GetHostShared().
+    template <typename Type, typename MakeFunction>
+    std::shared_ptr<Type> GetHostShared(size_t id, const MakeFunction& make) {
+        return host_context_.GetHostShared<Type>(
+            id, local_worker_id_ == 0, make);
+    }
+
     //! \}
 
     //! host-global memory config
@@ -391,6 +474,9 @@ public:
     size_t next_dia_id() { return ++last_dia_id_; }
 
 private:
+    //! reference to the HostContext shared by all workers of this host
+    HostContext& host_context_;
+
     //! id among all _local_ hosts (in test program runs)
     size_t local_host_id_;
 
@@ -76,6 +76,30 @@ struct NoRebalanceTag {
 //! global const PadTag instance
 const struct NoRebalanceTag NoRebalanceTag;
 
+//! tag structure for InnerJoin()
+struct BroadcastTag {
+    BroadcastTag() { }
+};
+
+//! global const BroadcastTag instance
+const struct BroadcastTag BroadcastTag;
+
+//! tag structure for GroupByKey()
+struct SplitGroupsTag {
+    SplitGroupsTag() { }
+};
+
+//! global const SplitGroupsTag instance
+const struct SplitGroupsTag SplitGroupsTag;
+
+//! tag structure for GroupByKey()
+struct LocalCombineTag {
+    LocalCombineTag() { }
+};
+
+//! global const LocalCombineTag instance
+const struct LocalCombineTag LocalCombineTag;
+
 /*!
  * DIA is the interface between the user and the Thrill framework. A DIA can be
  * imagined as an immutable array, even though the data does not need to be
@@ -814,13 +838,66 @@ public:
      * buckets are grouped and processed.
      *      input param: api::GroupByReader with functions HasNext() and Next()
      *
+     * \param groupby_config GroupBy configuration, selects between grouping by
+     * sorting, which delivers the groups in key order and requires operator <
+     * on the key, and grouping in a hash table, which only requires a hash
+     * function and operator ==.
+     *
      * \ingroup dia_dops
      */
     template <typename ValueOut, typename KeyExtractor,
               typename GroupByFunction, typename HashFunction =
-                  std::hash<typename FunctionTraits<KeyExtractor>::result_type> >
+                  std::hash<typename FunctionTraits<KeyExtractor>::result_type>,
+              typename GroupByConfig = class DefaultGroupByConfig>
     auto GroupByKey(const KeyExtractor &key_extractor,
-                    const GroupByFunction &groupby_function) const;
+                    const GroupByFunction &groupby_function,
+                    const GroupByConfig& groupby_config = GroupByConfig()) const;
+
+    /*!
+     * GroupByKey variant which splits heavy groups across all workers. Groups
+     * larger than a fraction of the average number of items per worker are
+     * detected from a sample, and their items are spread over all workers
+     * instead of sent to one. The groupby_function is applied to each part of
+     * a heavy group, and the partial results are merged with the associative
+     * combine_function. Groups are delivered in no particular order.
+     *
+     * \param combine_function Function merging two partial results of the
+     * same group: ValueOut (ValueOut, ValueOut).
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ValueOut, typename KeyExtractor,
+              typename GroupByFunction, typename CombineFunction,
+              typename HashFunction =
+                  std::hash<typename FunctionTraits<KeyExtractor>::result_type>,
+              typename GroupByConfig = class DefaultGroupByConfig>
+    auto GroupByKey(struct SplitGroupsTag,
+                    const KeyExtractor &key_extractor,
+                    const GroupByFunction &groupby_function,
+                    const CombineFunction &combine_function,
+                    const GroupByConfig& groupby_config = GroupByConfig()) const;
+
+    /*!
+     * GroupByKey variant which combines items with equal keys in a small hash
+     * table before they are sent, like the pre-stage of ReduceByKey. The
+     * groupby_function hence receives partially combined items, which cuts the
+     * communication volume if the group function is a fold.
+     *
+     * \param local_combine_function Associative function merging two items of
+     * the same key into one: ValueType (ValueType, ValueType).
+     *
+     * \ingroup dia_dops
+     */
+    template <typename ValueOut, typename KeyExtractor,
+              typename GroupByFunction, typename LocalCombineFunction,
+              typename HashFunction =
+                  std::hash<typename FunctionTraits<KeyExtractor>::result_type>,
+              typename GroupByConfig = class DefaultGroupByConfig>
+    auto GroupByKey(struct LocalCombineTag,
+                    const KeyExtractor &key_extractor,
+                    const GroupByFunction &groupby_function,
+                    const LocalCombineFunction &local_combine_function,
+                    const GroupByConfig& groupby_config = GroupByConfig()) const;
 
     /*!
      * GroupBy is a DOp, which groups elements of the DIA by its key.
@@ -965,6 +1042,60 @@ public:
     auto Zip(struct NoRebalanceTag, const SecondDIA &second_dia,
              const ZipFunction &zip_function) const;
 
+    /*!
+     * Performs an inner join of this DIA with second_dia: for each pair of
+     * items a of this and b of second_dia with equal keys, the output DIA
+     * contains join_function(a, b). The items are shuffled by the hash of the
+     * key, and the items of second_dia are inserted into hash tables, which
+     * are probed by the items of this DIA. Hence, second_dia should be the
+     * smaller DIA.
+     *
+     * \param second_dia DIA, which is joined with the original DIA.
+     *
+     * \param key_extractor1 Key extractor function for items of this DIA.
+     *
+     * \param key_extractor2 Key extractor function for items of second_dia,
+     * which must return the same key type.
+     *
+     * \param join_function Join function, which is applied to each pair of
+     * items with equal keys.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor1, typename KeyExtractor2,
+              typename JoinFunction, typename SecondDIA>
+    auto InnerJoin(const SecondDIA &second_dia,
+                   const KeyExtractor1 &key_extractor1,
+                   const KeyExtractor2 &key_extractor2,
+                   const JoinFunction &join_function) const;
+
+    /*!
+     * Performs an inner join of this DIA with a small second_dia by
+     * broadcasting it: second_dia is sent to all workers and loaded into one
+     * read-only hash table per host, which is shared by the local workers. The items of this DIA are then joined in a FlatMap()
+     * LOp without any shuffle. Hence, this DIA keeps its distribution, but
+     * second_dia is evaluated immediately and must fit into the RAM of each
+     * host.
+     *
+     * \param second_dia Small DIA, which is joined with the original DIA.
+     *
+     * \param key_extractor1 Key extractor function for items of this DIA.
+     *
+     * \param key_extractor2 Key extractor function for items of second_dia,
+     * which must return the same key type.
+     *
+     * \param join_function Join function, which is applied to each pair of
+     * items with equal keys.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor1, typename KeyExtractor2,
+              typename JoinFunction, typename SecondDIA>
+    auto InnerJoin(struct BroadcastTag, const SecondDIA &second_dia,
+                   const KeyExtractor1 &key_extractor1,
+                   const KeyExtractor2 &key_extractor2,
+                   const JoinFunction &join_function) const;
+
     /*!
      * Zips each item of a DIA with its zero-based array index. This requires a
      * full data store/retrieve cycle because the input DIA's size is generally
@@ -1004,11 +1135,98 @@ public:
      * \param sort_algorithm Algorithm class used to sort items. Merging is
      * always done using a tournament tree with compare_function.
      *
+     * \param sort_config Sort configuration, selects the distributed
+     * algorithms used by the SortNode.
+     *
      * \ingroup dia_dops
      */
-    template <typename CompareFunction, typename SortFunction>
+    template <typename CompareFunction, typename SortFunction,
+              typename SortConfig = class DefaultSortConfig>
     auto Sort(const CompareFunction &compare_function,
-              const SortFunction &sort_algorithm) const;
+              const SortFunction &sort_algorithm,
+              const SortConfig& sort_config = SortConfig()) const;
+
+    /*!
+     * SortByKey is a DOp, which sorts a given DIA by the keys returned by
+     * key_extractor. The keys must be integers or fixed-width byte strings
+     * (std::array<uint8_t, N>), which are compared lexicographically by
+     * byte. Local runs are sorted using MSD radix sort and items are
+     * classified by comparing 64-bit key prefixes first.
+     *
+     * \tparam KeyExtractor Type of the key_extractor function.
+     *  Should be (ValueType)->Key
+     *
+     * \param key_extractor Function, which returns the key of an item.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename KeyExtractor>
+    auto SortByKey(const KeyExtractor &key_extractor) const;
+
+    /*!
+     * TopK is a DOp, which selects the k smallest elements of a DIA according
+     * to the given compare_function and returns them sorted in a new DIA. Each
+     * worker keeps a bounded heap of its k smallest elements and only O(k p)
+     * elements are transmitted, hence this is much cheaper than a full Sort
+     * for small k. Pass std::greater<ValueType> to select the k largest.
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (ValueType,ValueType)->bool
+     *
+     * \param k Number of elements to select.
+     *
+     * \param compare_function Function, which compares two elements. Returns
+     * true, if first element is smaller than second. False otherwise.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    auto TopK(size_t k,
+              const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * SortStable is a DOp, which sorts a given DIA according to the given
+     * compare_function, such that equal elements keep their order in the
+     * input DIA. Ties are broken by the global index of the elements, hence no
+     * index needs to be added to the elements.
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (ValueType,ValueType)->bool
+     *
+     * \param compare_function Function, which compares two elements. Returns
+     * true, if first element is smaller than second. False otherwise.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction = std::less<ValueType> >
+    auto SortStable(
+        const CompareFunction& compare_function = CompareFunction()) const;
+
+    /*!
+     * SortStable is a DOp, which sorts a given DIA according to the given
+     * compare_function, such that equal elements keep their order in the
+     * input DIA.
+     *
+     * \tparam CompareFunction Type of the compare_function.
+     *  Should be (ValueType,ValueType)->bool
+     *
+     * \param compare_function Function, which compares two elements. Returns
+     * true, if first element is smaller than second. False otherwise.
+     *
+     * \param sort_algorithm Algorithm class used to sort items, which must be
+     * stable. Merging is always done using a stable tournament tree with
+     * compare_function.
+     *
+     * \param sort_config Sort configuration, selects the distributed
+     * algorithms used by the SortNode.
+     *
+     * \ingroup dia_dops
+     */
+    template <typename CompareFunction, typename SortFunction,
+              typename SortConfig = class DefaultSortConfig>
+    auto SortStable(const CompareFunction &compare_function,
+                    const SortFunction &sort_algorithm,
+                    const SortConfig& sort_config = SortConfig()) const;
 
     /*!
      * Merge is a DOp, which merges two sorted DIAs to a single sorted DIA.
@@ -1226,6 +1444,15 @@ using api::PadTag;
 //! imported from api namespace
 using api::NoRebalanceTag;
 
+//! imported from api namespace
+using api::BroadcastTag;
+
+//! imported from api namespace
+using api::SplitGroupsTag;
+
+//! imported from api namespace
+using api::LocalCombineTag;
+
 } // namespace thrill
 
 #endif // !THRILL_API_DIA_HEADER
@@ -34,7 +34,9 @@ namespace api {
 
 // forward declarations for friend classes
 template <typename ValueType,
-          typename KeyExtractor, typename GroupFunction, typename HashFunction>
+          typename KeyExtractor, typename GroupFunction, typename HashFunction,
+          typename GroupByConfig, typename CombineFunction,
+          typename LocalCombineFunction>
 class GroupByNode;
 
 template <typename ValueType,
@@ -49,7 +51,10 @@ class GroupByIterator
     template <typename T1,
               typename T2,
               typename T3,
-              typename T4>
+              typename T4,
+              typename T5,
+              typename T6,
+              typename T7>
     friend class GroupByNode;
 
     template <typename T1,
@@ -125,13 +130,19 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template <typename ValueType, typename KeyExtractor, typename Comparator>
+template <typename ValueType, typename KeyExtractor, typename Comparator,
+          typename Puller = core::MultiwayMergeTree<
+              ValueType, std::vector<data::File::ConsumeReader>::iterator,
+              Comparator> >
 class GroupByMultiwayMergeIterator
 {
     template <typename T1,
               typename T2,
               typename T3,
-              typename T4>
+              typename T4,
+              typename T5,
+              typename T6,
+              typename T7>
     friend class GroupByNode;
 
     template <typename T1,
@@ -143,8 +154,6 @@ public:
     static constexpr bool debug = false;
     using ValueIn = ValueType;
     using Key = typename common::FunctionTraits<KeyExtractor>::result_type;
-    using Puller = core::MultiwayMergeTree<
-              ValueIn, std::vector<data::File::ConsumeReader>::iterator, Comparator>;
 
     GroupByMultiwayMergeIterator(Puller& reader, const KeyExtractor& key_extractor)
         : reader_(reader),
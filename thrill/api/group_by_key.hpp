@@ -19,22 +19,92 @@
 #include <thrill/api/group_by_iterator.hpp>
 #include <thrill/common/functional.hpp>
 #include <thrill/common/logger.hpp>
+#include <thrill/common/meta.hpp>
+#include <thrill/core/group_by_hash_table.hpp>
+#include <thrill/core/parallel_multiway_merge.hpp>
+#include <thrill/core/reduce_pre_stage.hpp>
 
 #include <algorithm>
 #include <functional>
+#include <memory>
+#include <random>
+#include <thread>
 #include <type_traits>
 #include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
+class DefaultGroupByConfig
+{
+public:
+    //! group the received items in a hash table instead of sorting them. The
+    //! key then only needs a hash function and operator ==, but the groups are
+    //! not delivered in order of their keys.
+    static constexpr bool use_hash_grouping_ = false;
+
+    //! only for hash grouping: number of Files the items are partitioned into
+    //! if the hash table exceeds the memory limit. Each File is then grouped
+    //! separately.
+    static constexpr size_t spill_partitions_ = 16;
+
+    //! only for hash grouping: maximum number of recursive partitioning levels
+    //! for spilled Files which still exceed the memory limit.
+    static constexpr size_t max_spill_levels_ = 3;
+
+    //! only for splitting heavy groups: sample on average every n-th item in
+    //! the PreOp to estimate the group sizes.
+    static constexpr size_t heavy_sample_interval_ = 64;
+
+    //! only for splitting heavy groups: a group is heavy, and spread over all
+    //! workers, if its estimated size is at least this fraction of the average
+    //! number of items per worker.
+    static constexpr double heavy_group_fraction_ = 0.5;
+
+    //! only for local combining: memory of the hash table combining items in
+    //! the PreOp. It is kept small such that the table stays in cache.
+    static constexpr size_t local_combine_memory_ = 4 * 1024 * 1024;
+
+    //! only for sort grouping: number of threads of the host-wide ThreadPool
+    //! used for the multiway merge of the runs. 0 selects the number of cores
+    //! per worker.
+    static constexpr size_t merge_threads_ = 0;
+
+    //! only for sort grouping: minimum number of items per thread for merging
+    //! in parallel, since splitting the runs requires binary searches.
+    static constexpr size_t parallel_merge_min_items_ = 65536;
+};
+
+//! CombineFunction of a GroupByNode which does not split heavy groups, or
+//! LocalCombineFunction which does not combine items in the PreOp.
+class GroupByNoCombine
+{ };
+
 /*!
+ * A DIANode which groups the items of a DIA by key and applies a group
+ * function to each group.
+ *
+ * If a CombineFunction is given, large groups are detected from a sample taken
+ * in the PreOp and their items are spread round-robin over all workers,
+ * instead of sending them all to one. Each worker applies the group function
+ * to its part of a heavy group, and the partial results are then merged on the
+ * key's worker with the associative CombineFunction.
+ *
+ * If a LocalCombineFunction is given, items with equal keys are merged into
+ * one in the PreOp by a bounded ReducePreStage before they are sent, such that
+ * the GroupFunction receives partially combined items.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType,
-          typename KeyExtractor, typename GroupFunction, typename HashFunction>
+          typename KeyExtractor, typename GroupFunction, typename HashFunction,
+          typename GroupByConfig = DefaultGroupByConfig,
+          typename CombineFunction = GroupByNoCombine,
+          typename LocalCombineFunction = GroupByNoCombine>
 class GroupByNode final : public DOpNode<ValueType>
 {
     static constexpr bool debug = false;
@@ -47,6 +117,45 @@ class GroupByNode final : public DOpNode<ValueType>
     using ValueIn =
               typename common::FunctionTraits<KeyExtractor>::template arg_plain<0>;
 
+    using HashTable = core::GroupByHashTable<
+              ValueIn, Key, KeyExtractor, HashFunction>;
+    using HashPartition = core::GroupByHashPartition<Key, HashFunction>;
+
+    //! selects the sorting or hashing implementations of MainOp and PushData
+    using UseHashGrouping =
+              std::integral_constant<bool, GroupByConfig::use_hash_grouping_>;
+
+    //! whether heavy groups are split across workers
+    static constexpr bool split_heavy_ =
+        !std::is_same<CombineFunction, GroupByNoCombine>::value;
+
+    //! selects the implementations of the heavy group methods
+    using SplitHeavyGroups = std::integral_constant<bool, split_heavy_>;
+
+    //! partial group result sent to the key's worker
+    using KeyResultPair = std::pair<Key, ValueOut>;
+
+    //! whether items are combined in the PreOp
+    static constexpr bool local_combine_ =
+        !std::is_same<LocalCombineFunction, GroupByNoCombine>::value;
+
+    //! selects the implementations of the PreOp
+    using UseLocalCombine = std::integral_constant<bool, local_combine_>;
+
+    static_assert(!(split_heavy_ && local_combine_),
+                  "GroupByNode cannot both split heavy groups and combine "
+                  "items locally");
+
+    //! hash table stage combining items in the PreOp, only instantiated if a
+    //! LocalCombineFunction is given.
+    using PreStage = typename common::If<
+              local_combine_,
+              core::ReducePreStage<
+                  ValueIn, Key, ValueIn, KeyExtractor, LocalCombineFunction,
+                  /* VolatileKey */ false, core::DefaultReduceConfig,
+                  core::ReduceByHash<Key, HashFunction> >,
+              GroupByNoCombine>::type;
+
     struct ValueComparator {
     public:
         explicit ValueComparator(const GroupByNode& node) : node_(node) { }
@@ -68,12 +177,21 @@ public:
     GroupByNode(const ParentDIA& parent,
                 const KeyExtractor& key_extractor,
                 const GroupFunction& groupby_function,
-                const HashFunction& hash_function = HashFunction())
+                const HashFunction& hash_function = HashFunction(),
+                const GroupByConfig& config = GroupByConfig(),
+                const CombineFunction& combine_function = CombineFunction(),
+                const LocalCombineFunction& local_combine_function =
+                    LocalCombineFunction())
         : Super(parent.ctx(), "GroupByKey", { parent.id() }, { parent.node() }),
           key_extractor_(key_extractor),
           groupby_function_(groupby_function),
-          hash_function_(hash_function)
+          hash_function_(hash_function),
+          config_(config),
+          table_(key_extractor, hash_function),
+          combine_function_(combine_function)
     {
+        MakePreStage(local_combine_function, UseLocalCombine());
+
         // Hook PreOp
         auto pre_op_fn = [=](const ValueIn& input) {
                              PreOp(input);
@@ -84,31 +202,188 @@ public:
         parent.node()->AddChild(this, lop_chain);
     }
 
+    DIAMemUse PreOpMemUse() final {
+        if (local_combine_) return GroupByConfig::local_combine_memory_;
+        return 0;
+    }
+
     void StartPreOp(size_t /* id */) final {
-        emitter_ = stream_->GetWriters();
+        if (split_heavy_)
+            pre_writer_ = pre_file_.GetWriter();
+        else if (local_combine_)
+            StartPreStage(UseLocalCombine());
+        else
+            emitter_ = stream_->GetWriters();
     }
 
     //! Send all elements to their designated PEs
     void PreOp(const ValueIn& v) {
+        if (local_combine_)
+            return InsertPreStage(v, UseLocalCombine());
+        if (split_heavy_) {
+            // keep items until the heavy groups are known, and sample keys.
+            pre_writer_.Put(v);
+            if (--sample_countdown_ == 0) {
+                sample_.emplace_back(key_extractor_(v));
+                sample_countdown_ = 1 + sample_rng_() % (
+                    2 * GroupByConfig::heavy_sample_interval_ - 1);
+            }
+            return;
+        }
         const Key k = key_extractor_(v);
         const size_t recipient = hash_function_(k) % emitter_.size();
         emitter_[recipient].Put(v);
     }
 
     void StopPreOp(size_t /* id */) final {
+        if (split_heavy_) {
+            pre_writer_.Close();
+            return;
+        }
+        if (local_combine_) {
+            // flush the combined items, this closes the emitters
+            StopPreStage(UseLocalCombine());
+            return;
+        }
         // data has been pushed during pre-op -> close emitters
         for (size_t i = 0; i < emitter_.size(); i++)
             emitter_[i].Close();
     }
 
+    DIAMemUse ExecuteMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    DIAMemUse PushDataMemUse() final {
+        if (GroupByConfig::use_hash_grouping_) return DIAMemUse::Max();
+        // only the parallel multiway merge needs memory for Blocks of the runs
+        if (files_.size() > 1 && MergeThreads(size_t(-1)) > 1)
+            return DIAMemUse::Max();
+        return 0;
+    }
+
     void Execute() override {
-        MainOp();
+        ShuffleHeavyGroups(SplitHeavyGroups());
+        MainOp(UseHashGrouping());
+        CombineHeavyGroups(SplitHeavyGroups());
     }
 
     void PushData(bool consume) final {
+        PushData(consume, UseHashGrouping());
+
+        for (const ValueOut& v : heavy_results_)
+            this->PushItem(v);
+        if (consume) std::vector<ValueOut>().swap(heavy_results_);
+    }
+
+    void Dispose() override {
+        table_.Clear();
+        spill_files_.clear();
+        std::vector<ValueOut>().swap(heavy_results_);
+    }
+
+private:
+    KeyExtractor key_extractor_;
+    GroupFunction groupby_function_;
+    HashFunction hash_function_;
+    GroupByConfig config_;
+
+    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+    std::vector<data::Stream::Writer> emitter_;
+    std::vector<data::File> files_;
+    data::File sorted_elems_ { context_.GetFile(this) };
+    size_t totalsize_ = 0;
+
+    //! hash table grouping the received items in hash grouping mode
+    HashTable table_;
+    //! partitions of the received items if the hash table was spilled
+    std::vector<data::File> spill_files_;
+
+    //! \name Splitting of Heavy Groups
+    //! \{
+
+    CombineFunction combine_function_;
+
+    //! local items kept in the PreOp until the heavy groups are known
+    data::File pre_file_ { context_.GetFile(this) };
+    data::File::Writer pre_writer_;
+
+    //! sampled keys of the local items
+    std::vector<Key> sample_;
+    //! number of items until the next sample, the gaps are random to avoid
+    //! aliasing with periodic input.
+    size_t sample_countdown_ = 1;
+    std::minstd_rand sample_rng_;
+
+    //! streams for the parts of heavy groups and for their partial results
+    data::CatStreamPtr heavy_stream_ {
+        split_heavy_ ? context_.GetNewCatStream(this) : nullptr
+    };
+    data::CatStreamPtr partial_stream_ {
+        split_heavy_ ? context_.GetNewCatStream(this) : nullptr
+    };
+
+    //! combined results of the heavy groups of this worker's keys
+    std::vector<ValueOut> heavy_results_;
+
+    //! minimum number of samples of a heavy group over all workers
+    static constexpr size_t heavy_min_samples_ = 4;
+
+    //! \}
+
+    //! hash table stage combining items in the PreOp
+    std::unique_ptr<PreStage> pre_stage_;
+
+    //! \name Local Combining in the PreOp
+    //! \{
+
+    void MakePreStage(const LocalCombineFunction&,
+                      std::false_type /* use_local_combine */) { }
+
+    void StartPreStage(std::false_type /* use_local_combine */) { }
+
+    void InsertPreStage(const ValueIn&,
+                        std::false_type /* use_local_combine */) { }
+
+    void StopPreStage(std::false_type /* use_local_combine */) { }
+
+    //! the ReducePreStage requires its emitters when constructed.
+    void MakePreStage(const LocalCombineFunction& local_combine_function,
+                      std::true_type /* use_local_combine */) {
+        emitter_ = stream_->GetWriters();
+        pre_stage_ = std::make_unique<PreStage>(
+            context_, this->id(), context_.num_workers(),
+            key_extractor_, local_combine_function, emitter_,
+            core::DefaultReduceConfig(),
+            core::ReduceByHash<Key, HashFunction>(
+                /* salt */ 0, hash_function_));
+    }
+
+    void StartPreStage(std::true_type /* use_local_combine */) {
+        pre_stage_->Initialize(DIABase::mem_limit_);
+    }
+
+    void InsertPreStage(const ValueIn& v,
+                        std::true_type /* use_local_combine */) {
+        pre_stage_->Insert(v);
+    }
+
+    void StopPreStage(std::true_type /* use_local_combine */) {
+        pre_stage_->FlushAll();
+        pre_stage_->CloseAll();
+        pre_stage_.reset();
+    }
+
+    //! \}
+
+    //! sort mode: merge the sorted runs and call the user function on each
+    //! group.
+    void PushData(bool consume, std::false_type /* use_hash_grouping */) {
         LOG << "sort data";
         common::StatsTimerStart timer;
         const size_t num_runs = files_.size();
+        const size_t merge_threads =
+            num_runs > 1 ? MergeThreads(DIABase::mem_limit_) : 1;
         if (num_runs == 0) {
             // nothing to push
         }
@@ -116,6 +391,30 @@ public:
             // if there's only one run, call user funcs
             RunUserFunc(files_[0], consume);
         }
+        else if (merge_threads > 1) {
+            // merge ranges of the runs in parallel using the host-wide
+            // ThreadPool, groups are never split between ranges.
+            LOG << "start parallel multiwaymerge";
+            core::ParallelMultiwayMergeTree<ValueIn, ValueComparator> puller(
+                files_.begin(), files_.end(), consume, ValueComparator(*this),
+                context_.thread_pool(), merge_threads,
+                context_.block_pool(), context_.local_worker_id(),
+                this->id());
+
+            if (puller.HasNext()) {
+                auto user_iterator = GroupByMultiwayMergeIterator<
+                    ValueIn, KeyExtractor, ValueComparator,
+                    decltype(puller)>(puller, key_extractor_);
+
+                while (user_iterator.HasNextForReal()) {
+                    const ValueOut res = groupby_function_(
+                        user_iterator, user_iterator.GetNextKey());
+                    this->PushItem(res);
+                }
+            }
+
+            if (consume) files_.clear();
+        }
         else {
             // otherwise sort all runs using multiway merge
             LOG << "start multiwaymerge";
@@ -152,18 +451,29 @@ public:
             << " multiwaymerge=" << (num_runs > 1);
     }
 
-    void Dispose() override { }
+    //! hash mode: call the user function on each group of the hash table, or
+    //! of each spilled partition.
+    void PushData(bool consume, std::true_type /* use_hash_grouping */) {
+        if (spill_files_.empty()) {
+            RunUserFunc(table_);
+            if (consume) table_.Clear();
+            return;
+        }
 
-private:
-    KeyExtractor key_extractor_;
-    GroupFunction groupby_function_;
-    HashFunction hash_function_;
+        for (data::File& file : spill_files_)
+            GroupPartition(file, /* level */ 1, consume);
 
-    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
-    std::vector<data::Stream::Writer> emitter_;
-    std::vector<data::File> files_;
-    data::File sorted_elems_ { context_.GetFile(this) };
-    size_t totalsize_ = 0;
+        if (consume) spill_files_.clear();
+    }
+
+    //! number of threads of the host-wide ThreadPool used to merge the runs
+    //! within mem_limit, returns 1 for a sequential merge.
+    size_t MergeThreads(size_t mem_limit) const {
+        return core::ParallelMergeThreads(
+            files_.begin(), files_.end(), config_.merge_threads_,
+            context_.workers_per_host(), config_.parallel_merge_min_items_,
+            mem_limit);
+    }
 
     void RunUserFunc(data::File& f, bool consume) {
         auto r = f.GetReader(consume);
@@ -200,10 +510,252 @@ private:
         files_.emplace_back(std::move(f));
     }
 
-    //! Receive elements from other workers.
-    void MainOp() {
+    //! call the user function on each group in a hash table
+    void RunUserFunc(const HashTable& table) {
+        table.ForEachGroup(
+            [this](typename HashTable::GroupIterator& iter, const Key& key) {
+                this->PushItem(groupby_function_(iter, key));
+            });
+    }
+
+    //! true if the hash table must be spilled to partition Files
+    bool TableExceedsMemory(const HashTable& table) const {
+        return mem::memory_exceeded ||
+               table.memory_use() > DIABase::mem_limit_;
+    }
+
+    //! create Files for the partitions of a spilled hash table and return
+    //! their Writers.
+    std::vector<data::File::Writer> CreatePartitions(
+        std::vector<data::File>& files) {
+        assert(files.empty());
+        for (size_t p = 0; p < GroupByConfig::spill_partitions_; ++p)
+            files.emplace_back(context_.GetFile(this));
+
+        // create Writers after all Files, which must not be moved anymore.
+        std::vector<data::File::Writer> writers;
+        for (data::File& file : files)
+            writers.emplace_back(file.GetWriter());
+        return writers;
+    }
+
+    //! hash mode: group the items of a spilled partition File in a new hash
+    //! table. If it exceeds the memory again, the File is partitioned further
+    //! with a different hash salt, up to max_spill_levels_ deep.
+    void GroupPartition(data::File& file, size_t level, bool consume) {
+        HashTable table(key_extractor_, hash_function_);
+        HashPartition partition(
+            GroupByConfig::spill_partitions_, level, hash_function_);
+
+        std::vector<data::File> sub_files;
+        std::vector<data::File::Writer> writers;
+
+        auto reader = file.GetReader(consume);
+        while (reader.HasNext()) {
+            if (writers.empty() && level < GroupByConfig::max_spill_levels_ &&
+                TableExceedsMemory(table)) {
+                sLOG << "GroupByNode spilling partition on level" << level
+                     << "items" << table.num_items();
+                writers = CreatePartitions(sub_files);
+                table.Spill(writers, partition);
+            }
+
+            ValueIn v = reader.template Next<ValueIn>();
+            if (writers.empty())
+                table.Insert(v);
+            else
+                writers[partition(key_extractor_(v))].Put(v);
+        }
+
+        if (writers.empty()) {
+            RunUserFunc(table);
+            return;
+        }
+
+        table.Clear();
+        for (data::File::Writer& w : writers)
+            w.Close();
+        for (data::File& sub_file : sub_files)
+            GroupPartition(sub_file, level + 1, /* consume */ true);
+    }
+
+    //! hash mode: receive elements from other workers into the hash table, and
+    //! partition them into Files once it exceeds the memory limit.
+    void MainOp(std::true_type /* use_hash_grouping */) {
+        LOG << "running group by main op with hashing";
+
+        HashPartition partition(
+            GroupByConfig::spill_partitions_, /* level */ 0, hash_function_);
+        std::vector<data::File::Writer> writers;
+
+        auto reader = stream_->GetCatReader(/* consume */ true);
+        while (reader.HasNext()) {
+            if (writers.empty() && TableExceedsMemory(table_)) {
+                sLOG << "GroupByNode spilling hash table with"
+                     << table_.num_items() << "items";
+                writers = CreatePartitions(spill_files_);
+                table_.Spill(writers, partition);
+            }
+
+            ValueIn v = reader.template Next<ValueIn>();
+            if (writers.empty())
+                table_.Insert(v);
+            else
+                writers[partition(key_extractor_(v))].Put(v);
+        }
+
+        for (data::File::Writer& w : writers)
+            w.Close();
+        stream_->Close();
+
+        LOG << "RESULT"
+            << " name=mainop"
+            << " groups=" << table_.num_groups()
+            << " spill_files=" << spill_files_.size();
+    }
+
+    //! without CombineFunction the items were already sent in the PreOp.
+    void ShuffleHeavyGroups(std::false_type /* split_heavy_groups */) { }
+
+    void CombineHeavyGroups(std::false_type /* split_heavy_groups */) { }
+
+    //! determine the heavy groups from the samples of all workers, then send
+    //! the items of heavy groups round-robin to all workers, and all other
+    //! items to the worker of their key.
+    void ShuffleHeavyGroups(std::true_type /* split_heavy_groups */) {
+        using Candidates = std::vector<std::pair<Key, size_t> >;
+        using CountMap = std::unordered_map<Key, size_t, HashFunction>;
+
+        const size_t num_workers = context_.num_workers();
+        const size_t interval = GroupByConfig::heavy_sample_interval_;
+
+        const size_t total_items =
+            context_.net.AllReduce(pre_file_.num_items());
+        const double threshold = GroupByConfig::heavy_group_fraction_
+                                 * total_items / num_workers;
+
+        // a heavy group has at least threshold / num_workers items on some
+        // worker, which nominates it as a candidate.
+        Candidates candidates;
+        {
+            CountMap counts(0, hash_function_);
+            for (const Key& k : sample_)
+                ++counts[k];
+            std::vector<Key>().swap(sample_);
+
+            for (const typename CountMap::value_type& c : counts) {
+                if (static_cast<double>(c.second * interval * num_workers)
+                    >= threshold)
+                    candidates.emplace_back(c.first, c.second);
+            }
+        }
+
+        // sum up the samples of all candidates over all workers
+        candidates = context_.net.AllReduce(
+            candidates, [this](const Candidates& a, const Candidates& b) {
+                CountMap sum(0, hash_function_);
+                for (const std::pair<Key, size_t>& c : a) sum[c.first] += c.second;
+                for (const std::pair<Key, size_t>& c : b) sum[c.first] += c.second;
+                return Candidates(sum.begin(), sum.end());
+            });
+
+        std::unordered_set<Key, HashFunction> heavy(0, hash_function_);
+        for (const std::pair<Key, size_t>& c : candidates) {
+            if (c.second >= heavy_min_samples_ &&
+                static_cast<double>(c.second * interval) >= threshold)
+                heavy.insert(c.first);
+        }
+
+        sLOG << "GroupByNode detected" << heavy.size() << "heavy groups"
+             << "of" << candidates.size() << "candidates";
+
+        emitter_ = stream_->GetWriters();
+        std::vector<data::Stream::Writer> heavy_writers =
+            heavy_stream_->GetWriters();
+
+        size_t next_worker = context_.my_rank();
+        auto reader = pre_file_.GetConsumeReader();
+        while (reader.HasNext()) {
+            ValueIn v = reader.template Next<ValueIn>();
+            const Key k = key_extractor_(v);
+            if (!heavy.empty() && heavy.count(k)) {
+                heavy_writers[next_worker].Put(v);
+                next_worker = (next_worker + 1) % num_workers;
+            }
+            else {
+                emitter_[hash_function_(k) % num_workers].Put(v);
+            }
+        }
+
+        for (data::Stream::Writer& w : emitter_)
+            w.Close();
+        for (data::Stream::Writer& w : heavy_writers)
+            w.Close();
+    }
+
+    //! apply the group function to the local parts of heavy groups, send the
+    //! partial results to the workers of their keys, and combine them there.
+    void CombineHeavyGroups(std::true_type /* split_heavy_groups */) {
+        {
+            HashTable table(key_extractor_, hash_function_);
+            std::vector<data::Stream::Writer> writers =
+                partial_stream_->GetWriters();
+
+            auto flush_partial_results = [&]() {
+                table.ForEachGroup(
+                    [&](typename HashTable::GroupIterator& iter,
+                        const Key& key) {
+                        writers[hash_function_(key) % writers.size()].Put(
+                            KeyResultPair(key, groupby_function_(iter, key)));
+                    });
+                table.Clear();
+            };
+
+            // the parts of heavy groups may exceed the memory limit: since the
+            // partial results are combined anyway, apply the group function
+            // to the items in the table early and start over.
+            auto reader = heavy_stream_->GetCatReader(/* consume */ true);
+            while (reader.HasNext()) {
+                if (table.num_items() != 0 && TableExceedsMemory(table)) {
+                    sLOG << "GroupByNode flushing partial results of"
+                         << table.num_groups() << "heavy groups";
+                    flush_partial_results();
+                }
+                table.Insert(reader.template Next<ValueIn>());
+            }
+            heavy_stream_->Close();
+
+            flush_partial_results();
+            for (data::Stream::Writer& w : writers)
+                w.Close();
+        }
+
+        // holds one result per heavy group, of which there are at most
+        // num_workers / heavy_group_fraction_.
+        std::unordered_map<Key, ValueOut, HashFunction> combined(
+            0, hash_function_);
+        auto reader = partial_stream_->GetCatReader(/* consume */ true);
+        while (reader.HasNext()) {
+            KeyResultPair p = reader.template Next<KeyResultPair>();
+            auto it = combined.find(p.first);
+            if (it == combined.end())
+                combined.emplace(std::move(p.first), std::move(p.second));
+            else
+                it->second = combine_function_(it->second, p.second);
+        }
+        partial_stream_->Close();
+
+        for (auto& c : combined)
+            heavy_results_.emplace_back(std::move(c.second));
+    }
+
+    //! sort mode: receive elements from other workers and sort them into
+    //! runs.
+    void MainOp(std::false_type /* use_hash_grouping */) {
         LOG << "running group by main op";
 
+        // M/2 such that the other half is used to sort the run
+        size_t capacity = DIABase::mem_limit_ / sizeof(ValueIn) / 2;
         std::vector<ValueIn> incoming;
 
         common::StatsTimerStart timer;
@@ -211,7 +763,8 @@ private:
         auto reader = stream_->GetCatReader(/* consume */ true);
         while (reader.HasNext()) {
             // if vector is full save to disk
-            if (mem::memory_exceeded) {
+            if (!incoming.empty() &&
+                (incoming.size() >= capacity || mem::memory_exceeded)) {
                 FlushVectorToFile(incoming);
                 incoming.clear();
             }
@@ -236,10 +789,80 @@ private:
 
 template <typename ValueType, typename Stack>
 template <typename ValueOut, typename KeyExtractor,
-          typename GroupFunction, typename HashFunction>
+          typename GroupFunction, typename HashFunction,
+          typename GroupByConfig>
+auto DIA<ValueType, Stack>::GroupByKey(
+    const KeyExtractor &key_extractor,
+    const GroupFunction &groupby_function,
+    const GroupByConfig &groupby_config) const {
+
+    using DOpResult = ValueOut;
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    using GroupByNode = api::GroupByNode<
+              DOpResult, KeyExtractor, GroupFunction, HashFunction,
+              GroupByConfig>;
+
+    auto node = common::MakeCounting<GroupByNode>(
+        *this, key_extractor, groupby_function, HashFunction(),
+        groupby_config);
+
+    return DIA<DOpResult>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename ValueOut, typename KeyExtractor,
+          typename GroupFunction, typename CombineFunction,
+          typename HashFunction, typename GroupByConfig>
+auto DIA<ValueType, Stack>::GroupByKey(
+    struct SplitGroupsTag,
+    const KeyExtractor &key_extractor,
+    const GroupFunction &groupby_function,
+    const CombineFunction &combine_function,
+    const GroupByConfig &groupby_config) const {
+
+    using DOpResult = ValueOut;
+
+    static_assert(
+        std::is_same<
+            typename std::decay<typename common::FunctionTraits<KeyExtractor>
+                                ::template arg<0> >::type,
+            ValueType>::value,
+        "KeyExtractor has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename common::FunctionTraits<CombineFunction>::result_type,
+            ValueOut>::value,
+        "CombineFunction has the wrong output type");
+
+    using GroupByNode = api::GroupByNode<
+              DOpResult, KeyExtractor, GroupFunction, HashFunction,
+              GroupByConfig, CombineFunction>;
+
+    auto node = common::MakeCounting<GroupByNode>(
+        *this, key_extractor, groupby_function, HashFunction(),
+        groupby_config, combine_function);
+
+    return DIA<DOpResult>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename ValueOut, typename KeyExtractor,
+          typename GroupFunction, typename LocalCombineFunction,
+          typename HashFunction, typename GroupByConfig>
 auto DIA<ValueType, Stack>::GroupByKey(
+    struct LocalCombineTag,
     const KeyExtractor &key_extractor,
-    const GroupFunction &groupby_function) const {
+    const GroupFunction &groupby_function,
+    const LocalCombineFunction &local_combine_function,
+    const GroupByConfig &groupby_config) const {
 
     using DOpResult = ValueOut;
 
@@ -250,11 +873,19 @@ auto DIA<ValueType, Stack>::GroupByKey(
             ValueType>::value,
         "KeyExtractor has the wrong input type");
 
+    static_assert(
+        std::is_convertible<
+            typename common::FunctionTraits<LocalCombineFunction>::result_type,
+            ValueType>::value,
+        "LocalCombineFunction has the wrong output type");
+
     using GroupByNode = api::GroupByNode<
-              DOpResult, KeyExtractor, GroupFunction, HashFunction>;
+              DOpResult, KeyExtractor, GroupFunction, HashFunction,
+              GroupByConfig, GroupByNoCombine, LocalCombineFunction>;
 
     auto node = common::MakeCounting<GroupByNode>(
-        *this, key_extractor, groupby_function);
+        *this, key_extractor, groupby_function, HashFunction(),
+        groupby_config, GroupByNoCombine(), local_combine_function);
 
     return DIA<DOpResult>(node);
 }
@@ -0,0 +1,637 @@
+/*******************************************************************************
+ * thrill/api/inner_join.hpp
+ *
+ * DIANode for a hash-based inner join of two DIAs.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_INNER_JOIN_HEADER
+#define THRILL_API_INNER_JOIN_HEADER
+
+#include <thrill/api/action_node.hpp>
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/core/group_by_hash_table.hpp>
+#include <thrill/data/file.hpp>
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+class DefaultInnerJoinConfig
+{
+public:
+    //! number of Files the items of both sides are partitioned into if the
+    //! hash table of the build side exceeds the memory limit. Each pair of
+    //! partitions is then joined separately.
+    static constexpr size_t spill_partitions_ = 16;
+
+    //! maximum number of recursive partitioning levels. Partitions which still
+    //! exceed the memory limit, e.g. due to a single very frequent key, are
+    //! joined block-wise by scanning the probe side once per block.
+    static constexpr size_t max_spill_levels_ = 3;
+};
+
+/*!
+ * A DIANode which performs an inner join of two DIAs on keys. For each pair of
+ * items a from the first and b from the second DIA with equal keys the node
+ * emits join_function(a, b).
+ *
+ * The items of both DIAs are shuffled by the hash of their key, such that equal
+ * keys meet on the same worker. Each worker then inserts the items of the
+ * second DIA (the build side) into a hash table and probes it with the items of
+ * the first DIA. Hence, the second DIA should be the smaller one. If the hash
+ * table exceeds the memory limit, both sides are partitioned into Files by a
+ * salted hash of the key and the partitions are joined recursively.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename HashFunction,
+          typename JoinConfig = DefaultInnerJoinConfig>
+class InnerJoinNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+    using InputTypeFirst =
+              typename common::FunctionTraits<KeyExtractor1>::template arg_plain<0>;
+    using InputTypeSecond =
+              typename common::FunctionTraits<KeyExtractor2>::template arg_plain<0>;
+
+    using HashTable = core::GroupByHashTable<
+              InputTypeSecond, Key, KeyExtractor2, HashFunction>;
+    using HashPartition = core::GroupByHashPartition<Key, HashFunction>;
+
+public:
+    /*!
+     * Constructor for an InnerJoinNode.
+     */
+    template <typename ParentDIA0, typename ParentDIA1>
+    InnerJoinNode(const ParentDIA0& parent0, const ParentDIA1& parent1,
+                  const KeyExtractor1& key_extractor1,
+                  const KeyExtractor2& key_extractor2,
+                  const JoinFunction& join_function,
+                  const HashFunction& hash_function = HashFunction(),
+                  const JoinConfig& config = JoinConfig())
+        : Super(parent0.ctx(), "InnerJoin",
+                { parent0.id(), parent1.id() },
+                { parent0.node(), parent1.node() }),
+          key_extractor1_(key_extractor1),
+          key_extractor2_(key_extractor2),
+          join_function_(join_function),
+          hash_function_(hash_function),
+          config_(config)
+    {
+        // Hook PreOps
+        auto pre_op0_fn = [this](const InputTypeFirst& input) {
+                              const size_t recipient =
+                                  hash_function_(key_extractor1_(input))
+                                  % probe_writers_.size();
+                              probe_writers_[recipient].Put(input);
+                          };
+        auto pre_op1_fn = [this](const InputTypeSecond& input) {
+                              const size_t recipient =
+                                  hash_function_(key_extractor2_(input))
+                                  % build_writers_.size();
+                              build_writers_[recipient].Put(input);
+                          };
+
+        // close the function stacks with our pre ops and register them at
+        // parent nodes for output
+        auto lop_chain0 = parent0.stack().push(pre_op0_fn).fold();
+        parent0.node()->AddChild(this, lop_chain0, 0);
+
+        auto lop_chain1 = parent1.stack().push(pre_op1_fn).fold();
+        parent1.node()->AddChild(this, lop_chain1, 1);
+    }
+
+    void StartPreOp(size_t parent_index) final {
+        if (parent_index == 0)
+            probe_writers_ = probe_stream_->GetWriters();
+        else
+            build_writers_ = build_stream_->GetWriters();
+    }
+
+    void StopPreOp(size_t parent_index) final {
+        LOG << *this << " StopPreOp() parent_index=" << parent_index;
+        std::vector<data::Stream::Writer>& writers =
+            parent_index == 0 ? probe_writers_ : build_writers_;
+        for (data::Stream::Writer& w : writers)
+            w.Close();
+    }
+
+    DIAMemUse PushDataMemUse() final {
+        return DIAMemUse::Max();
+    }
+
+    void Execute() final {
+        MainOp();
+    }
+
+    void PushData(bool consume) final {
+        JoinPartition(build_file_, probe_file_, /* level */ 0, consume);
+    }
+
+    void Dispose() final {
+        build_file_.Clear();
+        probe_file_.Clear();
+    }
+
+private:
+    KeyExtractor1 key_extractor1_;
+    KeyExtractor2 key_extractor2_;
+    JoinFunction join_function_;
+    HashFunction hash_function_;
+    JoinConfig config_;
+
+    //! shuffle of the first DIA, which probes the hash table
+    data::MixStreamPtr probe_stream_ { context_.GetNewMixStream(this) };
+    std::vector<data::Stream::Writer> probe_writers_;
+    //! shuffle of the second DIA, which is inserted into the hash table
+    data::MixStreamPtr build_stream_ { context_.GetNewMixStream(this) };
+    std::vector<data::Stream::Writer> build_writers_;
+
+    //! received items of both sides
+    data::File probe_file_ { context_.GetFile(this) };
+    data::File build_file_ { context_.GetFile(this) };
+
+    //! Receive elements from other workers.
+    void MainOp() {
+        ReceiveStream<InputTypeFirst>(probe_stream_, probe_file_);
+        ReceiveStream<InputTypeSecond>(build_stream_, build_file_);
+
+        sLOG << "InnerJoinNode::MainOp() probe items" << probe_file_.num_items()
+             << "build items" << build_file_.num_items();
+    }
+
+    //! copy the items received from a stream into a File
+    template <typename ItemType>
+    void ReceiveStream(data::MixStreamPtr& stream, data::File& file) {
+        auto writer = file.GetWriter();
+        auto reader = stream->GetMixReader(/* consume */ true);
+        while (reader.HasNext())
+            writer.Put(reader.template Next<ItemType>());
+        writer.Close();
+        stream->Close();
+    }
+
+    //! true if the hash table must be spilled to partition Files
+    bool TableExceedsMemory(const HashTable& table) const {
+        return table.num_items() != 0 &&
+               (mem::memory_exceeded ||
+                table.memory_use() > DIABase::mem_limit_);
+    }
+
+    //! create Files for the partitions of a spilled side and return their
+    //! Writers.
+    std::vector<data::File::Writer> CreatePartitions(
+        std::vector<data::File>& files) {
+        assert(files.empty());
+        for (size_t p = 0; p < JoinConfig::spill_partitions_; ++p)
+            files.emplace_back(context_.GetFile(this));
+
+        // create Writers after all Files, which must not be moved anymore.
+        std::vector<data::File::Writer> writers;
+        for (data::File& file : files)
+            writers.emplace_back(file.GetWriter());
+        return writers;
+    }
+
+    //! emit the join of each item of the probe File with the hash table
+    void Probe(const HashTable& table, data::File& probe, bool consume) {
+        auto reader = probe.GetReader(consume);
+        while (reader.HasNext()) {
+            InputTypeFirst a = reader.template Next<InputTypeFirst>();
+            typename HashTable::GroupIterator iter =
+                table.Find(key_extractor1_(a));
+            while (iter.HasNext())
+                this->PushItem(join_function_(a, iter.Next()));
+        }
+    }
+
+    //! join the build items in a hash table with the probe File. If the hash
+    //! table exceeds the memory limit, both Files are partitioned with a hash
+    //! salted by the level, and each pair of partitions is joined recursively.
+    void JoinPartition(data::File& build, data::File& probe, size_t level,
+                       bool consume) {
+        HashTable table(key_extractor2_, hash_function_);
+        HashPartition partition(
+            JoinConfig::spill_partitions_, level, hash_function_);
+
+        std::vector<data::File> build_parts;
+        std::vector<data::File::Writer> writers;
+
+        data::File::Reader reader = build.GetReader(consume);
+        while (reader.HasNext()) {
+            if (writers.empty() && TableExceedsMemory(table)) {
+                if (level >= JoinConfig::max_spill_levels_) {
+                    BlockJoin(table, reader, probe, consume);
+                    return;
+                }
+                sLOG << "InnerJoinNode spilling build side on level" << level
+                     << "items" << table.num_items();
+                writers = CreatePartitions(build_parts);
+                table.Spill(writers, partition);
+            }
+
+            InputTypeSecond b = reader.template Next<InputTypeSecond>();
+            if (writers.empty())
+                table.Insert(b);
+            else
+                writers[partition(key_extractor2_(b))].Put(b);
+        }
+
+        if (writers.empty()) {
+            Probe(table, probe, consume);
+            return;
+        }
+
+        for (data::File::Writer& w : writers)
+            w.Close();
+
+        // partition the probe side by the same function
+        std::vector<data::File> probe_parts;
+        writers = CreatePartitions(probe_parts);
+        {
+            data::File::Reader preader = probe.GetReader(consume);
+            while (preader.HasNext()) {
+                InputTypeFirst a = preader.template Next<InputTypeFirst>();
+                writers[partition(key_extractor1_(a))].Put(a);
+            }
+        }
+        for (data::File::Writer& w : writers)
+            w.Close();
+
+        for (size_t p = 0; p < build_parts.size(); ++p) {
+            JoinPartition(build_parts[p], probe_parts[p], level + 1,
+                          /* consume */ true);
+        }
+    }
+
+    //! fallback for partitions which cannot be split further: fill the hash
+    //! table up to the memory limit, scan the whole probe File, and repeat with
+    //! the next block of build items.
+    void BlockJoin(HashTable& table, data::File::Reader& reader,
+                   data::File& probe, bool consume) {
+        sLOG << "InnerJoinNode block join of" << probe.num_items()
+             << "probe items";
+        while (true) {
+            Probe(table, probe, /* consume */ false);
+            table.Clear();
+            if (!reader.HasNext()) break;
+
+            while (reader.HasNext() && !TableExceedsMemory(table))
+                table.Insert(reader.template Next<InputTypeSecond>());
+        }
+        if (consume) probe.Clear();
+    }
+};
+
+/*!
+ * Performs an inner join of two DIAs: for each pair of items a of first_dia
+ * and b of second_dia with key_extractor1(a) == key_extractor2(b), the output
+ * DIA contains join_function(a, b). The second DIA is loaded into hash tables,
+ * hence it should be the smaller one.
+ *
+ * \param first_dia First input DIA, which probes the hash tables.
+ *
+ * \param second_dia Second input DIA, which is inserted into the hash tables.
+ *
+ * \param key_extractor1 Key extractor function for items of the first DIA.
+ *
+ * \param key_extractor2 Key extractor function for items of the second DIA.
+ *
+ * \param join_function Join function, which is applied to each pair of items
+ * with equal keys and delivers an item of the output DIA.
+ *
+ * \param hash_function Hash function for the keys.
+ *
+ * \param join_config InnerJoin configuration.
+ *
+ * \ingroup dia_dops
+ */
+template <typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction,
+          typename HashFunction =
+              std::hash<typename common::FunctionTraits<KeyExtractor1>::result_type>,
+          typename JoinConfig = DefaultInnerJoinConfig>
+auto InnerJoin(const FirstDIA &first_dia, const SecondDIA &second_dia,
+               const KeyExtractor1 &key_extractor1,
+               const KeyExtractor2 &key_extractor2,
+               const JoinFunction &join_function,
+               const HashFunction &hash_function = HashFunction(),
+               const JoinConfig &join_config = JoinConfig()) {
+
+    first_dia.AssertValid();
+    second_dia.AssertValid();
+
+    using InputTypeFirst = typename FirstDIA::ValueType;
+    using InputTypeSecond = typename SecondDIA::ValueType;
+
+    static_assert(
+        std::is_convertible<
+            InputTypeFirst,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "KeyExtractor1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeSecond,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "KeyExtractor2 has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            typename common::FunctionTraits<KeyExtractor1>::result_type,
+            typename common::FunctionTraits<KeyExtractor2>::result_type>::value,
+        "KeyExtractor1 and KeyExtractor2 must return the same key type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeFirst,
+            typename common::FunctionTraits<JoinFunction>::template arg<0>
+            >::value,
+        "JoinFunction has the wrong first input type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeSecond,
+            typename common::FunctionTraits<JoinFunction>::template arg<1>
+            >::value,
+        "JoinFunction has the wrong second input type");
+
+    using JoinResult =
+              typename common::FunctionTraits<JoinFunction>::result_type;
+
+    using InnerJoinNode = api::InnerJoinNode<
+              JoinResult, KeyExtractor1, KeyExtractor2, JoinFunction,
+              HashFunction, JoinConfig>;
+
+    auto node = common::MakeCounting<InnerJoinNode>(
+        first_dia, second_dia, key_extractor1, key_extractor2, join_function,
+        hash_function, join_config);
+
+    return DIA<JoinResult>(node);
+}
+
+/*!
+ * An ActionNode which broadcasts a small DIA to all hosts and loads it into a
+ * read-only hash table shared by the workers of each host. The items are sent
+ * via a CatStream only to the first worker of each host, which builds the table
+ * directly from its stream in HostContext::GetHostShared(). The other local
+ * workers receive no items and wait for the table. Hence, each host receives
+ * the items once, and they are never collected in a vector.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename Key,
+          typename KeyExtractor, typename HashFunction>
+class BroadcastHashTableNode final : public ActionNode
+{
+    static constexpr bool debug = false;
+
+public:
+    using Super = ActionNode;
+    using Super::context_;
+
+    using HashTable = core::GroupByHashTable<
+              ValueType, Key, KeyExtractor, HashFunction>;
+
+    template <typename ParentDIA>
+    BroadcastHashTableNode(const ParentDIA& parent,
+                           const KeyExtractor& key_extractor,
+                           const HashFunction& hash_function,
+                           std::shared_ptr<const HashTable>* out_table)
+        : ActionNode(parent.ctx(), "BroadcastHashTable",
+                     { parent.id() }, { parent.node() }),
+          parent_stack_empty_(ParentDIA::stack_empty),
+          key_extractor_(key_extractor),
+          hash_function_(hash_function),
+          out_table_(out_table)
+    {
+        auto pre_op_function = [this](const ValueType& input) {
+                                   PreOp(input);
+                               };
+
+        auto lop_chain = parent.stack().push(pre_op_function).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    void StartPreOp(size_t /* id */) final {
+        emitters_ = stream_->GetWriters();
+        // only the first worker of each host receives items
+        for (size_t i = 0; i < emitters_.size(); i++) {
+            if (i % context_.workers_per_host() != 0)
+                emitters_[i].Close();
+        }
+    }
+
+    void PreOp(const ValueType& element) {
+        for (size_t i = 0; i < emitters_.size();
+             i += context_.workers_per_host()) {
+            emitters_[i].Put(element);
+        }
+    }
+
+    bool OnPreOpFile(const data::File& file, size_t /* parent_index */) final {
+        if (!parent_stack_empty_) return false;
+        for (size_t i = 0; i < emitters_.size();
+             i += context_.workers_per_host()) {
+            emitters_[i].AppendBlocks(file.blocks());
+        }
+        return true;
+    }
+
+    void StopPreOp(size_t /* id */) final {
+        for (size_t i = 0; i < emitters_.size(); i++) {
+            emitters_[i].Close();
+        }
+    }
+
+    void Execute() final {
+        auto reader = stream_->GetCatReader(/* consume */ true);
+
+        // all local workers have the same DIA id, which identifies the table.
+        // Local worker 0 received the items and builds it.
+        *out_table_ = context_.template GetHostShared<const HashTable>(
+            this->id(), [&]() {
+                auto table = std::make_shared<HashTable>(
+                    key_extractor_, hash_function_);
+                while (reader.HasNext())
+                    table->Insert(reader.template Next<ValueType>());
+                LOG << "BroadcastHashTableNode::Execute() built table";
+                return table;
+            });
+
+        assert(!reader.HasNext());
+        stream_->Close();
+    }
+
+private:
+    //! Whether the parent stack is empty
+    const bool parent_stack_empty_;
+
+    KeyExtractor key_extractor_;
+    HashFunction hash_function_;
+
+    //! pointer to deliver the shared table to
+    std::shared_ptr<const HashTable>* out_table_;
+
+    data::CatStreamPtr stream_ { context_.GetNewCatStream(this) };
+    std::vector<data::CatStream::Writer> emitters_;
+};
+
+/*!
+ * Performs an inner join of a large first_dia with a small second_dia by
+ * broadcasting the second DIA: for each pair of items a of first_dia and b of
+ * second_dia with key_extractor1(a) == key_extractor2(b), the output DIA
+ * contains join_function(a, b).
+ *
+ * The second DIA is broadcast to all hosts by a BroadcastHashTableNode, hence
+ * it is evaluated immediately. The first local worker of each host loads it
+ * into a read-only hash table, which is shared by all workers on the host via
+ * HostContext::GetHostShared(). The first DIA is then joined by
+ * a FlatMap() LOp probing the shared table, without any shuffle.
+ *
+ * \param first_dia Large input DIA, which probes the hash table.
+ *
+ * \param second_dia Small input DIA, which is broadcast to all hosts.
+ *
+ * \param key_extractor1 Key extractor function for items of the first DIA.
+ *
+ * \param key_extractor2 Key extractor function for items of the second DIA.
+ *
+ * \param join_function Join function, which is applied to each pair of items
+ * with equal keys and delivers an item of the output DIA.
+ *
+ * \param hash_function Hash function for the keys.
+ *
+ * \ingroup dia_dops
+ */
+template <typename FirstDIA, typename SecondDIA,
+          typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction,
+          typename HashFunction =
+              std::hash<typename common::FunctionTraits<KeyExtractor1>::result_type> >
+auto InnerJoin(struct BroadcastTag,
+               const FirstDIA &first_dia, const SecondDIA &second_dia,
+               const KeyExtractor1 &key_extractor1,
+               const KeyExtractor2 &key_extractor2,
+               const JoinFunction &join_function,
+               const HashFunction &hash_function = HashFunction()) {
+
+    first_dia.AssertValid();
+    second_dia.AssertValid();
+
+    using InputTypeFirst = typename FirstDIA::ValueType;
+    using InputTypeSecond = typename SecondDIA::ValueType;
+    using Key = typename common::FunctionTraits<KeyExtractor1>::result_type;
+
+    static_assert(
+        std::is_convertible<
+            InputTypeFirst,
+            typename common::FunctionTraits<KeyExtractor1>::template arg<0>
+            >::value,
+        "KeyExtractor1 has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeSecond,
+            typename common::FunctionTraits<KeyExtractor2>::template arg<0>
+            >::value,
+        "KeyExtractor2 has the wrong input type");
+
+    static_assert(
+        std::is_same<
+            Key,
+            typename common::FunctionTraits<KeyExtractor2>::result_type>::value,
+        "KeyExtractor1 and KeyExtractor2 must return the same key type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeFirst,
+            typename common::FunctionTraits<JoinFunction>::template arg<0>
+            >::value,
+        "JoinFunction has the wrong first input type");
+
+    static_assert(
+        std::is_convertible<
+            InputTypeSecond,
+            typename common::FunctionTraits<JoinFunction>::template arg<1>
+            >::value,
+        "JoinFunction has the wrong second input type");
+
+    using JoinResult =
+              typename common::FunctionTraits<JoinFunction>::result_type;
+
+    using BroadcastNode = api::BroadcastHashTableNode<
+              InputTypeSecond, Key, KeyExtractor2, HashFunction>;
+    using HashTable = typename BroadcastNode::HashTable;
+
+    std::shared_ptr<const HashTable> table;
+
+    auto node = common::MakeCounting<BroadcastNode>(
+        second_dia, key_extractor2, hash_function, &table);
+    node->RunScope();
+
+    return first_dia.template FlatMap<JoinResult>(
+        [table, key_extractor1, join_function](
+            const InputTypeFirst& a, auto emit_func) {
+            typename HashTable::GroupIterator iter =
+                table->Find(key_extractor1(a));
+            while (iter.HasNext())
+                emit_func(join_function(a, iter.Next()));
+        });
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename SecondDIA>
+auto DIA<ValueType, Stack>::InnerJoin(
+    const SecondDIA &second_dia, const KeyExtractor1 &key_extractor1,
+    const KeyExtractor2 &key_extractor2,
+    const JoinFunction &join_function) const {
+    return api::InnerJoin(*this, second_dia, key_extractor1, key_extractor2,
+                          join_function);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor1, typename KeyExtractor2,
+          typename JoinFunction, typename SecondDIA>
+auto DIA<ValueType, Stack>::InnerJoin(
+    struct BroadcastTag, const SecondDIA &second_dia,
+    const KeyExtractor1 &key_extractor1, const KeyExtractor2 &key_extractor2,
+    const JoinFunction &join_function) const {
+    return api::InnerJoin(BroadcastTag, *this, second_dia, key_extractor1,
+                          key_extractor2, join_function);
+}
+
+} // namespace api
+
+//! imported from api namespace
+using api::InnerJoin;
+
+} // namespace thrill
+
+#endif // !THRILL_API_INNER_JOIN_HEADER
+
+/******************************************************************************/
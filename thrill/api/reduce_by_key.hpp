@@ -23,9 +23,11 @@
 #include <thrill/common/meta.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/core/reduce_by_hash_post_stage.hpp>
+#include <thrill/core/reduce_by_sort_post_stage.hpp>
 #include <thrill/core/reduce_pre_stage.hpp>
 
 #include <functional>
+#include <memory>
 #include <thread>
 #include <type_traits>
 #include <typeinfo>
@@ -54,6 +56,11 @@ class DefaultReduceConfig : public core::DefaultReduceConfig
  * \tparam VolatileKey Whether to reuse the key once extracted in during pre reduce
  * (false) or let the post reduce extract the key again (true).
  *
+ * If ReduceConfig::use_sort_fallback_ is set, the post stage starts hashing
+ * and a cost model evaluates the cardinality of the keys received so far. If
+ * most keys are distinct, the hash table would spill most items, hence the
+ * post stage switches to sorting runs and merging them.
+ *
  * \ingroup api_layer
  */
 template <typename ValueType,
@@ -76,6 +83,10 @@ class ReduceNode final : public DOpNode<ValueType>
 
     static constexpr bool use_mix_stream_ = ReduceConfig::use_mix_stream_;
     static constexpr bool use_post_thread_ = ReduceConfig::use_post_thread_;
+    static constexpr bool use_sort_fallback_ = ReduceConfig::use_sort_fallback_;
+
+    //! selects the implementation of the post stage
+    using UseSortFallback = std::integral_constant<bool, use_sort_fallback_>;
 
 private:
     //! Emitter for PostStage to push elements to next DIA object.
@@ -115,6 +126,9 @@ public:
               context_, Super::id(), key_extractor, reduce_function,
               Emitter(this), config)
     {
+        MakeSortStage(key_extractor, reduce_function, config,
+                      UseSortFallback());
+
         // Hook PreOp: Locally hash elements of the current DIA onto buckets and
         // reduce each bucket to a single value, afterwards send data to another
         // worker given by the shuffle algorithm.
@@ -173,7 +187,7 @@ public:
 
             reduced_ = true;
         }
-        post_stage_.PushData(consume);
+        PushPostStage(consume, UseSortFallback());
     }
 
     //! process the inbound data in the post reduce stage
@@ -184,7 +198,8 @@ public:
             sLOG << "reading data from" << mix_stream_->id()
                  << "to push into post stage which flushes to" << this->id();
             while (reader.HasNext()) {
-                post_stage_.Insert(reader.template Next<PreStageOutput>());
+                InsertPostStage(reader.template Next<PreStageOutput>(),
+                                UseSortFallback());
             }
         }
         else
@@ -193,13 +208,14 @@ public:
             sLOG << "reading data from" << cat_stream_->id()
                  << "to push into post stage which flushes to" << this->id();
             while (reader.HasNext()) {
-                post_stage_.Insert(reader.template Next<PreStageOutput>());
+                InsertPostStage(reader.template Next<PreStageOutput>(),
+                                UseSortFallback());
             }
         }
     }
 
     void Dispose() final {
-        post_stage_.Dispose();
+        DisposePostStage(UseSortFallback());
     }
 
 private:
@@ -222,6 +238,127 @@ private:
         ReduceConfig> post_stage_;
 
     bool reduced_ = false;
+
+    //! \name Sort Fallback of the Post Stage
+    //! \{
+
+    using SortPostStage = core::ReduceBySortPostStage<
+              ValueType, Key, Value, KeyExtractor, ReduceFunction, Emitter,
+              SendPair, ReduceConfig>;
+
+    //! sort-based post stage, only constructed if use_sort_fallback_
+    std::unique_ptr<SortPostStage> sort_stage_;
+
+    //! whether the sort-based post stage replaced the hash table
+    bool use_sort_ = false;
+
+    //! whether the cost model has decided between hashing and sorting
+    bool sort_decided_ = false;
+
+    //! number of items inserted into the post stage
+    size_t post_inserted_ = 0;
+
+    void MakeSortStage(const KeyExtractor&, const ReduceFunction&,
+                       const ReduceConfig&,
+                       std::false_type /* use_sort_fallback */) { }
+
+    void InsertPostStage(const PreStageOutput& item,
+                         std::false_type /* use_sort_fallback */) {
+        post_stage_.Insert(item);
+    }
+
+    void PushPostStage(bool consume, std::false_type /* use_sort_fallback */) {
+        post_stage_.PushData(consume);
+    }
+
+    void DisposePostStage(std::false_type /* use_sort_fallback */) {
+        post_stage_.Dispose();
+    }
+
+    void MakeSortStage(const KeyExtractor& key_extractor,
+                       const ReduceFunction& reduce_function,
+                       const ReduceConfig& config,
+                       std::true_type /* use_sort_fallback */) {
+        sort_stage_ = std::make_unique<SortPostStage>(
+            context_, Super::id(), key_extractor, reduce_function,
+            Emitter(this), config);
+    }
+
+    void InsertPostStage(const PreStageOutput& item,
+                         std::true_type /* use_sort_fallback */) {
+        if (use_sort_)
+            return sort_stage_->Insert(item);
+
+        post_stage_.Insert(item);
+
+        if (!sort_decided_ &&
+            ++post_inserted_ % ReduceConfig::sort_fallback_sample_ == 0)
+            EvaluateSortFallback();
+    }
+
+    void PushPostStage(bool consume, std::true_type /* use_sort_fallback */) {
+        if (use_sort_)
+            sort_stage_->PushData(consume);
+        else
+            post_stage_.PushData(consume);
+    }
+
+    void DisposePostStage(std::true_type /* use_sort_fallback */) {
+        post_stage_.Dispose();
+        sort_stage_->Dispose();
+    }
+
+    //! Cost model: once the hash table is filled to some degree, the fraction
+    //! of distinct keys inserted so far estimates the cardinality. If most
+    //! keys are distinct, the table will spill most items, possibly
+    //! repeatedly, while sorting writes each item only once into a run.
+    void EvaluateSortFallback() {
+        auto& table = post_stage_.table();
+
+        if (table.has_spilled_data()) {
+            // too late to switch cheaply, keep hashing.
+            sort_decided_ = true;
+            return;
+        }
+
+        const double capacity = static_cast<double>(
+            table.limit_items_per_partition() * table.num_partitions());
+        const double num_items = static_cast<double>(table.num_items());
+
+        if (num_items < capacity * ReduceConfig::sort_fallback_min_fill_)
+            return;
+
+        sort_decided_ = true;
+
+        if (num_items < static_cast<double>(post_inserted_)
+            * ReduceConfig::sort_fallback_min_distinct_)
+            return;
+
+        sLOG << "ReduceNode: switching post stage to sorting after"
+             << post_inserted_ << "items with" << table.num_items()
+             << "distinct keys";
+
+        // move the items out of the hash table before releasing it, such that
+        // the sort stage can use the same amount of RAM.
+        const size_t limit_memory_bytes = table.limit_memory_bytes();
+
+        for (size_t id = 0; id < table.num_partitions(); ++id)
+            table.SpillPartition(id);
+
+        std::vector<data::File> files = std::move(table.partition_files());
+        post_stage_.Dispose();
+
+        sort_stage_->Initialize(limit_memory_bytes);
+        for (data::File& file : files) {
+            data::File::ConsumeReader reader = file.GetConsumeReader();
+            while (reader.HasNext())
+                sort_stage_->Insert(reader.template Next<KeyValuePair>());
+        }
+
+        use_sort_ = true;
+    }
+
+    //! \}
 };
 
 template <typename ValueType, typename Stack>
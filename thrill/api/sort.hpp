@@ -19,24 +19,95 @@
 #include <thrill/api/dop_node.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/common/porting.hpp>
 #include <thrill/common/qsort.hpp>
+#include <thrill/common/radix_sort.hpp>
+#include <thrill/core/forecast_prefetcher.hpp>
 #include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/parallel_multiway_merge.hpp>
 #include <thrill/data/file.hpp>
+#include <thrill/io/config_file.hpp>
 #include <thrill/net/group.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <deque>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace api {
 
+//! Enum class to select how the SortNode determines the global splitters from
+//! the samples drawn on each worker.
+enum class SortSplitterSelection {
+    //! send all samples to worker 0, sort them there and send the splitters
+    //! back to all workers.
+    GATHER_ROOT,
+    //! sort samples locally on each worker, then merge and downsample them
+    //! along a binomial reduction tree and broadcast the splitters.
+    TREE_REDUCE
+};
+
+/*!
+ * Configuration class to define operational parameters of the SortNode. All
+ * members are read via the SortNode's copy of the config, hence they can be
+ * defined static constexpr or be mutable variables. Not all members need to be
+ * used by all algorithms.
+ */
+class DefaultSortConfig
+{
+public:
+    //! select the splitter selection algorithm by enum
+    static constexpr SortSplitterSelection splitter_selection_ =
+        SortSplitterSelection::GATHER_ROOT;
+
+    //! only for TREE_REDUCE: number of weighted samples per worker kept on each
+    //! level of the reduction tree. The total sample size on any level is
+    //! bounded by this times the number of workers.
+    static constexpr size_t tree_samples_per_worker_ = 64;
+
+    //! number of data exchange levels. With one level, all workers send items
+    //! directly to all other workers. With l > 1 levels, the group of workers
+    //! is recursively partitioned into about p^(1/l) subgroups on each level,
+    //! such that each worker transmits data to only p^(1/l) other workers per
+    //! level. Only the first level uses splitter_selection_, the deeper levels
+    //! gather the samples at the first worker of each group.
+    static constexpr size_t sort_levels_ = 1;
+
+    //! pipeline receiving and run formation on the last level: a background
+    //! thread receives items while this worker still transmits, and full runs
+    //! are sorted and written to Files by another thread while the next run is
+    //! received into the second half of the memory.
+    static constexpr bool use_background_thread_ = false;
+
+    //! number of threads of the host-wide ThreadPool used for the final
+    //! multiway merge of the runs. 0 selects the number of cores per worker.
+    static constexpr size_t merge_threads_ = 0;
+
+    //! minimum number of items per thread for merging in parallel, since
+    //! splitting the runs requires binary searches in the Files.
+    static constexpr size_t parallel_merge_min_items_ = 65536;
+
+    //! number of Blocks per regular disk in the io::Config reserved for
+    //! prefetching in partial merges of an external sort. This bounds the
+    //! merge degree such that all disks can be kept busy.
+    static constexpr size_t merge_prefetch_per_disk_ = 4;
+
+    //! prefetch Blocks in partial merges in the order in which the merge
+    //! needs them (by their first items), instead of a fixed number per run.
+    static constexpr bool use_forecast_prefetch_ = true;
+};
+
 /*!
  * A DIANode which performs a Sort operation. Sort sorts a DIA according to a
  * given compare function
@@ -48,9 +119,14 @@ namespace api {
  *
  * \tparam CompareFunction Type of the compare function
  *
+ * \tparam SortConfig Configuration class selecting the distributed algorithms
+ *
+ * \tparam Stable Whether equal items keep the order of the input DIA
+ *
  * \ingroup api_layer
  */
-template <typename ValueType, typename CompareFunction, typename SortAlgorithm>
+template <typename ValueType, typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig = DefaultSortConfig, bool Stable = false>
 class SortNode final : public DOpNode<ValueType>
 {
     static constexpr bool debug = false;
@@ -68,7 +144,18 @@ class SortNode final : public DOpNode<ValueType>
 
     using SampleIndexPair = std::pair<ValueType, size_t>;
 
-    static const bool use_background_thread_ = false;
+    //! sample with the number of original samples it represents, used by the
+    //! TREE_REDUCE splitter selection.
+    using WeightedSample = std::pair<SampleIndexPair, size_t>;
+
+    //! number of items classified at once in TransmitItems()
+    static constexpr size_t classify_batch_size_ = 256;
+
+    //! stream used for the data exchange. Stable sorting needs to receive the
+    //! items of all senders in order of their rank.
+    using DataStream = typename std::conditional<
+              Stable, data::CatStream, data::MixStream>::type;
+    using DataStreamPtr = common::CountingPtr<DataStream>;
 
 public:
     /*!
@@ -77,10 +164,12 @@ public:
     template <typename ParentDIA>
     SortNode(const ParentDIA& parent,
              const CompareFunction& compare_function,
-             const SortAlgorithm& sort_algorithm = SortAlgorithm())
+             const SortAlgorithm& sort_algorithm = SortAlgorithm(),
+             const SortConfig& config = SortConfig())
         : Super(parent.ctx(), "Sort", { parent.id() }, { parent.node() }),
           compare_function_(compare_function),
           sort_algorithm_(sort_algorithm),
+          config_(config),
           parent_stack_empty_(ParentDIA::stack_empty)
     {
         // Hook PreOp(s)
@@ -179,22 +268,159 @@ public:
         }
     }
 
-    //! calculate maximum merging degree from available memory and the number of
-    //! files. additionally calculate the prefetch size of each File.
-    std::pair<size_t, size_t> MaxMergeDegreePrefetch() {
-        size_t avail_blocks = DIABase::mem_limit_ / data::default_block_size;
-        if (files_.size() >= avail_blocks) {
-            // more files than blocks available -> partial merge of avail_blocks
-            // Files with prefetch = 0, which is one read Block per File.
-            return std::make_pair(avail_blocks, 0u);
+    //! number of Blocks which fit into the memory limit
+    size_t AvailableBlocks() const {
+        return std::max<size_t>(
+            DIABase::mem_limit_ / data::default_block_size, 3);
+    }
+
+    //! maximum number of Files merged in the final merge, which needs one
+    //! Block per File.
+    size_t MaxFinalMergeDegree() const {
+        return AvailableBlocks() - 1;
+    }
+
+    //! calculate the prefetch size of each File in the final merge, the
+    //! available Blocks are split equally among the Files.
+    size_t FinalMergePrefetch() const {
+        return std::min<size_t>(
+            16u, AvailableBlocks() / std::max<size_t>(files_.size(), 1) - 1);
+    }
+
+    //! plan the partial merges of an external sort: the degree of partial
+    //! merges is chosen such that the Files can be reduced to the final merge
+    //! in the minimum number of passes, while all passes have about the same
+    //! degree. All Blocks not used by the merge's readers and the writer are
+    //! available for prefetching, of which at least merge_prefetch_per_disk_
+    //! per regular disk are reserved.
+    size_t PartialMergeDegree() const {
+        const size_t avail_blocks = AvailableBlocks();
+        const size_t num_files = files_.size();
+
+        io::Config& config = *io::Config::GetInstance();
+        size_t num_disks = 0;
+        if (config.disks_number() != 0) {
+            std::pair<unsigned, unsigned> r = config.regular_disk_range();
+            num_disks = r.second - r.first;
+        }
+        num_disks = std::max<size_t>(num_disks, 1);
+
+        // one Block per input File, one for the writer, the rest prefetches.
+        size_t reserve = std::min(
+            num_disks * config_.merge_prefetch_per_disk_, avail_blocks / 2);
+        size_t max_degree = std::max<size_t>(avail_blocks - reserve - 1, 2);
+
+        // number of merge levels including the final merge, then balance the
+        // degree of all levels.
+        size_t levels = static_cast<size_t>(
+            std::ceil(std::log(num_files) / std::log(max_degree)));
+        levels = std::max<size_t>(levels, 1);
+
+        size_t degree = static_cast<size_t>(
+            std::ceil(std::pow(num_files, 1.0 / levels)));
+        return std::max<size_t>(std::min(degree, max_degree), 2);
+    }
+
+    //! Allow a helper thread to run on all cpus of this worker's NUMA node.
+    //! Threads inherit the affinity of the worker, which is pinned to a single
+    //! cpu, hence they would otherwise compete with the worker for it.
+    void SetHelperThreadAffinity(std::thread& thread) {
+        const common::NumaTopology& topology = common::NumaTopology::Get();
+        size_t node = context_.block_pool().worker_numa_node(
+            context_.local_worker_id());
+        common::SetCpuAffinity(
+            thread, topology.node_cpus(
+                std::min(node, topology.num_nodes() - 1)));
+    }
+
+    //! calculate the number of threads used for the final merge of the
+    //! files, returns 1 for a sequential merge.
+    size_t MergeThreads() const {
+        return core::ParallelMergeThreads(
+            files_.begin(), files_.end(), config_.merge_threads_,
+            context_.workers_per_host(), config_.parallel_merge_min_items_,
+            DIABase::mem_limit_);
+    }
+
+    //! create a multiway merge tree over the readers, which is stable if the
+    //! SortNode is.
+    template <typename ReaderIterator>
+    auto MakeMergeTree(ReaderIterator begin, ReaderIterator end) {
+        return core::MultiwayMergeTree<
+            ValueType, ReaderIterator, CompareFunction, Stable>(
+            begin, end, compare_function_);
+    }
+
+    //! merge consecutive Files starting at partial_merge_pos_ and replace them
+    //! by the merged File, as planned by PartialMergeDegree(). Hence, the Files
+    //! are merged in passes and stay in the order of their runs. The last
+    //! partial merge only merges as many Files as needed for the final merge.
+    void PartialMerge() {
+        if (partial_merge_pos_ + 1 >= files_.size())
+            partial_merge_pos_ = 0;
+
+        const size_t begin = partial_merge_pos_;
+        size_t merge_degree = std::min(
+            PartialMergeDegree(), files_.size() - MaxFinalMergeDegree() + 1);
+        merge_degree = std::max<size_t>(merge_degree, 2);
+        merge_degree = std::min(merge_degree, files_.size() - begin);
+
+        // Blocks not needed by the readers and the writer
+        size_t prefetch = AvailableBlocks() - merge_degree - 1;
+
+        sLOG1 << "Partial multi-way-merge of"
+              << merge_degree << "files with prefetch" << prefetch;
+
+        // create merger for merge_degree Files
+        std::vector<data::File::ConsumeReader> seq;
+        seq.reserve(merge_degree);
+
+        for (size_t t = begin; t < begin + merge_degree; ++t)
+            seq.emplace_back(files_[t].GetConsumeReader(0));
+
+        // pin the first Blocks before the merge tree reads them
+        std::unique_ptr<core::ForecastPrefetcher<ValueType, CompareFunction> >
+        forecast;
+        if (config_.use_forecast_prefetch_) {
+            std::vector<const std::vector<ValueType>*> triggers;
+            for (size_t t = begin; t < begin + merge_degree; ++t)
+                triggers.push_back(&run_triggers_[t]);
+            forecast = std::make_unique<
+                core::ForecastPrefetcher<ValueType, CompareFunction> >(
+                seq, triggers, prefetch, compare_function_);
         }
         else {
-            // less files than available Blocks -> split blocks equally among
-            // Files.
-            return std::make_pair(
-                files_.size(),
-                std::min<size_t>(16u, (avail_blocks / files_.size()) - 1));
+            StartPrefetch(seq, prefetch / merge_degree);
+        }
+
+        auto puller = MakeMergeTree(seq.begin(), seq.end());
+
+        // create new File for merged items
+        data::File file = context_.GetFile(this);
+        std::vector<ValueType> triggers;
+        auto writer = file.GetWriter();
+        core::TriggerRecorder<ValueType> recorder(file, triggers);
+
+        while (puller.HasNext()) {
+            recorder.Put(writer, puller.Next());
+            if (forecast) forecast->Poll();
         }
+        writer.Close();
+        recorder.Finish();
+
+        // this clear is important to release references to the files.
+        forecast.reset();
+        seq.clear();
+
+        // replace merged files
+        files_.erase(files_.begin() + begin + 1,
+                     files_.begin() + begin + merge_degree);
+        files_[begin] = std::move(file);
+        run_triggers_.erase(run_triggers_.begin() + begin + 1,
+                            run_triggers_.begin() + begin + merge_degree);
+        run_triggers_[begin] = std::move(triggers);
+
+        partial_merge_pos_ = begin + 1;
     }
 
     void PushData(bool consume) final {
@@ -210,64 +436,55 @@ public:
             this->PushFile(files_[0], consume);
         }
         else {
-            size_t merge_degree, prefetch;
-
             // merge batches of files if necessary
-            while (files_.size() > MaxMergeDegreePrefetch().first)
-            {
-                std::tie(merge_degree, prefetch) = MaxMergeDegreePrefetch();
+            while (files_.size() > MaxFinalMergeDegree())
+                PartialMerge();
 
-                sLOG1 << "Partial multi-way-merge of"
-                      << merge_degree << "files with prefetch" << prefetch;
+            size_t prefetch = FinalMergePrefetch();
 
-                // create merger for first merge_degree_ Files
-                std::vector<data::File::ConsumeReader> seq;
-                seq.reserve(merge_degree);
+            size_t merge_threads = MergeThreads();
 
-                for (size_t t = 0; t < merge_degree; ++t)
-                    seq.emplace_back(files_[t].GetConsumeReader(0));
+            if (merge_threads > 1) {
+                sLOG1 << "Start parallel multi-way-merge of" << files_.size()
+                      << "files with" << merge_threads << "threads";
 
-                StartPrefetch(seq, prefetch);
-
-                auto puller = core::make_multiway_merge_tree<ValueType>(
-                    seq.begin(), seq.end(), compare_function_);
-
-                // create new File for merged items
-                files_.emplace_back(context_.GetFile(this));
-                auto writer = files_.back().GetWriter();
+                // merge ranges of the Files in the host-wide ThreadPool
+                core::ParallelMultiwayMergeTree<
+                    ValueType, CompareFunction, Stable>
+                puller(files_.begin(), files_.end(), consume,
+                       compare_function_, context_.thread_pool(), merge_threads,
+                       context_.block_pool(), context_.local_worker_id(),
+                       this->id());
 
                 while (puller.HasNext()) {
-                    writer.Put(puller.Next());
+                    this->PushItem(puller.Next());
+                    local_size++;
                 }
-                writer.Close();
 
-                // this clear is important to release references to the files.
-                seq.clear();
-
-                // remove merged files
-                files_.erase(files_.begin(), files_.begin() + merge_degree);
+                if (consume) {
+                    files_.clear();
+                    run_triggers_.clear();
+                }
             }
+            else {
+                sLOG1 << "Start multi-way-merge of" << files_.size() << "files"
+                      << "with prefetch" << prefetch;
 
-            std::tie(merge_degree, prefetch) = MaxMergeDegreePrefetch();
-
-            sLOG1 << "Start multi-way-merge of" << files_.size() << "files"
-                  << "with prefetch" << prefetch;
-
-            // construct output merger of remaining Files
-            std::vector<data::File::Reader> seq;
-            seq.reserve(files_.size());
+                // construct output merger of remaining Files
+                std::vector<data::File::Reader> seq;
+                seq.reserve(files_.size());
 
-            for (size_t t = 0; t < files_.size(); ++t)
-                seq.emplace_back(files_[t].GetReader(consume, 0));
+                for (size_t t = 0; t < files_.size(); ++t)
+                    seq.emplace_back(files_[t].GetReader(consume, 0));
 
-            StartPrefetch(seq, prefetch);
+                StartPrefetch(seq, prefetch);
 
-            auto puller = core::make_multiway_merge_tree<ValueType>(
-                seq.begin(), seq.end(), compare_function_);
+                auto puller = MakeMergeTree(seq.begin(), seq.end());
 
-            while (puller.HasNext()) {
-                this->PushItem(puller.Next());
-                local_size++;
+                while (puller.HasNext()) {
+                    this->PushItem(puller.Next());
+                    local_size++;
+                }
             }
         }
 
@@ -283,6 +500,7 @@ public:
 
     void Dispose() final {
         files_.clear();
+        run_triggers_.clear();
     }
 
 private:
@@ -292,6 +510,9 @@ private:
     //! Sort function class
     SortAlgorithm sort_algorithm_;
 
+    //! config of the SortNode
+    SortConfig config_;
+
     //! Whether the parent stack is empty
     const bool parent_stack_empty_;
 
@@ -330,6 +551,11 @@ private:
 
     //! Local data files
     std::deque<data::File> files_;
+    //! first item of each Block of the local data files, used for forecasting
+    //! prefetches in partial merges.
+    std::deque<std::vector<ValueType> > run_triggers_;
+    //! position of the next partial merge in files_
+    size_t partial_merge_pos_ = 0;
     //! Total number of local elements after communication
     size_t local_out_size_ = 0;
 
@@ -349,43 +575,141 @@ private:
 
     //! \}
 
-    void FindAndSendSplitters(
-        std::vector<SampleIndexPair>& splitters, size_t sample_size,
-        data::MixStreamPtr& sample_stream,
-        std::vector<data::MixStream::Writer>& sample_writers) {
+    //! Pick splitters from a sorted vector of weighted samples: the first
+    //! splitter of each subgroup j > 0 is positioned proportionally to the
+    //! number of workers preceding subgroup j.
+    static void PickSplitters(
+        const std::vector<WeightedSample>& samples,
+        const std::vector<size_t>& subgroup_begin,
+        std::vector<SampleIndexPair>& splitters) {
 
-        // Get samples from other workers
-        size_t num_total_workers = context_.num_workers();
+        if (samples.size() == 0) return;
 
-        std::vector<SampleIndexPair> samples;
-        samples.reserve(sample_size * num_total_workers);
+        size_t total_weight = 0;
+        for (const WeightedSample& s : samples)
+            total_weight += s.second;
 
-        auto reader = sample_stream->GetMixReader(/* consume */ true);
+        size_t group_begin = subgroup_begin.front();
+        size_t group_size = subgroup_begin.back() - group_begin;
 
-        while (reader.HasNext()) {
-            samples.push_back(reader.template Next<SampleIndexPair>());
+        size_t weight_before = 0;
+        typename std::vector<WeightedSample>::const_iterator it =
+            samples.begin();
+
+        for (size_t j = 1; j + 1 < subgroup_begin.size(); ++j) {
+            size_t pos =
+                (subgroup_begin[j] - group_begin) * total_weight / group_size;
+            while (weight_before + it->second <= pos) {
+                weight_before += it->second;
+                ++it;
+            }
+            splitters.push_back(it->first);
         }
-        if (samples.size() == 0) return;
+    }
 
-        // Find splitters
-        std::sort(samples.begin(), samples.end(),
-                  [this](
-                      const SampleIndexPair& a, const SampleIndexPair& b) {
-                      return LessSampleIndex(a, b);
-                  });
+    //! Select max_size items from a sorted vector of weighted samples, each
+    //! representing an equal slice of the total weight.
+    static std::vector<WeightedSample> DownsampleWeighted(
+        const std::vector<WeightedSample>& samples, size_t max_size) {
+
+        if (samples.size() <= max_size) return samples;
+
+        size_t total_weight = 0;
+        for (const WeightedSample& s : samples)
+            total_weight += s.second;
 
-        size_t splitting_size = samples.size() / num_total_workers;
+        std::vector<WeightedSample> out;
+        out.reserve(max_size);
 
-        // Send splitters to other workers
-        for (size_t i = 1; i < num_total_workers; ++i) {
-            splitters.push_back(samples[i * splitting_size]);
-            for (size_t j = 1; j < num_total_workers; j++) {
-                sample_writers[j].Put(splitters.back());
+        // since every sample has weight >= 1 and samples.size() > max_size,
+        // each slice has a weight of at least one.
+        size_t weight_before = 0;
+        typename std::vector<WeightedSample>::const_iterator it =
+            samples.begin();
+
+        for (size_t k = 0; k < max_size; ++k) {
+            size_t slice_begin = k * total_weight / max_size;
+            size_t slice_end = (k + 1) * total_weight / max_size;
+            size_t slice_mid = (slice_begin + slice_end) / 2;
+
+            // advance to the sample covering the middle of the slice
+            while (weight_before + it->second <= slice_mid) {
+                weight_before += it->second;
+                ++it;
             }
+            out.emplace_back(it->first, slice_end - slice_begin);
+        }
+
+        return out;
+    }
+
+    //! Reduction operator for the TREE_REDUCE splitter selection: merges two
+    //! sorted weighted sample vectors and downsamples the result.
+    class WeightedSampleMerge
+    {
+    public:
+        WeightedSampleMerge(SortNode& node, size_t max_size)
+            : node_(node), max_size_(max_size) { }
+
+        std::vector<WeightedSample> operator () (
+            const std::vector<WeightedSample>& a,
+            const std::vector<WeightedSample>& b) const {
+
+            std::vector<WeightedSample> merged;
+            merged.reserve(a.size() + b.size());
+
+            std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                       std::back_inserter(merged),
+                       [this](const WeightedSample& x, const WeightedSample& y) {
+                           return node_.LessSampleIndex(x.first, y.first);
+                       });
+
+            return DownsampleWeighted(merged, max_size_);
+        }
+
+    private:
+        SortNode& node_;
+        size_t max_size_;
+    };
+
+    /*!
+     * Determine splitters without collecting all samples on one worker: each
+     * worker sorts its samples, then they are pairwise merged along the
+     * binomial tree of FlowControlChannel::Reduce(). After each merge the
+     * samples are reduced to at most tree_samples_per_worker_ * p weighted
+     * quantiles, hence no worker ever holds more than that and the depth is
+     * O(log p). The root picks the splitters and broadcasts them.
+     */
+    void SelectSplittersTreeReduce(
+        std::vector<SampleIndexPair>& splitters, size_t prefix_items,
+        const std::vector<size_t>& subgroup_begin) {
+
+        size_t num_total_workers = context_.num_workers();
+        size_t max_size = num_total_workers * config_.tree_samples_per_worker_;
+
+        std::sort(samples_.begin(), samples_.end(),
+                  [this](const SampleIndexPair& a, const SampleIndexPair& b) {
+                      return LessSampleIndex(a, b);
+                  });
+
+        std::vector<WeightedSample> local;
+        local.reserve(samples_.size());
+        for (const SampleIndexPair& sample : samples_) {
+            // add the local prefix to index ranks
+            local.emplace_back(
+                SampleIndexPair(sample.first, prefix_items + sample.second), 1);
         }
+        std::vector<SampleIndexPair>().swap(samples_);
+
+        std::vector<WeightedSample> reduced = context_.net.Reduce(
+            DownsampleWeighted(local, max_size), /* root */ 0,
+            WeightedSampleMerge(*this, max_size));
+        std::vector<WeightedSample>().swap(local);
+
+        if (context_.my_rank() == 0)
+            PickSplitters(reduced, subgroup_begin, splitters);
 
-        for (size_t j = 1; j < num_total_workers; ++j)
-            sample_writers[j].Close();
+        splitters = context_.net.Broadcast(splitters);
     }
 
     class TreeBuilder
@@ -432,14 +756,46 @@ private:
             !compare_function_(b.first, a.first) && a.second < b.second);
     }
 
-    bool EqualSampleGreaterIndex(const SampleIndexPair& a, const SampleIndexPair& b) {
-        return !compare_function_(a.first, b.first) && a.second >= b.second;
+    //! true if the item with global index equals the splitter but is ordered
+    //! before it by index, hence belongs to the bucket left of the splitter.
+    bool EqualSampleGreaterIndex(
+        const SampleIndexPair& splitter, const ValueType& item, size_t index) {
+        return !compare_function_(splitter.first, item) &&
+               splitter.second >= index;
     }
 
-    //! round n down by k where k is a power of two.
-    template <typename Integral>
-    static inline size_t RoundDown(Integral n, Integral k) {
-        return (n & ~(k - 1));
+    /*!
+     * Classify a batch of items into buckets. The items are run down the
+     * implicit splitter tree level by level, such that the comparisons of
+     * different items are independent and the loop body is branchless, which
+     * lets the CPU overlap them. The bucket of batch[i] is stored in oracle[i].
+     */
+    void ClassifyBatch(
+        const ValueType* const tree, size_t k, size_t log_k,
+        const SampleIndexPair* const sorted_splitters,
+        const std::vector<ValueType>& batch, size_t batch_index,
+        size_t* const oracle) {
+
+        const size_t size = batch.size();
+        std::fill(oracle, oracle + size, 1);
+
+        for (size_t l = 0; l < log_k; l++) {
+            for (size_t i = 0; i < size; i++) {
+                oracle[i] = 2 * oracle[i]
+                            + (compare_function_(batch[i], tree[oracle[i]])
+                               ? 0 : 1);
+            }
+        }
+
+        // items equal to a splitter are distributed by their global index
+        for (size_t i = 0; i < size; i++) {
+            size_t b = oracle[i] - k;
+            while (b && EqualSampleGreaterIndex(
+                       sorted_splitters[b - 1], batch[i], batch_index + i)) {
+                b--;
+            }
+            oracle[i] = b;
+        }
     }
 
     void TransmitItems(
@@ -452,14 +808,12 @@ private:
         size_t actual_k,
         const SampleIndexPair* const sorted_splitters,
         size_t prefix_items,
-        data::MixStreamPtr& data_stream) {
+        // one Writer per bucket
+        std::vector<typename DataStream::Writer>& data_writers) {
 
         data::File::ConsumeReader unsorted_reader =
             unsorted_file_.GetConsumeReader();
 
-        std::vector<data::MixStream::Writer> data_writers =
-            data_stream->GetWriters();
-
         // enlarge emitters array to next power of two to have direct access,
         // because we fill the splitter set up with sentinels == last splitter,
         // hence all items land in the last bucket.
@@ -471,75 +825,31 @@ private:
 
         std::swap(data_writers[actual_k - 1], data_writers[k - 1]);
 
-        // classify all items (take two at once) and immediately transmit them.
-
-        const size_t stepsize = 2;
+        // classify the items in batches: read a batch from the file, classify
+        // all of it into the oracle array, then scatter it into the writers.
 
-        size_t i = prefix_items;
-        for ( ; i < prefix_items + RoundDown(local_items_, stepsize); i += stepsize)
-        {
-            // take two items
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
-
-            size_t j1 = 1;
-            ValueType el1 = unsorted_reader.Next<ValueType>();
-
-            // run items down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-                j1 = 2 * j1 + (compare_function_(el1, tree[j1]) ? 0 : 1);
-            }
+        std::vector<ValueType> batch;
+        batch.reserve(classify_batch_size_);
+        std::vector<size_t> oracle(classify_batch_size_);
 
-            size_t b0 = j0 - k;
-            size_t b1 = j1 - k;
+        const size_t end = prefix_items + local_items_;
 
-            while (b0 && EqualSampleGreaterIndex(
-                       sorted_splitters[b0 - 1], SampleIndexPair(el0, i + 0))) {
-                b0--;
-
-                // LOG0 << "el0 equal match b0 " << b0
-                //      << " prefix_items " << prefix_items
-                //      << " lhs.first = " << sorted_splitters[b0 - 1].first
-                //      << " lhs.second = " << sorted_splitters[b0 - 1].second
-                //      << " rhs.first = " << el0
-                //      << " rhs.second = " << i;
-            }
-
-            while (b1 && EqualSampleGreaterIndex(
-                       sorted_splitters[b1 - 1], SampleIndexPair(el1, i + 1))) {
-                b1--;
-            }
-
-            assert(data_writers[b0].IsValid());
-            assert(data_writers[b1].IsValid());
-
-            data_writers[b0].Put(el0);
-            data_writers[b1].Put(el1);
-        }
-
-        // last iteration of loop if we have an odd number of items.
-        for ( ; i < prefix_items + local_items_; i++)
+        for (size_t i = prefix_items; i < end; i += batch.size())
         {
-            size_t j0 = 1;
-            ValueType el0 = unsorted_reader.Next<ValueType>();
-
-            // run item down the tree
-            for (size_t l = 0; l < log_k; l++)
-            {
-                j0 = 2 * j0 + (compare_function_(el0, tree[j0]) ? 0 : 1);
-            }
-
-            size_t b0 = j0 - k;
-
-            while (b0 && EqualSampleGreaterIndex(
-                       sorted_splitters[b0 - 1], SampleIndexPair(el0, i))) {
-                b0--;
+            batch.clear();
+            size_t batch_size = end - i;
+            if (batch_size > classify_batch_size_)
+                batch_size = classify_batch_size_;
+            for (size_t j = 0; j < batch_size; j++)
+                batch.emplace_back(unsorted_reader.Next<ValueType>());
+
+            ClassifyBatch(tree, k, log_k, sorted_splitters,
+                          batch, i, oracle.data());
+
+            for (size_t j = 0; j < batch_size; j++) {
+                assert(data_writers[oracle[j]].IsValid());
+                data_writers[oracle[j]].Put(batch[j]);
             }
-
-            assert(data_writers[b0].IsValid());
-            data_writers[b0].Put(el0);
         }
 
         // close writers and flush data
@@ -571,11 +881,17 @@ private:
         write_time.Start();
 
         files.emplace_back(context_.GetFile(this));
+        // runs are merged again on each PushData() unless consumed
+        files.back().set_eviction_hint(data::EvictionHint::WillReread);
+        run_triggers_.emplace_back();
         auto writer = files.back().GetWriter();
+        core::TriggerRecorder<ValueType> recorder(
+            files.back(), run_triggers_.back());
         for (const ValueType& elem : vec) {
-            writer.Put(elem);
+            recorder.Put(writer, elem);
         }
         writer.Close();
+        recorder.Finish();
 
         write_time.Stop();
 
@@ -619,53 +935,115 @@ private:
             return;
         }
 
-        // stream to send samples to process 0 and receive them back
-        data::MixStreamPtr sample_stream = context_.GetNewMixStream(this);
+        // range of workers [group_begin, group_end) among which the local
+        // items are partitioned on the current level.
+        size_t group_begin = 0, group_end = num_total_workers;
+        size_t num_levels = std::max(size_t(1), size_t(config_.sort_levels_));
 
-        // Send all samples to worker 0.
-        std::vector<data::MixStream::Writer> sample_writers =
-            sample_stream->GetWriters();
+        for (size_t level = 0; level < num_levels; ++level)
+        {
+            bool last_level = (level + 1 == num_levels);
+            size_t group_size = group_end - group_begin;
+
+            // number of subgroups to partition the current group into: on the
+            // last level every worker is its own subgroup.
+            size_t num_subgroups = group_size;
+            if (!last_level) {
+                double root = std::pow(
+                    static_cast<double>(group_size),
+                    1.0 / static_cast<double>(num_levels - level));
+                num_subgroups = static_cast<size_t>(std::round(root));
+                num_subgroups =
+                    std::max(size_t(1), std::min(num_subgroups, group_size));
+            }
 
-        for (const SampleIndexPair& sample : samples_) {
-            // send samples but add the local prefix to index ranks
-            sample_writers[0].Put(
-                SampleIndexPair(sample.first, prefix_items + sample.second));
+            // first worker of each subgroup, plus a sentinel
+            std::vector<size_t> subgroup_begin(num_subgroups + 1);
+            for (size_t j = 0; j <= num_subgroups; ++j) {
+                subgroup_begin[j] =
+                    group_begin + j * group_size / num_subgroups;
+            }
+
+            if (level != 0) {
+                // items were redistributed, recalculate global indexes
+                prefix_items = context_.net.ExPrefixSum(local_items_);
+            }
+
+            sLOG << "SortNode level" << level
+                 << "group" << group_begin << group_end
+                 << "num_subgroups" << num_subgroups
+                 << "local_items_" << local_items_;
+
+            PartitionItems(level, last_level, prefix_items, subgroup_begin);
+
+            if (!last_level) {
+                // descend into the subgroup containing this worker
+                size_t j = std::upper_bound(
+                    subgroup_begin.begin(), subgroup_begin.end(),
+                    context_.my_rank()) - subgroup_begin.begin() - 1;
+                group_begin = subgroup_begin[j];
+                group_end = subgroup_begin[j + 1];
+            }
+        }
+
+        double balance = 0;
+        if (local_out_size_ > 0) {
+            balance = static_cast<double>(local_out_size_)
+                      * static_cast<double>(num_total_workers)
+                      / static_cast<double>(total_items);
         }
-        sample_writers[0].Close();
-        std::vector<SampleIndexPair>().swap(samples_);
 
-        // Get the ceiling of log(num_total_workers), as SSSS needs 2^n buckets.
-        size_t ceil_log = common::IntegerLog2Ceil(num_total_workers);
+        if (balance > 1) {
+            balance = 1 / balance;
+        }
+
+        Super::logger_
+            << "class" << "SortNode"
+            << "event" << "done"
+            << "workers" << num_total_workers
+            << "local_out_size" << local_out_size_
+            << "balance" << balance
+            << "sample_size" << samples_.size();
+    }
+
+    /*!
+     * Run one level of the sample sort: determine splitters for the given
+     * subgroups, classify all local items and transmit them to one worker in
+     * each subgroup. On the last level the items are received and sorted into
+     * runs, on all others they are stored as the next level's unsorted items.
+     */
+    void PartitionItems(size_t level, bool last_level, size_t prefix_items,
+                        const std::vector<size_t>& subgroup_begin) {
+
+        size_t group_begin = subgroup_begin.front();
+        size_t num_subgroups = subgroup_begin.size() - 1;
+
+        // Get the ceiling of log(num_subgroups), as SSSS needs 2^n buckets.
+        size_t ceil_log = common::IntegerLog2Ceil(num_subgroups);
         size_t workers_algo = size_t(1) << ceil_log;
         size_t splitter_count_algo = workers_algo - 1;
 
         std::vector<SampleIndexPair> splitters;
         splitters.reserve(workers_algo);
 
-        if (context_.my_rank() == 0) {
-            FindAndSendSplitters(splitters, samples_.size(),
-                                 sample_stream, sample_writers);
+        if (level == 0 && config_.splitter_selection_ ==
+            SortSplitterSelection::TREE_REDUCE) {
+            SelectSplittersTreeReduce(splitters, prefix_items, subgroup_begin);
         }
         else {
-            // Close unused emitters
-            for (size_t j = 1; j < num_total_workers; j++) {
-                sample_writers[j].Close();
-            }
-            data::MixStream::MixReader reader =
-                sample_stream->GetMixReader(/* consume */ true);
-            while (reader.HasNext()) {
-                splitters.push_back(reader.template Next<SampleIndexPair>());
-            }
+            SelectSplittersGatherRoot(splitters, prefix_items, subgroup_begin);
         }
-        sample_writers.clear();
-        sample_stream->Close();
+
+        // a group without samples has no items either, fill in dummies.
+        while (splitters.size() + 1 < num_subgroups)
+            splitters.emplace_back(SampleIndexPair());
 
         // code from SS2NPartition, slightly altered
 
         std::vector<ValueType> splitter_tree(workers_algo + 1);
 
         // add sentinel splitters if fewer nodes than splitters.
-        for (size_t i = num_total_workers; i < workers_algo; i++) {
+        for (size_t i = num_subgroups; i < workers_algo; i++) {
             splitters.push_back(splitters.back());
         }
 
@@ -673,59 +1051,151 @@ private:
                     splitters.data(),
                     splitter_count_algo);
 
-        data::MixStreamPtr data_stream = context_.GetNewMixStream(this);
+        DataStreamPtr data_stream =
+            context_.template GetNewStream<DataStream>(this->id());
+
+        // select one Writer into each subgroup, such that the workers of a
+        // subgroup receive data from disjoint ranges of senders. Since the
+        // ranges are ascending, the order of items is kept for stable sorting.
+        std::vector<typename DataStream::Writer> all_writers =
+            data_stream->GetWriters();
+        std::vector<typename DataStream::Writer> data_writers;
+        data_writers.reserve(num_subgroups);
+
+        size_t group_size = subgroup_begin.back() - group_begin;
+        for (size_t j = 0; j < num_subgroups; ++j) {
+            size_t subgroup_size = subgroup_begin[j + 1] - subgroup_begin[j];
+            size_t target =
+                subgroup_begin[j]
+                + (context_.my_rank() - group_begin) * subgroup_size / group_size;
+            data_writers.emplace_back(std::move(all_writers[target]));
+        }
+
+        // close Writers to workers not receiving data from us
+        for (typename DataStream::Writer& w : all_writers)
+            w.Close();
 
         std::thread thread;
-        if (use_background_thread_) {
-            // launch receiver thread.
+        if (config_.use_background_thread_ && last_level) {
+            // launch receiver thread on the cpus of this worker's node.
             thread = common::CreateThread(
                 [this, &data_stream]() {
                     return ReceiveItems(data_stream);
                 });
-            common::SetCpuAffinity(thread, context_.local_worker_id());
+            SetHelperThreadAffinity(thread);
         }
 
         TransmitItems(
             splitter_tree.data(), // Tree. sizeof |splitter|
             workers_algo,         // Number of buckets
             ceil_log,
-            num_total_workers,
+            num_subgroups,
             splitters.data(),
             prefix_items,
-            data_stream);
+            data_writers);
 
         std::vector<ValueType>().swap(splitter_tree);
 
-        if (use_background_thread_)
+        if (!last_level)
+            ReceiveUnsortedItems(data_stream);
+        else if (config_.use_background_thread_)
             thread.join();
         else
             ReceiveItems(data_stream);
 
         data_stream->Close();
+    }
 
-        double balance = 0;
-        if (local_out_size_ > 0) {
-            balance = static_cast<double>(local_out_size_)
-                      * static_cast<double>(num_total_workers)
-                      / static_cast<double>(total_items);
+    /*!
+     * Determine splitters by sending all samples of the group to its first
+     * worker, which sorts them and sends the splitters back to the workers in
+     * the group. On the first level the group contains all workers.
+     */
+    void SelectSplittersGatherRoot(
+        std::vector<SampleIndexPair>& splitters, size_t prefix_items,
+        const std::vector<size_t>& subgroup_begin) {
+
+        size_t group_begin = subgroup_begin.front();
+        size_t group_end = subgroup_begin.back();
+        bool is_leader = (context_.my_rank() == group_begin);
+
+        // stream to send samples to the group leader and receive them back
+        data::MixStreamPtr sample_stream = context_.GetNewMixStream(this);
+
+        // Send all samples to the group leader.
+        std::vector<data::MixStream::Writer> sample_writers =
+            sample_stream->GetWriters();
+
+        for (const SampleIndexPair& sample : samples_) {
+            // send samples but add the local prefix to index ranks
+            sample_writers[group_begin].Put(
+                SampleIndexPair(sample.first, prefix_items + sample.second));
         }
+        sample_writers[group_begin].Close();
+        std::vector<SampleIndexPair>().swap(samples_);
 
-        if (balance > 1) {
-            balance = 1 / balance;
+        // Close unused emitters: the leader keeps the ones into its group open
+        // for sending splitters.
+        for (size_t j = 0; j < sample_writers.size(); j++) {
+            if (!is_leader || j < group_begin || j >= group_end)
+                sample_writers[j].Close();
         }
 
-        Super::logger_
-            << "class" << "SortNode"
-            << "event" << "done"
-            << "workers" << num_total_workers
-            << "local_out_size" << local_out_size_
-            << "balance" << balance
-            << "sample_size" << samples_.size();
+        if (is_leader) {
+            // Get samples from other workers
+            std::vector<WeightedSample> samples;
+
+            auto reader = sample_stream->GetMixReader(/* consume */ true);
+            while (reader.HasNext()) {
+                samples.emplace_back(
+                    reader.template Next<SampleIndexPair>(), 1);
+            }
+
+            // Find splitters
+            std::sort(samples.begin(), samples.end(),
+                      [this](const WeightedSample& a, const WeightedSample& b) {
+                          return LessSampleIndex(a.first, b.first);
+                      });
+
+            PickSplitters(samples, subgroup_begin, splitters);
+
+            // Send splitters to other workers
+            for (size_t j = group_begin + 1; j < group_end; ++j) {
+                for (const SampleIndexPair& splitter : splitters)
+                    sample_writers[j].Put(splitter);
+                sample_writers[j].Close();
+            }
+        }
+        else {
+            data::MixStream::MixReader reader =
+                sample_stream->GetMixReader(/* consume */ true);
+            while (reader.HasNext()) {
+                splitters.push_back(reader.template Next<SampleIndexPair>());
+            }
+        }
+        sample_writers.clear();
+        sample_stream->Close();
+    }
+
+    //! Receive the items of an intermediate level into a new unsorted_file_
+    //! and draw samples for the next level as in PreOp().
+    void ReceiveUnsortedItems(DataStreamPtr& data_stream) {
+
+        unsorted_file_ = context_.GetFile(this);
+        unsorted_writer_ = unsorted_file_.GetWriter();
+        local_items_ = 0;
+        sample_interval_ = 1;
+
+        auto reader = data_stream->GetReader(/* consume */ true);
+        while (reader.HasNext()) {
+            PreOp(reader.template Next<ValueType>());
+        }
+        unsorted_writer_.Close();
     }
 
-    void ReceiveItems(data::MixStreamPtr& data_stream) {
+    void ReceiveItems(DataStreamPtr& data_stream) {
 
-        auto reader = data_stream->GetMixReader(/* consume */ true);
+        auto reader = data_stream->GetReader(/* consume */ true);
 
         LOG << "Writing files";
 
@@ -734,15 +1204,42 @@ private:
         std::vector<ValueType> vec;
         vec.reserve(capacity);
 
+        // in pipelined mode, a full run is moved to sort_vec and sorted and
+        // written by sort_thread while the next run is received into vec.
+        std::vector<ValueType> sort_vec;
+        std::thread sort_thread;
+
+        auto flush =
+            [&]() {
+                if (!config_.use_background_thread_)
+                    return SortAndWriteToFile(vec, files_);
+
+                if (sort_thread.joinable())
+                    sort_thread.join();
+
+                std::swap(vec, sort_vec);
+                vec.reserve(capacity);
+
+                sort_thread = common::CreateThread(
+                    [this, &sort_vec]() {
+                        SortAndWriteToFile(sort_vec, files_);
+                    });
+                SetHelperThreadAffinity(sort_thread);
+            };
+
         while (reader.HasNext()) {
-            if (!mem::memory_exceeded && vec.size() < capacity) {
+            if (vec.size() < capacity &&
+                (!mem::memory_exceeded || vec.empty())) {
                 vec.push_back(reader.template Next<ValueType>());
             }
             else {
-                SortAndWriteToFile(vec, files_);
+                flush();
             }
         }
 
+        if (sort_thread.joinable())
+            sort_thread.join();
+
         if (vec.size())
             SortAndWriteToFile(vec, files_);
 
@@ -794,13 +1291,68 @@ auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function) const
 }
 
 template <typename ValueType, typename Stack>
-template <typename CompareFunction, typename SortAlgorithm>
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
 auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function,
-                                 const SortAlgorithm &sort_algorithm) const {
+                                 const SortAlgorithm &sort_algorithm,
+                                 const SortConfig &sort_config) const {
     assert(IsValid());
 
     using SortNode = api::SortNode<
-              ValueType, CompareFunction, SortAlgorithm>;
+              ValueType, CompareFunction, SortAlgorithm, SortConfig>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    auto node = common::MakeCounting<SortNode>(
+        *this, compare_function, sort_algorithm, sort_config);
+
+    return DIA<ValueType>(node);
+}
+
+class DefaultStableSortAlgorithm
+{
+public:
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end, CompareFunction cmp) const {
+        return std::stable_sort(begin, end, cmp);
+    }
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::SortStable(
+    const CompareFunction &compare_function) const {
+    return SortStable(compare_function, DefaultStableSortAlgorithm());
+}
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction, typename SortAlgorithm,
+          typename SortConfig>
+auto DIA<ValueType, Stack>::SortStable(
+    const CompareFunction &compare_function,
+    const SortAlgorithm &sort_algorithm,
+    const SortConfig &sort_config) const {
+    assert(IsValid());
+
+    using SortNode = api::SortNode<
+              ValueType, CompareFunction, SortAlgorithm, SortConfig,
+              /* Stable */ true>;
 
     static_assert(
         std::is_convertible<
@@ -821,7 +1373,31 @@ auto DIA<ValueType, Stack>::Sort(const CompareFunction &compare_function,
         "CompareFunction has the wrong output type (should be bool)");
 
     auto node = common::MakeCounting<SortNode>(
-        *this, compare_function, sort_algorithm);
+        *this, compare_function, sort_algorithm, sort_config);
+
+    return DIA<ValueType>(node);
+}
+
+template <typename ValueType, typename Stack>
+template <typename KeyExtractor>
+auto DIA<ValueType, Stack>::SortByKey(
+    const KeyExtractor &key_extractor) const {
+    assert(IsValid());
+
+    using CompareFunction = common::RadixKeyCompare<ValueType, KeyExtractor>;
+    using SortAlgorithm = common::RadixSortByKey<KeyExtractor>;
+
+    using SortNode = api::SortNode<
+              ValueType, CompareFunction, SortAlgorithm>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<KeyExtractor>::template arg<0> >::value,
+        "KeyExtractor has the wrong input type");
+
+    auto node = common::MakeCounting<SortNode>(
+        *this, CompareFunction(key_extractor), SortAlgorithm(key_extractor));
 
     return DIA<ValueType>(node);
 }
@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * thrill/api/top_k.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_API_TOP_K_HEADER
+#define THRILL_API_TOP_K_HEADER
+
+#include <thrill/api/dia.hpp>
+#include <thrill/api/dop_node.hpp>
+#include <thrill/common/binary_heap.hpp>
+#include <thrill/common/functional.hpp>
+#include <thrill/common/logger.hpp>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace api {
+
+/*!
+ * A DIANode which selects the k smallest items of a DIA according to a
+ * compare function and delivers them in sorted order.
+ *
+ * Each worker keeps its k smallest items in a bounded BinaryHeap. After the
+ * PreOp, the smallest k-th local item of all workers is determined with an
+ * AllReduce and all local items greater than it are discarded, since that
+ * worker alone has k items which are not greater. The remaining candidates,
+ * at most k per worker, are sent to worker 0, which selects the k smallest and
+ * distributes them evenly among all workers. Hence, only O(k p) items are
+ * transmitted and k items must fit into the RAM of one worker.
+ *
+ * \ingroup api_layer
+ */
+template <typename ValueType, typename CompareFunction>
+class TopKNode final : public DOpNode<ValueType>
+{
+    static constexpr bool debug = false;
+
+    using Super = DOpNode<ValueType>;
+    using Super::context_;
+
+    //! local bound for the AllReduce: valid flag and k-th smallest item
+    using Bound = std::pair<bool, ValueType>;
+
+public:
+    template <typename ParentDIA>
+    TopKNode(const ParentDIA& parent, size_t k,
+             const CompareFunction& compare_function)
+        : Super(parent.ctx(), "TopK", { parent.id() }, { parent.node() }),
+          k_(k),
+          compare_function_(compare_function),
+          heap_(compare_function)
+    {
+        // Hook PreOp(s)
+        auto pre_op_fn = [this](const ValueType& input) {
+                             PreOp(input);
+                         };
+
+        auto lop_chain = parent.stack().push(pre_op_fn).fold();
+        parent.node()->AddChild(this, lop_chain);
+    }
+
+    DIAMemUse PreOpMemUse() final {
+        // the heap grows with the local input up to k items, nothing is
+        // reserved for k in advance.
+        return DIAMemUse::Max();
+    }
+
+    void PreOp(const ValueType& input) {
+        // the heap's top is the greatest of the k smallest items seen so far.
+        if (heap_.size() < k_) {
+            heap_.emplace(input);
+        }
+        else if (k_ != 0 && compare_function_(input, heap_.top())) {
+            heap_.pop();
+            heap_.emplace(input);
+        }
+    }
+
+    void Execute() final {
+        std::vector<ValueType> candidates;
+        std::swap(candidates, heap_.container());
+        std::sort(candidates.begin(), candidates.end(), compare_function_);
+
+        // the smallest k-th item of all workers bounds the global k-th item.
+        Bound bound(false, ValueType());
+        if (k_ != 0 && candidates.size() == k_)
+            bound = Bound(true, candidates.back());
+
+        bound = context_.net.AllReduce(
+            bound, [this](const Bound& a, const Bound& b) {
+                if (!a.first) return b;
+                if (!b.first) return a;
+                return compare_function_(b.second, a.second) ? b : a;
+            });
+
+        if (bound.first) {
+            candidates.erase(
+                std::upper_bound(candidates.begin(), candidates.end(),
+                                 bound.second, compare_function_),
+                candidates.end());
+        }
+
+        sLOG << "TopKNode::Execute() k" << k_
+             << "local candidates" << candidates.size();
+
+        // send all candidates to worker 0, which selects the k smallest.
+        std::vector<ValueType> top;
+        {
+            data::CatStreamPtr stream = context_.GetNewCatStream(this);
+            std::vector<data::CatStream::Writer> writers = stream->GetWriters();
+
+            for (const ValueType& v : candidates)
+                writers[0].Put(v);
+            std::vector<ValueType>().swap(candidates);
+
+            for (data::CatStream::Writer& w : writers)
+                w.Close();
+
+            auto reader = stream->GetCatReader(/* consume */ true);
+            while (reader.HasNext())
+                top.emplace_back(reader.template Next<ValueType>());
+
+            stream->Close();
+        }
+
+        if (top.size() > k_) {
+            std::nth_element(top.begin(), top.begin() + k_, top.end(),
+                             compare_function_);
+            top.resize(k_);
+        }
+        std::sort(top.begin(), top.end(), compare_function_);
+
+        // distribute the result evenly in sorted order.
+        {
+            data::CatStreamPtr stream = context_.GetNewCatStream(this);
+            std::vector<data::CatStream::Writer> writers = stream->GetWriters();
+
+            const size_t num_workers = writers.size();
+            for (size_t w = 0; w < num_workers; ++w) {
+                for (size_t i = w * top.size() / num_workers;
+                     i < (w + 1) * top.size() / num_workers; ++i) {
+                    writers[w].Put(top[i]);
+                }
+                writers[w].Close();
+            }
+            std::vector<ValueType>().swap(top);
+
+            auto reader = stream->GetCatReader(/* consume */ true);
+            while (reader.HasNext())
+                items_.emplace_back(reader.template Next<ValueType>());
+
+            stream->Close();
+        }
+    }
+
+    void PushData(bool consume) final {
+        for (const ValueType& v : items_) {
+            this->PushItem(v);
+        }
+        if (consume)
+            std::vector<ValueType>().swap(items_);
+    }
+
+    void Dispose() final {
+        std::vector<ValueType>().swap(items_);
+    }
+
+private:
+    //! number of items to select
+    size_t k_;
+
+    //! The comparison function which is applied to two elements.
+    CompareFunction compare_function_;
+
+    //! bounded max-heap of the k smallest local items
+    common::BinaryHeap<ValueType, CompareFunction> heap_;
+
+    //! local part of the result
+    std::vector<ValueType> items_;
+};
+
+template <typename ValueType, typename Stack>
+template <typename CompareFunction>
+auto DIA<ValueType, Stack>::TopK(
+    size_t k, const CompareFunction &compare_function) const {
+    assert(IsValid());
+
+    using TopKNode = api::TopKNode<ValueType, CompareFunction>;
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<0> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            ValueType,
+            typename FunctionTraits<CompareFunction>::template arg<1> >::value,
+        "CompareFunction has the wrong input type");
+
+    static_assert(
+        std::is_convertible<
+            typename FunctionTraits<CompareFunction>::result_type,
+            bool>::value,
+        "CompareFunction has the wrong output type (should be bool)");
+
+    auto node = common::MakeCounting<TopKNode>(*this, k, compare_function);
+
+    return DIA<ValueType>(node);
+}
+
+} // namespace api
+} // namespace thrill
+
+#endif // !THRILL_API_TOP_K_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * thrill/common/numa.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/common/defines.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/common/numa.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __linux__
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif
+
+namespace thrill {
+namespace common {
+
+NumaTopology::NumaTopology(std::vector<std::vector<size_t> > node_cpus,
+                           std::vector<size_t> node_ids,
+                           std::vector<size_t> cpu_thread)
+    : node_cpus_(std::move(node_cpus)), node_ids_(std::move(node_ids)) {
+
+    // remove nodes without cpus, e.g. memory-only nodes
+    for (size_t n = node_cpus_.size(); n-- > 0; ) {
+        if (!node_cpus_[n].empty()) continue;
+        node_cpus_.erase(node_cpus_.begin() + n);
+        if (n < node_ids_.size())
+            node_ids_.erase(node_ids_.begin() + n);
+    }
+
+    if (node_cpus_.empty()) {
+        // unknown topology: a single node with all cpus
+        size_t num_cpus = std::max(1u, std::thread::hardware_concurrency());
+        node_cpus_.resize(1);
+        for (size_t c = 0; c < num_cpus; ++c)
+            node_cpus_[0].push_back(c);
+        node_ids_.clear();
+    }
+
+    if (node_ids_.size() != node_cpus_.size()) {
+        node_ids_.resize(node_cpus_.size());
+        for (size_t n = 0; n < node_ids_.size(); ++n)
+            node_ids_[n] = n;
+    }
+
+    // physical cores of all nodes first, then their SMT siblings.
+    auto thread_of = [&cpu_thread](size_t cpu) {
+                         return cpu < cpu_thread.size() ? cpu_thread[cpu] : 0;
+                     };
+    size_t max_thread = 0;
+    for (const std::vector<size_t>& cpus : node_cpus_) {
+        for (size_t c : cpus)
+            max_thread = std::max(max_thread, thread_of(c));
+    }
+    for (size_t t = 0; t <= max_thread; ++t) {
+        for (const std::vector<size_t>& cpus : node_cpus_) {
+            for (size_t c : cpus) {
+                if (thread_of(c) == t) cpus_.push_back(c);
+            }
+        }
+    }
+}
+
+NumaTopology NumaTopology::Detect() {
+    std::vector<std::vector<size_t> > node_cpus;
+    std::vector<size_t> node_ids;
+    std::vector<size_t> cpu_thread;
+
+#if __linux__
+    static const std::string sysfs = "/sys/devices/system/node/";
+
+    std::ifstream online(sysfs + "online");
+    std::string line;
+    if (online && std::getline(online, line)) {
+        for (size_t id : ParseCpuList(line)) {
+            std::ifstream cpulist(
+                sysfs + "node" + std::to_string(id) + "/cpulist");
+            if (!cpulist || !std::getline(cpulist, line)) continue;
+
+            node_cpus.emplace_back(ParseCpuList(line));
+            node_ids.emplace_back(id);
+        }
+    }
+
+    // index of each cpu among the hardware threads of its core
+    for (const std::vector<size_t>& cpus : node_cpus) {
+        for (size_t c : cpus) {
+            std::ifstream siblings(
+                "/sys/devices/system/cpu/cpu" + std::to_string(c) +
+                "/topology/thread_siblings_list");
+            if (!siblings || !std::getline(siblings, line)) continue;
+
+            std::vector<size_t> list = ParseCpuList(line);
+            size_t thread =
+                std::find(list.begin(), list.end(), c) - list.begin();
+            if (thread == list.size()) continue;
+
+            if (c >= cpu_thread.size()) cpu_thread.resize(c + 1);
+            cpu_thread[c] = thread;
+        }
+    }
+#endif
+
+    return NumaTopology(
+        std::move(node_cpus), std::move(node_ids), std::move(cpu_thread));
+}
+
+const NumaTopology& NumaTopology::Get() {
+    static const NumaTopology topology = Detect();
+    return topology;
+}
+
+size_t NumaTopology::node_of_cpu(size_t cpu) const {
+    for (size_t n = 0; n < node_cpus_.size(); ++n) {
+        if (std::find(node_cpus_[n].begin(), node_cpus_[n].end(), cpu)
+            != node_cpus_[n].end())
+            return n;
+    }
+    return 0;
+}
+
+void NumaTopology::PreferNode(void* addr, size_t size, size_t node) const {
+    if (num_nodes() <= 1) return;
+#if __linux__ && defined(SYS_mbind)
+    // MPOL_PREFERRED from <linux/mempolicy.h>, without depending on libnuma.
+    static constexpr int mpol_preferred = 1;
+    static constexpr size_t mask_bits = 1024;
+    unsigned long mask[mask_bits / (8 * sizeof(unsigned long))] = { 0 };
+
+    size_t id = node_ids_[node];
+    if (id >= mask_bits) return;
+    mask[id / (8 * sizeof(unsigned long))] |=
+        1ul << (id % (8 * sizeof(unsigned long)));
+
+    if (syscall(SYS_mbind, addr, size, mpol_preferred,
+                mask, mask_bits + 1, 0) != 0) {
+        static std::atomic<bool> warned { false };
+        if (!warned.exchange(true))
+            LOG1 << "NumaTopology: mbind() failed, memory is not placed.";
+    }
+#else
+    UNUSED(addr);
+    UNUSED(size);
+    UNUSED(node);
+#endif
+}
+
+std::vector<size_t> NumaTopology::ParseCpuList(const std::string& str) {
+    std::vector<size_t> list;
+    const char* p = str.c_str();
+    while (*p) {
+        char* end;
+        size_t first = std::strtoul(p, &end, 10);
+        if (end == p) break;
+        size_t last = first;
+        p = end;
+        if (*p == '-') {
+            last = std::strtoul(p + 1, &end, 10);
+            if (end == p + 1) break;
+            p = end;
+        }
+        for (size_t c = first; c <= last; ++c)
+            list.push_back(c);
+        if (*p != ',') break;
+        ++p;
+    }
+    return list;
+}
+
+} // namespace common
+} // namespace thrill
+
+/******************************************************************************/
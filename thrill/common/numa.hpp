@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * thrill/common/numa.hpp
+ *
+ * Detection of the NUMA topology and placement of worker threads and memory.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_NUMA_HEADER
+#define THRILL_COMMON_NUMA_HEADER
+
+#include <string>
+#include <vector>
+
+namespace thrill {
+namespace common {
+
+/*!
+ * NUMA topology of the machine: the list of cpus of each node. On Linux it is
+ * read from /sys/devices/system/node, elsewhere all cpus form one node.
+ *
+ * Workers are placed compactly: consecutive worker ids are pinned to the cpus
+ * of one node before continuing on the next node, such that workers of the
+ * same host share a socket if they fit. Hyperthreads are used last: first the
+ * physical cores of all nodes are filled, then their SMT siblings in the same
+ * order.
+ */
+class NumaTopology
+{
+public:
+    //! construct topology with the given cpus of each node, optionally the
+    //! kernel's ids of the nodes if they are not 0, 1, 2, ..., and optionally
+    //! the index of each cpu among the hardware threads of its core, which is
+    //! 0 for the first thread and 1, 2, ... for its SMT siblings.
+    explicit NumaTopology(std::vector<std::vector<size_t> > node_cpus,
+                          std::vector<size_t> node_ids = { },
+                          std::vector<size_t> cpu_thread = { });
+
+    //! detect topology of this machine
+    static NumaTopology Detect();
+
+    //! return the topology of this machine, detected once.
+    static const NumaTopology& Get();
+
+    //! number of NUMA nodes, at least one.
+    size_t num_nodes() const { return node_cpus_.size(); }
+
+    //! number of cpus, at least one.
+    size_t num_cpus() const { return cpus_.size(); }
+
+    //! cpus of a node
+    const std::vector<size_t>& node_cpus(size_t node) const {
+        return node_cpus_[node];
+    }
+
+    //! return the node of a cpu, or zero if it is unknown.
+    size_t node_of_cpu(size_t cpu) const;
+
+    //! return the cpu to pin the worker with the given global id to.
+    size_t worker_cpu(size_t worker_id) const {
+        return cpus_[worker_id % cpus_.size()];
+    }
+
+    //! return the node of the worker with the given global id.
+    size_t worker_node(size_t worker_id) const {
+        return node_of_cpu(worker_cpu(worker_id));
+    }
+
+    //! Set the memory policy of the pages in [addr, addr + size) to prefer the
+    //! given node. The range should be page aligned and not yet touched, since
+    //! pages are not moved. Does nothing on single node machines.
+    void PreferNode(void* addr, size_t size, size_t node) const;
+
+    //! parse a Linux cpu or node list like "0-3,8,10-11".
+    static std::vector<size_t> ParseCpuList(const std::string& str);
+
+private:
+    //! cpus of each node
+    std::vector<std::vector<size_t> > node_cpus_;
+
+    //! kernel's ids of the nodes
+    std::vector<size_t> node_ids_;
+
+    //! all cpus ordered by hardware thread index, then by node
+    std::vector<size_t> cpus_;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_NUMA_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,225 @@
+/*******************************************************************************
+ * thrill/common/parallel_sort.hpp
+ *
+ * Parallel sample sort using the threads of a ThreadPool: items are classified
+ * into buckets by an implicit splitter tree, scattered into a buffer and the
+ * buckets are then sorted independently.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_COMMON_PARALLEL_SORT_HEADER
+#define THRILL_COMMON_PARALLEL_SORT_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/math.hpp>
+#include <thrill/common/semaphore.hpp>
+#include <thrill/common/thread_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace thrill {
+namespace common {
+namespace parallel_sort_local {
+
+//! Run the function job(i) for i = 0..num_jobs-1 in the ThreadPool and wait
+//! for all of them. The pool may be shared with other callers, hence we cannot
+//! use LoopUntilEmpty() and count finished jobs with a semaphore instead.
+template <typename Job>
+void RunJobs(ThreadPool& pool, size_t num_jobs, const Job& job) {
+    Semaphore done;
+    for (size_t i = 0; i < num_jobs; ++i) {
+        pool.Enqueue([&job, &done, i]() {
+                         job(i);
+                         done.signal();
+                     });
+    }
+    for (size_t i = 0; i < num_jobs; ++i)
+        done.wait();
+}
+
+} // namespace parallel_sort_local
+
+/*!
+ * Sort the range [begin,end) in parallel using the threads in pool. This is a
+ * sample sort: from an oversampled random sample 2^k - 1 splitters are chosen
+ * and stored as an implicit binary search tree. Then each thread classifies a
+ * slice of the input and records the bucket of each item in an oracle
+ * array. After a prefix sum over the bucket sizes, the threads scatter their
+ * items into a temporary buffer, and finally each bucket is sorted using
+ * std::sort() and moved back into place.
+ *
+ * Requires n extra items of temporary memory and two bytes per item for the
+ * oracle. Ranges below min_parallel_size are sorted sequentially.
+ */
+template <typename Iterator, typename Comparator>
+void parallel_sample_sort(Iterator begin, Iterator end, const Comparator& cmp,
+                          ThreadPool& pool,
+                          size_t min_parallel_size = 65536) {
+
+    static constexpr bool debug = false;
+
+    using ValueType = typename std::iterator_traits<Iterator>::value_type;
+    using Bucket = uint16_t;
+
+    const size_t size = end - begin;
+    const size_t num_threads = pool.size();
+
+    if (num_threads <= 1 || size < min_parallel_size)
+        return std::sort(begin, end, cmp);
+
+    // number of buckets: a power of two, several per thread for load balance
+    const size_t log_k = std::min<size_t>(
+        IntegerLog2Ceil(4 * num_threads), 8 * sizeof(Bucket) - 1);
+    const size_t k = size_t(1) << log_k;
+
+    // draw an oversampled random sample and pick equidistant splitters.
+    const size_t oversampling = 16;
+    std::vector<ValueType> sample;
+    sample.reserve(k * oversampling);
+    {
+        std::minstd_rand rng(static_cast<unsigned>(size));
+        for (size_t i = 0; i < k * oversampling; ++i)
+            sample.emplace_back(begin[rng() % size]);
+        std::sort(sample.begin(), sample.end(), cmp);
+    }
+
+    // build implicit splitter tree: tree[1] is the root, tree[2j], tree[2j+1]
+    // are the children of tree[j].
+    std::vector<ValueType> tree(k);
+    {
+        std::vector<ValueType> splitters(k - 1);
+        for (size_t i = 1; i < k; ++i)
+            splitters[i - 1] = sample[i * oversampling];
+
+        size_t index = 0;
+        // in-order traversal of the implicit tree assigns the sorted splitters
+        auto fill = [&](size_t j, const auto& self) -> void {
+                        if (j >= k) return;
+                        self(2 * j, self);
+                        tree[j] = splitters[index++];
+                        self(2 * j + 1, self);
+                    };
+        fill(1, fill);
+    }
+    std::vector<ValueType>().swap(sample);
+
+    // Phase 1: classify slices of the input and count bucket sizes
+    std::vector<Bucket> oracle(size);
+    // bucket sizes, thread-major: bkt_size[t * k + b]
+    std::vector<size_t> bkt_size(num_threads * k, 0);
+
+    auto slice_begin = [size, num_threads](size_t t) {
+                           return t * size / num_threads;
+                       };
+
+    parallel_sort_local::RunJobs(
+        pool, num_threads,
+        [&](size_t t) {
+            size_t* count = bkt_size.data() + t * k;
+            for (size_t i = slice_begin(t); i < slice_begin(t + 1); ++i) {
+                // run item down the tree, items equal to a splitter go right.
+                size_t j = 1;
+                for (size_t l = 0; l < log_k; ++l)
+                    j = 2 * j + (cmp(begin[i], tree[j]) ? 0 : 1);
+                Bucket b = static_cast<Bucket>(j - k);
+                oracle[i] = b;
+                ++count[b];
+            }
+        });
+
+    std::vector<ValueType>().swap(tree);
+
+    // exclusive prefix sum bucket-major, thread-minor: bkt_index[t * k + b] is
+    // where thread t scatters its first item of bucket b. bkt_begin[b] is the
+    // start of bucket b in the output.
+    std::vector<size_t> bkt_index(num_threads * k);
+    std::vector<size_t> bkt_begin(k + 1);
+    {
+        size_t sum = 0;
+        for (size_t b = 0; b < k; ++b) {
+            bkt_begin[b] = sum;
+            for (size_t t = 0; t < num_threads; ++t) {
+                bkt_index[t * k + b] = sum;
+                sum += bkt_size[t * k + b];
+            }
+        }
+        bkt_begin[k] = sum;
+        assert(sum == size);
+    }
+
+    // Phase 2: scatter items into temporary buffer
+    ValueType* buffer = static_cast<ValueType*>(
+        operator new (size * sizeof(ValueType)));
+
+    parallel_sort_local::RunJobs(
+        pool, num_threads,
+        [&](size_t t) {
+            size_t* index = bkt_index.data() + t * k;
+            for (size_t i = slice_begin(t); i < slice_begin(t + 1); ++i) {
+                new (buffer + index[oracle[i]]++)ValueType(std::move(begin[i]));
+            }
+        });
+
+    std::vector<Bucket>().swap(oracle);
+
+    sLOG << "parallel_sample_sort() size" << size << "buckets" << k
+         << "threads" << num_threads;
+
+    // Phase 3: sort each bucket and move it back into the input range
+    parallel_sort_local::RunJobs(
+        pool, k,
+        [&](size_t b) {
+            ValueType* bbegin = buffer + bkt_begin[b];
+            ValueType* bend = buffer + bkt_begin[b + 1];
+
+            std::sort(bbegin, bend, cmp);
+
+            Iterator out = begin + bkt_begin[b];
+            for (ValueType* it = bbegin; it != bend; ++it, ++out) {
+                *out = std::move(*it);
+                it->~ValueType();
+            }
+        });
+
+    operator delete (buffer);
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() which sorts runs in parallel
+ * using the threads of a (host-wide) ThreadPool.
+ */
+class ParallelSampleSort
+{
+public:
+    explicit ParallelSampleSort(ThreadPool& pool,
+                                size_t min_parallel_size = 65536)
+        : pool_(pool), min_parallel_size_(min_parallel_size) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& cmp) const {
+        parallel_sample_sort(begin, end, cmp, pool_, min_parallel_size_);
+    }
+
+private:
+    //! thread pool used for sorting, usually Context::thread_pool()
+    ThreadPool& pool_;
+    //! runs smaller than this are sorted sequentially
+    size_t min_parallel_size_;
+};
+
+} // namespace common
+} // namespace thrill
+
+#endif // !THRILL_COMMON_PARALLEL_SORT_HEADER
+
+/******************************************************************************/
@@ -121,6 +121,24 @@ void SetCpuAffinity(std::thread& thread, size_t cpu_id) {
 #endif
 }
 
+void SetCpuAffinity(std::thread& thread, const std::vector<size_t>& cpus) {
+#if __linux__
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (size_t cpu : cpus)
+        CPU_SET(cpu % std::thread::hardware_concurrency(), &cpuset);
+    int rc = pthread_setaffinity_np(
+        thread.native_handle(), sizeof(cpu_set_t), &cpuset);
+    if (rc != 0) {
+        LOG1 << "Error calling pthread_setaffinity_np(): "
+             << rc << ": " << strerror(errno);
+    }
+#else
+    UNUSED(thread);
+    UNUSED(cpus);
+#endif
+}
+
 std::string GetHostname() {
 #if __linux__
     char buffer[64];
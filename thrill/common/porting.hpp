@@ -22,6 +22,7 @@ using ssize_t = SSIZE_T;
 #include <string>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 namespace thrill {
 namespace common {
@@ -56,6 +57,9 @@ std::thread CreateThread(Args&& ... args) {
 //! set cpu/core affinity of a thread
 void SetCpuAffinity(std::thread& thread, size_t cpu_id);
 
+//! set cpu/core affinity of a thread to any of the given cpus
+void SetCpuAffinity(std::thread& thread, const std::vector<size_t>& cpus);
+
 //! get hostname
 std::string GetHostname();
 
@@ -19,8 +19,12 @@
 #include <thrill/common/logger.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <iterator>
 #include <type_traits>
+#include <utility>
 
 namespace thrill {
 namespace common {
@@ -160,6 +164,215 @@ private:
     const size_t K_;
 };
 
+/******************************************************************************/
+// Radix Sort by Extracted Keys
+
+/*!
+ * Traits class describing keys which can be radix sorted: integral types and
+ * fixed-width byte strings (std::array<uint8_t, N>). at_radix(key, depth)
+ * returns the depth-th most significant byte, and prefix(key) returns an
+ * order-preserving 64-bit prefix of the key.
+ */
+template <typename Key, typename Enable = void>
+class RadixSortKeyTraits;
+
+template <typename Key>
+class RadixSortKeyTraits<
+        Key, typename std::enable_if<std::is_integral<Key>::value>::type>
+{
+public:
+    using Unsigned = typename std::make_unsigned<Key>::type;
+
+    //! number of radix bytes in the key
+    static constexpr size_t num_bytes = sizeof(Key);
+
+    //! whether prefix() determines the order of keys completely
+    static constexpr bool prefix_complete = (sizeof(Key) <= 8);
+
+    //! map key to unsigned value, flip the sign bit of signed integers.
+    static Unsigned to_unsigned(const Key& k) {
+        return static_cast<Unsigned>(k) ^ static_cast<Unsigned>(
+            std::is_signed<Key>::value
+            ? Unsigned(1) << (8 * sizeof(Key) - 1) : 0);
+    }
+
+    static uint8_t at_radix(const Key& k, size_t depth) {
+        return static_cast<uint8_t>(
+            to_unsigned(k) >> (8 * (num_bytes - 1 - depth)));
+    }
+
+    static uint64_t prefix(const Key& k) {
+        return static_cast<uint64_t>(to_unsigned(k));
+    }
+};
+
+template <size_t N>
+class RadixSortKeyTraits<std::array<uint8_t, N> >
+{
+public:
+    using Key = std::array<uint8_t, N>;
+
+    //! number of radix bytes in the key
+    static constexpr size_t num_bytes = N;
+
+    //! whether prefix() determines the order of keys completely
+    static constexpr bool prefix_complete = (N <= 8);
+
+    static uint8_t at_radix(const Key& k, size_t depth) {
+        return k[depth];
+    }
+
+    //! load up to eight bytes in big-endian order, pad with zeros.
+    static uint64_t prefix(const Key& k) {
+        uint64_t p = 0;
+        for (size_t i = 0; i < 8; ++i)
+            p = (p << 8) | (i < N ? k[i] : 0);
+        return p;
+    }
+};
+
+/*!
+ * Comparator on items using the keys retrieved by a key extractor. Keys are
+ * first compared by their 64-bit prefix, which is usually decisive and much
+ * cheaper than comparing long byte strings.
+ */
+template <typename ValueType, typename KeyExtractor>
+class RadixKeyCompare
+{
+public:
+    using Key = typename std::decay<
+              decltype(std::declval<KeyExtractor>()(
+                           std::declval<const ValueType&>()))>::type;
+    using Traits = RadixSortKeyTraits<Key>;
+
+    explicit RadixKeyCompare(const KeyExtractor& key_extractor)
+        : key_extractor_(key_extractor) { }
+
+    bool operator () (const ValueType& a, const ValueType& b) const {
+        return less(key_extractor_(a), key_extractor_(b));
+    }
+
+    //! compare two keys, first by prefix, then by full key if necessary.
+    static bool less(const Key& a, const Key& b) {
+        uint64_t pa = Traits::prefix(a), pb = Traits::prefix(b);
+        if (pa != pb || Traits::prefix_complete)
+            return pa < pb;
+        return a < b;
+    }
+
+private:
+    KeyExtractor key_extractor_;
+};
+
+/*!
+ * Internal helper method, use radix_sort_key below.
+ */
+template <typename Iterator, typename KeyExtractor, typename Comparator>
+static inline
+void radix_sort_key(Iterator begin, Iterator end,
+                    const KeyExtractor& key_extractor, const Comparator& cmp,
+                    size_t depth, uint8_t* char_cache) {
+
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+    using Key = typename std::decay<
+              decltype(key_extractor(*begin))>::type;
+    using Traits = RadixSortKeyTraits<Key>;
+
+    const size_t size = end - begin;
+    // all keys equal, nothing left to sort
+    if (depth >= Traits::num_bytes)
+        return;
+    if (size < 32)
+        return std::sort(begin, end, cmp);
+
+    // cache characters
+    uint8_t* cc = char_cache;
+    for (Iterator it = begin; it != end; ++it, ++cc)
+        *cc = Traits::at_radix(key_extractor(*it), depth);
+
+    // count character occurrences
+    size_t bkt_size[256];
+    std::fill(bkt_size, bkt_size + 256, 0);
+    for (const uint8_t* cc = char_cache; cc != char_cache + size; ++cc)
+        ++bkt_size[*cc];
+
+    // inclusive prefix sum
+    size_t bkt_index[256];
+    bkt_index[0] = bkt_size[0];
+    size_t last_bkt_size = bkt_size[0];
+    for (size_t i = 1; i < 256; ++i) {
+        bkt_index[i] = bkt_index[i - 1] + bkt_size[i];
+        if (bkt_size[i]) last_bkt_size = bkt_size[i];
+    }
+
+    // premute in-place
+    for (size_t i = 0, j; i < size - last_bkt_size; )
+    {
+        value_type v = std::move(begin[i]);
+        uint8_t vc = char_cache[i];
+        while ((j = --bkt_index[vc]) > i)
+        {
+            using std::swap;
+            swap(v, begin[j]);
+            swap(vc, char_cache[j]);
+        }
+        begin[i] = std::move(v);
+        i += bkt_size[vc];
+    }
+
+    // recurse
+    size_t bsum = 0;
+    for (size_t i = 0; i < 256; bsum += bkt_size[i++]) {
+        if (bkt_size[i] <= 1) continue;
+        radix_sort_key(begin + bsum, begin + bsum + bkt_size[i],
+                       key_extractor, cmp, depth + 1, char_cache);
+    }
+}
+
+/*!
+ * MSD radix sort the iterator range [begin,end) by the integer or byte string
+ * keys returned by key_extractor, see RadixSortKeyTraits. Small buckets are
+ * sorted using std::sort() with a RadixKeyCompare. Requires n extra bytes of
+ * memory for caching the characters.
+ */
+template <typename Iterator, typename KeyExtractor>
+static inline
+void radix_sort_key(Iterator begin, Iterator end,
+                    const KeyExtractor& key_extractor) {
+
+    using value_type = typename std::iterator_traits<Iterator>::value_type;
+
+    const size_t size = end - begin;
+    if (size <= 1) return;
+
+    uint8_t* char_cache = new uint8_t[size];
+    radix_sort_key(begin, end, key_extractor,
+                   RadixKeyCompare<value_type, KeyExtractor>(key_extractor),
+                   /* depth */ 0, char_cache);
+    delete[] char_cache;
+}
+
+/*!
+ * SortAlgorithm class for use with api::Sort() which calls radix_sort_key()
+ * using the given key extractor, see api::DIA::SortByKey().
+ */
+template <typename KeyExtractor>
+class RadixSortByKey
+{
+public:
+    explicit RadixSortByKey(const KeyExtractor& key_extractor)
+        : key_extractor_(key_extractor) { }
+
+    template <typename Iterator, typename CompareFunction>
+    void operator () (Iterator begin, Iterator end,
+                      const CompareFunction& /* cmp */) const {
+        radix_sort_key(begin, end, key_extractor_);
+    }
+
+private:
+    KeyExtractor key_extractor_;
+};
+
 } // namespace common
 } // namespace thrill
 
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * thrill/core/forecast_prefetcher.hpp
+ *
+ * Forecasting prefetcher for merging sorted Files: Blocks are prefetched in the
+ * order in which the merge will need them, determined by the first item of
+ * each Block.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_FORECAST_PREFETCHER_HEADER
+#define THRILL_CORE_FORECAST_PREFETCHER_HEADER
+
+#include <thrill/data/file.hpp>
+
+#include <cassert>
+#include <queue>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Records the first item of each Block written into a File, which are the
+ * trigger items used by the ForecastPrefetcher. Call Put() instead of
+ * writer.Put() for each item.
+ */
+template <typename ValueType>
+class TriggerRecorder
+{
+public:
+    TriggerRecorder(const data::File& file, std::vector<ValueType>& triggers)
+        : file_(file), triggers_(triggers) { }
+
+    template <typename Writer>
+    void Put(Writer& writer, const ValueType& item) {
+        writer.Put(item);
+        // if a Block was flushed, the item starts (or continues) in a new one.
+        while (file_.num_blocks() >= triggers_.size())
+            triggers_.push_back(item);
+    }
+
+    //! remove surplus triggers after the writer was closed.
+    void Finish() {
+        if (triggers_.size() > file_.num_blocks())
+            triggers_.resize(file_.num_blocks());
+    }
+
+private:
+    const data::File& file_;
+    std::vector<ValueType>& triggers_;
+};
+
+/*!
+ * Forecasting prefetcher for a multiway merge of sorted Files read by
+ * ConsumeReaders without prefetch. The merge needs Block j of a File once it
+ * reaches the first item of Block j, hence the Blocks are needed in the order
+ * of their trigger items over all Files. The prefetcher keeps up to
+ * max_prefetch Blocks in flight, always pinning the not yet fetched Block with
+ * the smallest trigger. Poll() must be called regularly during the merge.
+ */
+template <typename ValueType, typename Comparator>
+class ForecastPrefetcher
+{
+public:
+    using ConsumeReader = data::File::ConsumeReader;
+
+    ForecastPrefetcher(std::vector<ConsumeReader>& readers,
+                       const std::vector<const std::vector<ValueType>*>& triggers,
+                       size_t max_prefetch, const Comparator& comp)
+        : readers_(readers), triggers_(triggers),
+          max_prefetch_(max_prefetch), queue_(QueueCompare { comp }) {
+        assert(readers_.size() == triggers_.size());
+
+        for (size_t r = 0; r < readers_.size(); ++r) {
+            num_blocks_.push_back(readers_[r].source().num_unfetched());
+            assert(triggers_[r]->size() == num_blocks_[r]);
+            PushNext(r);
+        }
+        Prefetch();
+    }
+
+    //! called for each merged item, tops up the prefetched Blocks every
+    //! poll_interval items.
+    void Poll() {
+        if (++counter_ < poll_interval) return;
+        counter_ = 0;
+        Prefetch();
+    }
+
+    //! pin Blocks in order of their triggers until max_prefetch are in flight.
+    void Prefetch() {
+        size_t fetching = 0;
+        for (ConsumeReader& r : readers_)
+            fetching += r.source().num_fetching();
+
+        while (fetching < max_prefetch_ && !queue_.empty()) {
+            Entry e = queue_.top();
+            queue_.pop();
+
+            if (e.block != NextBlock(e.run)) {
+                // Block was fetched synchronously by the reader in between.
+                PushNext(e.run);
+                continue;
+            }
+
+            if (readers_[e.run].source().PrefetchOne())
+                ++fetching;
+            PushNext(e.run);
+        }
+    }
+
+private:
+    //! number of items between two top-ups
+    static constexpr size_t poll_interval = 64;
+
+    struct Entry {
+        //! trigger item of the Block
+        const ValueType* trigger;
+        //! index of the run
+        size_t           run;
+        //! index of the Block in the run
+        size_t           block;
+    };
+
+    struct QueueCompare {
+        Comparator comp;
+        //! inverted, such that the smallest trigger is on top
+        bool operator () (const Entry& a, const Entry& b) const {
+            return comp(*b.trigger, *a.trigger);
+        }
+    };
+
+    std::vector<ConsumeReader>& readers_;
+    std::vector<const std::vector<ValueType>*> triggers_;
+    size_t max_prefetch_;
+
+    //! initial number of Blocks of each run
+    std::vector<size_t> num_blocks_;
+
+    std::priority_queue<Entry, std::vector<Entry>, QueueCompare> queue_;
+
+    size_t counter_ = 0;
+
+    //! index of the next not yet fetched Block of run r
+    size_t NextBlock(size_t r) const {
+        return num_blocks_[r] - readers_[r].source().num_unfetched();
+    }
+
+    //! insert the next not yet fetched Block of run r into the queue
+    void PushNext(size_t r) {
+        size_t b = NextBlock(r);
+        if (b < num_blocks_[r])
+            queue_.push(Entry { &(*triggers_[r])[b], r, b });
+    }
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_FORECAST_PREFETCHER_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,183 @@
+/*******************************************************************************
+ * thrill/core/group_by_hash_table.hpp
+ *
+ * Hash table which groups items by key into lists, used by the hash grouping
+ * mode of GroupByKey.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_GROUP_BY_HASH_TABLE_HEADER
+#define THRILL_CORE_GROUP_BY_HASH_TABLE_HEADER
+
+#include <thrill/core/reduce_functional.hpp>
+
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Hash table which collects the items of each key in a list. The items are
+ * stored in one vector and the items of a group are linked by index in
+ * insertion order, the hash table only maps each key to its group. Hence, the
+ * key only needs a hash function and operator ==.
+ */
+template <typename ValueType, typename Key,
+          typename KeyExtractor, typename HashFunction = std::hash<Key> >
+class GroupByHashTable
+{
+    //! end of list marker
+    static constexpr size_t invalid = std::numeric_limits<size_t>::max();
+
+    //! first and last item of a group
+    struct Group {
+        size_t head, tail;
+    };
+
+public:
+    /*!
+     * Iterator over the items of one group, which is passed to the group
+     * function of GroupByKey.
+     */
+    class GroupIterator
+    {
+    public:
+        GroupIterator(const GroupByHashTable& table, size_t head)
+            : table_(table), index_(head) { }
+
+        bool HasNext() const { return index_ != invalid; }
+
+        ValueType Next() {
+            assert(index_ != invalid);
+            size_t i = index_;
+            index_ = table_.next_[i];
+            return table_.items_[i];
+        }
+
+    private:
+        const GroupByHashTable& table_;
+        //! next item of the group
+        size_t index_;
+    };
+
+    GroupByHashTable(const KeyExtractor& key_extractor,
+                     const HashFunction& hash_function = HashFunction())
+        : key_extractor_(key_extractor),
+          index_(0, hash_function) { }
+
+    //! insert an item into the list of its key
+    void Insert(const ValueType& v) {
+        const size_t i = items_.size();
+        items_.emplace_back(v);
+        next_.emplace_back();
+        next_.back() = invalid;
+
+        auto it = index_.emplace(key_extractor_(v), groups_.size());
+        if (it.second) {
+            groups_.emplace_back(Group { i, i });
+        }
+        else {
+            Group& g = groups_[it.first->second];
+            next_[g.tail] = i;
+            g.tail = i;
+        }
+    }
+
+    //! iterator over the items of key, which is empty if key is not in the
+    //! table.
+    GroupIterator Find(const Key& key) const {
+        auto it = index_.find(key);
+        if (it == index_.end()) return GroupIterator(*this, invalid);
+        return GroupIterator(*this, groups_[it->second].head);
+    }
+
+    //! number of items in the table
+    size_t num_items() const { return items_.size(); }
+
+    //! number of groups in the table
+    size_t num_groups() const { return groups_.size(); }
+
+    //! estimate of the memory used by the table
+    size_t memory_use() const {
+        return items_.size() * (sizeof(ValueType) + sizeof(size_t))
+               + groups_.size() * (sizeof(Group) + sizeof(Key)
+                                   + 4 * sizeof(size_t));
+    }
+
+    //! call f(iterator, key) for each group in the order of their first item
+    template <typename Function>
+    void ForEachGroup(const Function& f) const {
+        for (const Group& g : groups_) {
+            GroupIterator iter(*this, g.head);
+            f(iter, key_extractor_(items_[g.head]));
+        }
+    }
+
+    //! move all items into the writer of partition(key) and clear the table.
+    template <typename Writer, typename Partition>
+    void Spill(std::vector<Writer>& writers, const Partition& partition) {
+        for (const ValueType& v : items_)
+            writers[partition(key_extractor_(v))].Put(v);
+        Clear();
+    }
+
+    //! remove all items and deallocate the memory
+    void Clear() {
+        std::vector<ValueType>().swap(items_);
+        std::vector<size_t>().swap(next_);
+        std::vector<Group>().swap(groups_);
+        index_.clear();
+    }
+
+private:
+    KeyExtractor key_extractor_;
+
+    //! all items in insertion order
+    std::vector<ValueType> items_;
+    //! index of the next item in the same group
+    std::vector<size_t> next_;
+    //! groups in order of their first item
+    std::vector<Group> groups_;
+    //! maps each key to its group
+    std::unordered_map<Key, size_t, HashFunction> index_;
+};
+
+/*!
+ * Partition function for spilling a GroupByHashTable: the hash of the key is
+ * salted with the recursion level, such that the partitions are independent of
+ * the worker assignment and of the previous levels.
+ */
+template <typename Key, typename HashFunction = std::hash<Key> >
+class GroupByHashPartition
+{
+public:
+    GroupByHashPartition(size_t num_partitions, size_t level,
+                         const HashFunction& hash_function = HashFunction())
+        : num_partitions_(num_partitions), level_(level),
+          hash_function_(hash_function) { }
+
+    size_t operator () (const Key& k) const {
+        return Hash128to64(level_ + 1, hash_function_(k)) % num_partitions_;
+    }
+
+private:
+    size_t num_partitions_;
+    size_t level_;
+    HashFunction hash_function_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_GROUP_BY_HASH_TABLE_HEADER
+
+/******************************************************************************/
@@ -21,14 +21,15 @@
 namespace thrill {
 namespace core {
 
-template <typename ValueType, typename ReaderIterator, typename Comparator>
+template <typename ValueType, typename ReaderIterator, typename Comparator,
+          bool Stable = false>
 class MultiwayMergeTree
 {
 public:
     using Reader = typename std::iterator_traits<ReaderIterator>::value_type;
 
     using LoserTreeType = typename core::LoserTreeTraits<
-              /* stable */ false, ValueType, Comparator>::Type;
+              Stable, ValueType, Comparator>::Type;
 
     MultiwayMergeTree(ReaderIterator readers_begin, ReaderIterator readers_end,
                       const Comparator& comp)
@@ -114,6 +115,25 @@ auto make_multiway_merge_tree(
         Comparator>(seqs_begin, seqs_end, comp);
 }
 
+/*!
+ * Stable sequential multi-way merging: equal items are delivered in the order
+ * of the input sequences.
+ *
+ * \param seqs_begin Begin iterator of iterator pair input sequence.
+ * \param seqs_end End iterator of iterator pair input sequence.
+ * \param comp Comparator.
+ */
+template <typename ValueType, typename ReaderIterator, typename Comparator>
+auto make_stable_multiway_merge_tree(
+    ReaderIterator seqs_begin, ReaderIterator seqs_end,
+    const Comparator &comp) {
+
+    assert(seqs_end - seqs_begin >= 1);
+    return MultiwayMergeTree<
+        ValueType, ReaderIterator,
+        Comparator, /* Stable */ true>(seqs_begin, seqs_end, comp);
+}
+
 } // namespace core
 } // namespace thrill
 
@@ -0,0 +1,320 @@
+/*******************************************************************************
+ * thrill/core/parallel_multiway_merge.hpp
+ *
+ * Parallel multiway merge of sorted Files: the Files are split into ranges by
+ * common splitters, the ranges are merged independently by threads of a
+ * ThreadPool and the result is read back in order.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+#define THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+
+#include <thrill/common/logger.hpp>
+#include <thrill/common/semaphore.hpp>
+#include <thrill/common/thread_pool.hpp>
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * Calculate the number of threads for a ParallelMultiwayMergeTree of the Files,
+ * returns 1 for a sequential merge. If threads is 0, the cores of the host are
+ * divided among its workers. Each thread must merge at least min_items, since
+ * splitting the Files requires binary searches, and each thread reads one Block
+ * of each File and writes one Block at once, which must fit into mem_limit.
+ */
+template <typename FileIterator>
+size_t ParallelMergeThreads(
+    FileIterator files_begin, FileIterator files_end, size_t threads,
+    size_t workers_per_host, size_t min_items, size_t mem_limit) {
+    size_t num_files = std::distance(files_begin, files_end);
+    if (num_files == 0) return 1;
+
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency() / workers_per_host;
+
+    size_t total_items = 0;
+    for (FileIterator it = files_begin; it != files_end; ++it)
+        total_items += it->num_items();
+
+    threads = std::min(threads, total_items / std::max<size_t>(min_items, 1));
+
+    size_t avail_blocks = mem_limit / data::default_block_size;
+    threads = std::min(threads, avail_blocks / (num_files + 1));
+
+    return std::max<size_t>(threads, 1);
+}
+
+/*!
+ * Parallel multiway merge of a set of sorted Files. The Files are split into
+ * num_parts ranges of about equal size by splitters picked from a sample, and
+ * the split positions in each File are found by binary search. All items of
+ * part i are smaller than those of part i+1, and equal items are always in the
+ * same part.
+ *
+ * The ranges are taken out of the input Files as Block lists, which share the
+ * ByteBlocks with the input. In consume mode, the input Files are cleared
+ * afterwards and each range is read by a consuming reader, hence a ByteBlock is
+ * released as soon as all ranges referencing it are merged, and the merged
+ * parts do not double the space needed by the input.
+ *
+ * The first part is merged on-the-fly by the thread calling Next(), while the
+ * other parts are merged concurrently into temporary Files by threads of the
+ * ThreadPool. Hence, the items are delivered in order while the merge uses
+ * num_parts threads. If Stable is set, equal items are delivered in the order
+ * of the Files.
+ */
+template <typename ValueType, typename Comparator, bool Stable = false>
+class ParallelMultiwayMergeTree
+{
+    static constexpr bool debug = false;
+
+public:
+    using Tree = MultiwayMergeTree<
+              ValueType,
+              typename std::vector<data::File::Reader>::iterator,
+              Comparator, Stable>;
+
+    template <typename FileIterator>
+    ParallelMultiwayMergeTree(
+        FileIterator files_begin, FileIterator files_end, bool consume,
+        const Comparator& comp, common::ThreadPool& pool, size_t num_parts,
+        data::BlockPool& block_pool, size_t local_worker_id, size_t dia_id)
+        : comp_(comp), num_parts_(std::max<size_t>(num_parts, 1)),
+          consume_(consume) {
+
+        for (FileIterator it = files_begin; it != files_end; ++it)
+            files_.push_back(&*it);
+
+        CalculateBounds();
+        SplitFiles(block_pool, local_worker_id, dia_id);
+
+        // the ranges hold references to all Blocks needed
+        files_.clear();
+        if (consume_) {
+            for (FileIterator it = files_begin; it != files_end; ++it)
+                it->Clear();
+        }
+
+        for (size_t p = 0; p < num_parts_; ++p) {
+            part_files_.emplace_back(block_pool, local_worker_id, dia_id);
+            done_.emplace_back();
+        }
+
+        // launch merges of parts 1..num_parts-1 in the thread pool
+        for (size_t p = 1; p < num_parts_; ++p) {
+            pool.Enqueue(
+                [this, p]() {
+                    std::vector<data::File::Reader> seq;
+                    MakeReaders(p, seq);
+                    auto writer = part_files_[p].GetWriter();
+                    if (!seq.empty()) {
+                        Tree puller(seq.begin(), seq.end(), comp_);
+                        while (puller.HasNext())
+                            writer.Put(puller.Next());
+                    }
+                    writer.Close();
+                    seq.clear();
+                    ranges_[p].clear();
+                    done_[p].signal();
+                });
+        }
+
+        // merge first part directly
+        MakeReaders(0, readers_);
+        if (!readers_.empty()) {
+            tree_ = std::make_unique<Tree>(
+                readers_.begin(), readers_.end(), comp_);
+        }
+    }
+
+    //! non-copyable: delete copy-constructor
+    ParallelMultiwayMergeTree(const ParallelMultiwayMergeTree&) = delete;
+    //! non-copyable: delete assignment operator
+    ParallelMultiwayMergeTree& operator = (
+        const ParallelMultiwayMergeTree&) = delete;
+
+    //! wait for outstanding merge jobs, which reference this object.
+    ~ParallelMultiwayMergeTree() {
+        for (size_t p = std::max<size_t>(part_ + 1, 1); p < num_parts_; ++p)
+            done_[p].wait();
+    }
+
+    bool HasNext() {
+        while (true) {
+            if (part_ == 0) {
+                if (tree_ && tree_->HasNext()) return true;
+            }
+            else if (part_ < num_parts_) {
+                if (part_reader_->HasNext()) return true;
+            }
+
+            if (part_ + 1 >= num_parts_) {
+                part_ = num_parts_;
+                return false;
+            }
+
+            if (part_ == 0) {
+                // release the ranges of the first part
+                tree_.reset();
+                readers_.clear();
+                ranges_[0].clear();
+            }
+
+            // advance to next part, wait for its merge to finish.
+            ++part_;
+            done_[part_].wait();
+            part_reader_ = std::make_unique<data::File::ConsumeReader>(
+                part_files_[part_].GetConsumeReader());
+        }
+    }
+
+    ValueType Next() {
+        assert(part_ < num_parts_);
+        if (part_ == 0)
+            return tree_->Next();
+        return part_reader_->template Next<ValueType>();
+    }
+
+private:
+    //! input Files, only used during construction
+    std::vector<data::File*> files_;
+    //! comparator
+    Comparator comp_;
+    //! number of parts merged in parallel
+    size_t num_parts_;
+    //! whether the ranges are consumed while merging
+    bool consume_;
+
+    //! item positions in the input Files delimiting the parts: part p consists
+    //! of the ranges [bounds_[p][f], bounds_[p+1][f]) of each File f.
+    std::vector<std::vector<size_t> > bounds_;
+
+    //! the non-empty ranges of the input Files of each part, in File order.
+    std::vector<std::vector<data::File> > ranges_;
+
+    //! merged parts, part 0 is unused since it is merged on-the-fly.
+    std::deque<data::File> part_files_;
+    //! signaled when the merge of a part is finished.
+    std::deque<common::Semaphore> done_;
+
+    //! readers and merge tree of the first part
+    std::vector<data::File::Reader> readers_;
+    std::unique_ptr<Tree> tree_;
+
+    //! current part delivered by Next()
+    size_t part_ = 0;
+    //! reader of the current part if part_ > 0
+    std::unique_ptr<data::File::ConsumeReader> part_reader_;
+
+    //! pick splitters from an equidistant sample of all Files, then find the
+    //! splitters' positions in each File.
+    void CalculateBounds() {
+        const size_t num_files = files_.size();
+
+        size_t total_items = 0;
+        for (const data::File* f : files_)
+            total_items += f->num_items();
+
+        bounds_.resize(num_parts_ + 1, std::vector<size_t>(num_files, 0));
+        for (size_t f = 0; f < num_files; ++f)
+            bounds_[num_parts_][f] = files_[f]->num_items();
+
+        if (num_parts_ == 1 || total_items == 0) return;
+
+        // sample proportionally to the File sizes
+        const size_t oversampling = 16;
+        const size_t sample_size = oversampling * num_parts_;
+
+        std::vector<ValueType> samples;
+        samples.reserve(sample_size + num_files);
+
+        for (const data::File* f : files_) {
+            size_t n = f->num_items();
+            if (n == 0) continue;
+            size_t s = std::max<size_t>(
+                1, (sample_size * n + total_items - 1) / total_items);
+            for (size_t i = 0; i < s; ++i) {
+                samples.emplace_back(
+                    f->GetItemAt<ValueType>((2 * i + 1) * n / (2 * s)));
+            }
+        }
+
+        std::sort(samples.begin(), samples.end(), comp_);
+
+        for (size_t p = 1; p < num_parts_; ++p) {
+            const ValueType& splitter = samples[p * samples.size() / num_parts_];
+            for (size_t f = 0; f < num_files; ++f) {
+                bounds_[p][f] = LowerBound(
+                    *files_[f], splitter, bounds_[p - 1][f]);
+            }
+        }
+
+        sLOG << "ParallelMultiwayMergeTree() parts" << num_parts_
+             << "files" << num_files << "items" << total_items;
+    }
+
+    //! binary search for the first item in [left,num_items) of the File which
+    //! is not less than the splitter, hence equal items are sent right.
+    size_t LowerBound(const data::File& file, const ValueType& splitter,
+                      size_t left) const {
+        size_t right = file.num_items();
+        while (left < right) {
+            size_t mid = (left + right) / 2;
+            if (comp_(file.GetItemAt<ValueType>(mid), splitter))
+                left = mid + 1;
+            else
+                right = mid;
+        }
+        return left;
+    }
+
+    //! take the item ranges of all parts out of the input Files. Blocks on the
+    //! boundary of two ranges are shared by both.
+    void SplitFiles(data::BlockPool& block_pool, size_t local_worker_id,
+                    size_t dia_id) {
+        ranges_.resize(num_parts_);
+        for (size_t p = 0; p < num_parts_; ++p) {
+            for (size_t f = 0; f < files_.size(); ++f) {
+                if (bounds_[p][f] == bounds_[p + 1][f]) continue;
+                ranges_[p].emplace_back(block_pool, local_worker_id, dia_id);
+                for (const data::Block& b :
+                     files_[f]->template GetItemRange<ValueType>(
+                         bounds_[p][f], bounds_[p + 1][f]))
+                {
+                    ranges_[p].back().AppendBlock(b);
+                }
+            }
+        }
+    }
+
+    //! create readers for the non-empty ranges of part p. They do not
+    //! prefetch, since each thread may only hold one Block of each File.
+    void MakeReaders(size_t p, std::vector<data::File::Reader>& seq) {
+        seq.reserve(ranges_[p].size());
+        for (data::File& range : ranges_[p])
+            seq.emplace_back(range.GetReader(consume_, /* prefetch */ 0));
+    }
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_PARALLEL_MULTIWAY_MERGE_HEADER
+
+/******************************************************************************/
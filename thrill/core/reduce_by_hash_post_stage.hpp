@@ -17,11 +17,14 @@
 #define THRILL_CORE_REDUCE_BY_HASH_POST_STAGE_HEADER
 
 #include <thrill/api/context.hpp>
+#include <thrill/common/die.hpp>
 #include <thrill/common/logger.hpp>
 #include <thrill/core/reduce_bucket_hash_table.hpp>
+#include <thrill/core/reduce_by_sort_post_stage.hpp>
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 #include <thrill/data/file.hpp>
 
 #include <algorithm>
@@ -29,40 +32,21 @@
 #include <cmath>
 #include <functional>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace thrill {
 namespace core {
 
-//! Emitter implementation to plug into a reduce hash table for
-//! collecting/flushing items while reducing. Items flushed in the post-stage
-//! are passed to the next DIA node for processing.
-template <
-    typename KeyValuePair, typename ValueType, typename Emitter, bool SendPair>
-class ReduceByHashPostStageEmitter
-{
-public:
-    explicit ReduceByHashPostStageEmitter(const Emitter& emit)
-        : emit_(emit) { }
-
-    //! output an element into a partition, template specialized for SendPair
-    //! and non-SendPair types
-    void Emit(const KeyValuePair& p) {
-        ReducePostStageEmitterSwitch<
-            KeyValuePair, ValueType, Emitter, SendPair>::Put(p, emit_);
-    }
+//! whether keys of type Key can be compared with operator <.
+template <typename Key, typename = void>
+struct ReduceKeyIsComparable : public std::false_type { };
 
-    //! output an element into a partition, template specialized for SendPair
-    //! and non-SendPair types
-    void Emit(const size_t& /* partition_id */, const KeyValuePair& p) {
-        Emit(p);
-    }
-
-public:
-    //! Set of emitters, one per partition.
-    Emitter emit_;
-};
+template <typename Key>
+struct ReduceKeyIsComparable<
+    Key, decltype(void(std::declval<const Key&>() < std::declval<const Key&>()))>
+    : public std::true_type { };
 
 template <typename ValueType, typename Key, typename Value,
           typename KeyExtractor, typename ReduceFunction, typename Emitter,
@@ -179,80 +163,29 @@ public:
 
         assert(consume && "Items were spilled hence Flushing must consume");
 
-        // if partially reduce files remain, create new hash tables to process
-        // them iteratively.
-
-        size_t iteration = 1;
-
-        while (remaining_files.size())
-        {
-            sLOG1 << "ReducePostStage: re-reducing items from"
-                  << remaining_files.size() << "spilled files"
-                  << "iteration" << iteration;
-            sLOG1 << "-- Try to increase the amount of RAM to avoid this.";
-
-            std::vector<data::File> next_remaining_files;
-
-            Table subtable(
-                table_.ctx(), table_.dia_id(),
-                table_.key_extractor(), table_.reduce_function(), emitter_,
-                /* num_partitions */ 32, config_, /* immediate_flush */ false,
-                IndexFunction(iteration, table_.index_function()),
-                table_.equal_to_function());
-
-            subtable.Initialize(table_.limit_memory_bytes());
-
-            size_t num_subfile = 0;
+        // if partially reduced files remain, process them depth-first with
+        // new hash tables, each with a fresh hash seed per level.
 
-            for (data::File& file : remaining_files)
-            {
-                // insert all items from the partially reduced file
-                sLOG << "re-reducing subfile" << num_subfile++
-                     << "containing" << file.num_items() << "items";
+        std::vector<SpilledFile> stack;
+        for (data::File& file : remaining_files)
+            stack.emplace_back(std::move(file), 1);
 
-                data::File::ConsumeReader reader = file.GetConsumeReader();
+        sLOG1 << "ReducePostStage: re-reducing items from"
+              << stack.size() << "spilled files";
+        sLOG1 << "-- Try to increase the amount of RAM to avoid this.";
 
-                while (reader.HasNext()) {
-                    subtable.Insert(reader.Next<KeyValuePair>());
-                }
+        while (!stack.empty())
+        {
+            SpilledFile spilled = std::move(stack.back());
+            stack.pop_back();
 
-                // after insertion, flush fully reduced partitions and save
-                // remaining files for next iteration.
-
-                std::vector<data::File>& subfiles = subtable.partition_files();
-
-                for (size_t id = 0; id < subfiles.size(); ++id)
-                {
-                    // get the actual reader from the file
-                    data::File& subfile = subfiles[id];
-
-                    // if items have been spilled, store for a second reduce
-                    if (subfile.num_items() > 0) {
-                        subtable.SpillPartition(id);
-
-                        sLOG << "partition" << id << "contains"
-                             << subfile.num_items() << "partially reduced items";
-
-                        next_remaining_files.emplace_back(std::move(subfile));
-                    }
-                    else {
-                        sLOG << "partition" << id << "contains"
-                             << subtable.items_per_partition(id)
-                             << "fully reduced items";
-
-                        subtable.FlushPartitionEmit(
-                            id, /* consume */ true,
-                            [this, writer](
-                                const size_t& partition_id, const KeyValuePair& p) {
-                                if (DoCache) writer->Put(p);
-                                emitter_.Emit(partition_id, p);
-                            });
-                    }
-                }
+            if (spilled.second <= ReduceConfig::max_spill_levels_) {
+                ReduceSpilledFile<DoCache>(spilled, stack, writer);
+            }
+            else {
+                ReduceSpilledFileBySort<DoCache>(
+                    spilled.first, writer, ReduceKeyIsComparable<Key>());
             }
-
-            remaining_files = std::move(next_remaining_files);
-            ++iteration;
         }
 
         LOG << "Flushed items";
@@ -298,9 +231,171 @@ public:
     //! Returns the total num of items in the table.
     size_t num_items() const { return table_.num_items(); }
 
+    //! Returns the maximum recursion level of re-reducing spilled files.
+    size_t max_spill_level() const { return max_spill_level_; }
+
     //! \}
 
 private:
+    //! A File of spilled partially reduced items and its recursion level.
+    using SpilledFile = std::pair<data::File, size_t>;
+
+    //! Reduce a spilled File in a hybrid hash table: the number of partitions
+    //! is chosen such that each spilled partition is expected to fit into RAM
+    //! on the next level, and all partitions remain in RAM until they
+    //! overflow. Fully reduced partitions are emitted and overflowing ones are
+    //! pushed onto the stack for the next level.
+    template <bool DoCache>
+    void ReduceSpilledFile(SpilledFile& spilled, std::vector<SpilledFile>& stack,
+                           data::File::Writer* writer) {
+        data::File& file = spilled.first;
+        const size_t level = spilled.second;
+
+        const size_t limit_memory_bytes = table_.limit_memory_bytes();
+        const double fill_rate =
+            std::max(config_.limit_partition_fill_rate(), 0.1);
+
+        // upper bound on the memory required for all distinct keys
+        const size_t need_bytes = static_cast<size_t>(
+            static_cast<double>(file.num_items() * sizeof(KeyValuePair))
+            / fill_rate);
+
+        // more partitions make spilled partitions smaller, but each partition
+        // should still hold a reasonable number of items.
+        const size_t max_partitions = std::max<size_t>(
+            size_t(min_partitions_),
+            limit_memory_bytes / (sizeof(KeyValuePair) * min_partition_items_));
+
+        const size_t num_partitions = std::min(
+            max_partitions,
+            std::max<size_t>(
+                size_t(min_partitions_),
+                (need_bytes + limit_memory_bytes - 1) / limit_memory_bytes));
+
+        sLOG << "ReducePostStage: level" << level << "re-reducing"
+             << file.num_items() << "items into" << num_partitions
+             << "partitions";
+
+        max_spill_level_ = std::max(max_spill_level_, level);
+
+        Table subtable(
+            table_.ctx(), table_.dia_id(),
+            table_.key_extractor(), table_.reduce_function(), emitter_,
+            num_partitions, config_, /* immediate_flush */ false,
+            IndexFunction(level, table_.index_function()),
+            table_.equal_to_function());
+
+        // small files do not need the whole memory, but each partition must
+        // still be able to hold some items, otherwise everything is spilled.
+        const size_t min_bytes =
+            num_partitions * min_partition_items_ * sizeof(KeyValuePair);
+
+        subtable.Initialize(
+            std::min(limit_memory_bytes,
+                     std::max(min_bytes, need_bytes + sizeof(KeyValuePair))));
+
+        {
+            // insert all items from the partially reduced file
+            data::File::ConsumeReader reader = file.GetConsumeReader();
+
+            while (reader.HasNext()) {
+                subtable.Insert(reader.Next<KeyValuePair>());
+            }
+        }
+
+        // after insertion, flush fully reduced partitions and save remaining
+        // files for next level.
+
+        std::vector<data::File>& subfiles = subtable.partition_files();
+
+        for (size_t id = 0; id < subfiles.size(); ++id)
+        {
+            // get the actual reader from the file
+            data::File& subfile = subfiles[id];
+
+            // if items have been spilled, store for a further reduce
+            if (subfile.num_items() > 0) {
+                subtable.SpillPartition(id);
+
+                sLOG << "partition" << id << "contains"
+                     << subfile.num_items() << "partially reduced items";
+
+                stack.emplace_back(std::move(subfile), level + 1);
+            }
+            else {
+                sLOG << "partition" << id << "contains"
+                     << subtable.items_per_partition(id)
+                     << "fully reduced items";
+
+                subtable.FlushPartitionEmit(
+                    id, /* consume */ true,
+                    [this, writer](
+                        const size_t& partition_id, const KeyValuePair& p) {
+                        if (DoCache) writer->Put(p);
+                        emitter_.Emit(partition_id, p);
+                    });
+            }
+        }
+    }
+
+    //! Reduce a spilled File beyond max_spill_levels_ with a sort-based post
+    //! stage: its keys could not be separated by hashing, e.g. because the
+    //! hash function maps many distinct keys to the same value.
+    template <bool DoCache>
+    void ReduceSpilledFileBySort(data::File& file, data::File::Writer* writer,
+                                 std::true_type /* key_is_comparable */) {
+        sLOG1 << "ReducePostStage: reducing" << file.num_items()
+              << "items by sorting after"
+              << size_t(ReduceConfig::max_spill_levels_)
+              << "levels of hashing, check the hash function.";
+
+        using SortEmitter = std::function<void(const KeyValuePair&)>;
+        using SortStage = ReduceBySortPostStage<
+                  ValueType, Key, Value, KeyExtractor, ReduceFunction,
+                  SortEmitter, /* SendPair */ true, ReduceConfig>;
+
+        SortStage sort_stage(
+            table_.ctx(), table_.dia_id(),
+            table_.key_extractor(), table_.reduce_function(),
+            [this, writer](const KeyValuePair& p) {
+                if (DoCache) writer->Put(p);
+                emitter_.Emit(p);
+            },
+            config_);
+        sort_stage.Initialize(table_.limit_memory_bytes());
+
+        {
+            data::File::ConsumeReader reader = file.GetConsumeReader();
+            while (reader.HasNext())
+                sort_stage.Insert(reader.Next<KeyValuePair>());
+        }
+
+        sort_stage.PushData(/* consume */ true);
+        sort_stage.Dispose();
+    }
+
+    //! Without operator < on the key, a File which cannot be separated by
+    //! hashing cannot be reduced in the memory limit.
+    template <bool DoCache>
+    void ReduceSpilledFileBySort(data::File& file, data::File::Writer*,
+                                 std::false_type /* key_is_comparable */) {
+        die("ReducePostStage: a spilled partition with " << file.num_items()
+            << " items still exceeds the memory after "
+            << size_t(ReduceConfig::max_spill_levels_)
+            << " levels of re-reducing."
+            " The hash function probably maps many distinct keys to equal"
+            " values, use a better one or a key with operator <.");
+    }
+
+    //! minimum number of partitions of a re-reduce table
+    static constexpr size_t min_partitions_ = 32;
+
+    //! minimum number of items a partition of a re-reduce table should hold
+    static constexpr size_t min_partition_items_ = 16;
+
+    //! maximum recursion level reached while re-reducing spilled files
+    size_t max_spill_level_ = 0;
+
     //! Stored reduce config to initialize the subtable.
     ReduceConfig config_;
 
@@ -0,0 +1,278 @@
+/*******************************************************************************
+ * thrill/core/reduce_by_sort_post_stage.hpp
+ *
+ * Sort-based post stage for reduce: sorted runs are merged and adjacent items
+ * with equal keys are reduced.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_BY_SORT_POST_STAGE_HEADER
+#define THRILL_CORE_REDUCE_BY_SORT_POST_STAGE_HEADER
+
+#include <thrill/api/context.hpp>
+#include <thrill/common/logger.hpp>
+#include <thrill/core/multiway_merge.hpp>
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_table.hpp>
+#include <thrill/data/file.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A post stage for reduce operations which groups items by sorting instead of
+ * hashing. Items are collected in a buffer, which is sorted by key and reduced
+ * whenever it is full. If the buffer still holds many items after reducing, it
+ * is written to a sorted run. When pushing data, all runs are merged with a
+ * loser tree and adjacent items with equal keys are reduced.
+ *
+ * This is preferable to hashing for very high key cardinality with little
+ * reduction: hash tables then spill most items repeatedly, while sorting
+ * writes each item only once.
+ */
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool SendPair = false,
+          typename ReduceConfig_ = DefaultReduceConfig,
+          typename KeyCompareFunction = std::less<Key> >
+class ReduceBySortPostStage
+{
+    static constexpr bool debug = false;
+
+public:
+    using KeyValuePair = std::pair<Key, Value>;
+    using ReduceConfig = ReduceConfig_;
+
+    using StageEmitter = ReduceByHashPostStageEmitter<
+              KeyValuePair, ValueType, Emitter, SendPair>;
+
+    ReduceBySortPostStage(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        const Emitter& emit,
+        const ReduceConfig& config = ReduceConfig(),
+        const KeyCompareFunction& key_compare_function = KeyCompareFunction())
+        : ctx_(ctx), dia_id_(dia_id),
+          key_extractor_(key_extractor),
+          reduce_function_(reduce_function),
+          config_(config),
+          emitter_(emit),
+          key_compare_function_(key_compare_function) { }
+
+    //! non-copyable: delete copy-constructor
+    ReduceBySortPostStage(const ReduceBySortPostStage&) = delete;
+    //! non-copyable: delete assignment operator
+    ReduceBySortPostStage& operator = (const ReduceBySortPostStage&) = delete;
+
+    void Initialize(size_t limit_memory_bytes) {
+        limit_items_ = std::max<size_t>(
+            size_t(min_items_), limit_memory_bytes / sizeof(KeyValuePair));
+        items_.reserve(limit_items_);
+    }
+
+    void Insert(const Value& p) {
+        Insert(KeyValuePair(key_extractor_(p), p));
+    }
+
+    void Insert(const KeyValuePair& kv) {
+        assert(limit_items_ != 0 && "Initialize() was not called");
+
+        items_.emplace_back(kv);
+        ++num_items_;
+
+        if (items_.size() < limit_items_) return;
+
+        SortAndReduce();
+
+        // write a run only if reducing in RAM did not free enough space
+        if (static_cast<double>(items_.size()) >=
+            static_cast<double>(limit_items_) * ReduceConfig::sort_run_fill_rate_)
+            WriteRun();
+    }
+
+    //! Push data into emitter
+    void PushData(bool consume = false) {
+        if (!cache_)
+        {
+            SortAndReduce();
+
+            if (runs_.empty()) {
+                // no run was written, hence all items are in RAM.
+                for (const KeyValuePair& kv : items_)
+                    emitter_.Emit(kv);
+
+                if (consume) std::vector<KeyValuePair>().swap(items_);
+            }
+            else {
+                // merge the runs and cache the output stream.
+                WriteRun();
+                std::vector<KeyValuePair>().swap(items_);
+
+                cache_ = ctx_.GetFilePtr(dia_id_);
+                data::File::Writer writer = cache_->GetWriter();
+                MergeRuns(writer);
+                runs_.clear();
+            }
+        }
+        else
+        {
+            // previous PushData() has stored data in cache_
+            data::File::Reader reader = cache_->GetReader(consume);
+            while (reader.HasNext())
+                emitter_.Emit(reader.Next<KeyValuePair>());
+        }
+    }
+
+    void Dispose() {
+        std::vector<KeyValuePair>().swap(items_);
+        runs_.clear();
+        if (cache_) cache_.reset();
+    }
+
+    //! \name Accessors
+    //! \{
+
+    //! Returns the total number of items inserted.
+    size_t num_items() const { return num_items_; }
+
+    //! Returns the number of sorted runs written.
+    size_t num_runs() const { return num_runs_; }
+
+    //! \}
+
+private:
+    //! Sort the buffer by key and reduce adjacent items with equal keys.
+    void SortAndReduce() {
+        if (items_.empty()) return;
+
+        std::sort(items_.begin(), items_.end(),
+                  [this](const KeyValuePair& a, const KeyValuePair& b) {
+                      return key_compare_function_(a.first, b.first);
+                  });
+
+        auto out = items_.begin();
+        for (auto it = items_.begin() + 1; it != items_.end(); ++it)
+        {
+            if (key_compare_function_(out->first, it->first))
+                *(++out) = std::move(*it);
+            else
+                out->second = reduce_function_(out->second, it->second);
+        }
+        items_.erase(out + 1, items_.end());
+    }
+
+    //! Write the sorted and reduced buffer into a new run.
+    void WriteRun() {
+        if (items_.empty()) return;
+
+        runs_.emplace_back(ctx_.GetFile(dia_id_));
+        data::File::Writer writer = runs_.back().GetWriter();
+        for (const KeyValuePair& kv : items_)
+            writer.Put(kv);
+
+        sLOG << "ReduceBySortPostStage: wrote run" << num_runs_
+             << "with" << items_.size() << "items";
+
+        items_.clear();
+        ++num_runs_;
+    }
+
+    //! Merge all runs, reduce adjacent items with equal keys and emit them.
+    //! The runs are consumed.
+    void MergeRuns(data::File::Writer& writer) {
+        sLOG << "ReduceBySortPostStage: merging" << runs_.size() << "runs";
+
+        std::vector<data::File::ConsumeReader> seq;
+        seq.reserve(runs_.size());
+
+        for (data::File& run : runs_)
+            seq.emplace_back(run.GetConsumeReader());
+
+        auto puller = make_multiway_merge_tree<KeyValuePair>(
+            seq.begin(), seq.end(),
+            [this](const KeyValuePair& a, const KeyValuePair& b) {
+                return key_compare_function_(a.first, b.first);
+            });
+
+        if (puller.HasNext()) {
+            KeyValuePair curr = puller.Next();
+
+            while (puller.HasNext())
+            {
+                KeyValuePair next = puller.Next();
+
+                if (key_compare_function_(curr.first, next.first)) {
+                    writer.Put(curr);
+                    emitter_.Emit(curr);
+                    curr = std::move(next);
+                }
+                else {
+                    curr.second = reduce_function_(curr.second, next.second);
+                }
+            }
+
+            writer.Put(curr);
+            emitter_.Emit(curr);
+        }
+    }
+
+    //! minimum number of items in the buffer
+    static constexpr size_t min_items_ = 16;
+
+    //! Context
+    Context& ctx_;
+
+    //! Associated DIA id
+    size_t dia_id_;
+
+    //! Key extractor function for extracting a key from a value.
+    KeyExtractor key_extractor_;
+
+    //! Reduce function for reducing two values.
+    ReduceFunction reduce_function_;
+
+    //! Stored reduce config
+    ReduceConfig config_;
+
+    //! Emitter for output to next DIA node.
+    StageEmitter emitter_;
+
+    //! Comparator function for keys.
+    KeyCompareFunction key_compare_function_;
+
+    //! buffer of items to sort and reduce
+    std::vector<KeyValuePair> items_;
+
+    //! maximum number of items in the buffer
+    size_t limit_items_ = 0;
+
+    //! sorted and reduced runs
+    std::vector<data::File> runs_;
+
+    //! total number of inserted items
+    size_t num_items_ = 0;
+
+    //! total number of runs written
+    size_t num_runs_ = 0;
+
+    //! File for storing data in-case we merged runs.
+    data::FilePtr cache_;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_BY_SORT_POST_STAGE_HEADER
+
+/******************************************************************************/
@@ -19,12 +19,15 @@
 #include <thrill/common/defines.hpp>
 #include <thrill/common/math.hpp>
 
+#include <utility>
+
 namespace thrill {
 namespace core {
 
 //! This is the Hash128to64 function from Google's cityhash (available under the
 //! MIT License).
-static inline uint64_t Hash128to64(const uint64_t upper, const uint64_t lower) {
+static inline uint64_t Hash128to64(
+    const uint64_t upper, const uint64_t lower) noexcept {
     // Murmur-inspired hashing.
     const uint64_t k = 0x9DDFEA08EB382D69ull;
     uint64_t a = (lower ^ upper) * k;
@@ -79,6 +82,12 @@ public:
         return Result { partition_id, remaining_hash };
     }
 
+    //! hash of a key, for auxiliary hash maps over the same keys.
+    size_t hash(const Key& k) const
+    noexcept(noexcept(std::declval<const HashFunction&>()(k))) {
+        return Hash128to64(salt_, hash_function_(k));
+    }
+
 private:
     uint64_t salt_;
     HashFunction hash_function_;
@@ -135,6 +144,11 @@ public:
         };
     }
 
+    //! hash of a key, for auxiliary hash maps over the same keys.
+    size_t hash(const Key& k) const noexcept {
+        return static_cast<size_t>(k);
+    }
+
     //! inverse mapping: takes a bucket index and returns the smallest index
     //! delivered to the bucket.
     size_t inverse(size_t bucket, const size_t& num_buckets) {
@@ -184,6 +198,35 @@ public:
     }
 };
 
+//! Emitter implementation to plug into a reduce hash table for
+//! collecting/flushing items while reducing. Items flushed in the post-stage
+//! are passed to the next DIA node for processing.
+template <
+    typename KeyValuePair, typename ValueType, typename Emitter, bool SendPair>
+class ReduceByHashPostStageEmitter
+{
+public:
+    explicit ReduceByHashPostStageEmitter(const Emitter& emit)
+        : emit_(emit) { }
+
+    //! output an element into a partition, template specialized for SendPair
+    //! and non-SendPair types
+    void Emit(const KeyValuePair& p) {
+        ReducePostStageEmitterSwitch<
+            KeyValuePair, ValueType, Emitter, SendPair>::Put(p, emit_);
+    }
+
+    //! output an element into a partition, template specialized for SendPair
+    //! and non-SendPair types
+    void Emit(const size_t& /* partition_id */, const KeyValuePair& p) {
+        Emit(p);
+    }
+
+public:
+    //! Set of emitters, one per partition.
+    Emitter emit_;
+};
+
 } // namespace core
 } // namespace thrill
 
@@ -21,13 +21,16 @@
 #include <thrill/core/reduce_functional.hpp>
 #include <thrill/core/reduce_old_probing_hash_table.hpp>
 #include <thrill/core/reduce_probing_hash_table.hpp>
+#include <thrill/core/reduce_swiss_hash_table.hpp>
 #include <thrill/data/block_writer.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <functional>
+#include <random>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -84,6 +87,13 @@ public:
         writer_[partition_id].Flush();
     }
 
+    //! Returns the total number of items emitted into all partitions.
+    size_t num_emitted() const {
+        size_t total = 0;
+        for (const size_t& s : stats_) total += s;
+        return total;
+    }
+
     void CloseAll() {
         sLOG << "emit stats:";
         size_t i = 0;
@@ -140,7 +150,9 @@ public:
           table_(ctx, dia_id,
                  key_extractor, reduce_function, emit_,
                  num_partitions, config, /* immediate_flush */ true,
-                 index_function, equal_to_function) {
+                 index_function, equal_to_function),
+          hot_keys_(0, HotKeyHash { index_function }, equal_to_function),
+          sketch_(0, HotKeyHash { index_function }, equal_to_function) {
         sLOG << "creating ReducePreStage with" << emit.size() << "output emitters";
 
         assert(num_partitions == emit.size());
@@ -152,19 +164,35 @@ public:
     ReducePreStage& operator = (const ReducePreStage&) = delete;
 
     void Initialize(size_t limit_memory_bytes) {
+        if (ReduceConfig::use_hot_key_detection_) {
+            // reserve memory for the hot keys and the frequency sketch, such
+            // that the hot keys never have to be evicted.
+            size_t reserve = std::min(
+                limit_memory_bytes / 2,
+                2 * hot_key_capacity_ * (sizeof(KeyValuePair) + 4 * sizeof(size_t)));
+            limit_memory_bytes -= reserve;
+        }
         table_.Initialize(limit_memory_bytes);
     }
 
     void Insert(const Value& p) {
+        if (ReduceConfig::use_hot_key_detection_ ||
+            ReduceConfig::use_adaptive_bypass_)
+            return Insert(KeyValuePair(table_.key_extractor()(p), p));
         return table_.Insert(p);
     }
 
     void Insert(const KeyValuePair& kv) {
+        if (ReduceConfig::use_hot_key_detection_ && InsertHotKey(kv))
+            return;
+        if (ReduceConfig::use_adaptive_bypass_)
+            return InsertAdaptive(kv);
         return table_.Insert(kv);
     }
 
     //! Flush all partitions
     void FlushAll() {
+        FlushHotKeys();
         for (size_t id = 0; id < table_.num_partitions(); ++id) {
             FlushPartition(id, /* consume */ true);
         }
@@ -195,6 +223,12 @@ public:
     common::Range key_range(size_t partition_id)
     { return table_.key_range(partition_id); }
 
+    //! Returns the number of hot keys detected.
+    size_t num_hot_keys() const { return hot_keys_.size(); }
+
+    //! Returns the number of items sent bypassing the hash table.
+    size_t num_bypassed() const { return num_bypassed_; }
+
     //! \}
 
 private:
@@ -203,6 +237,203 @@ private:
 
     //! the first-level hash table implementation
     Table table_;
+
+    //! \name Hot Key Detection
+    //! \{
+
+    //! maximum number of hot keys and of counters in the sketch
+    static constexpr size_t hot_key_capacity_ = ReduceConfig::hot_key_capacity_;
+
+    //! number of samples before any key is considered hot.
+    static constexpr size_t hot_key_min_samples_ = hot_key_capacity_;
+
+    //! hashes keys with the IndexFunction, such that keys need no std::hash
+    //! but only the hash function given to the stage.
+    struct HotKeyHash {
+        IndexFunction index_function;
+
+        size_t operator () (const Key& k) const
+        noexcept(noexcept(std::declval<const IndexFunction&>().hash(k))) {
+            return index_function.hash(k);
+        }
+    };
+
+    using HotKeyMap = std::unordered_map<
+              Key, Value, HotKeyHash, EqualToFunction>;
+    using SketchMap = std::unordered_map<
+              Key, size_t, HotKeyHash, EqualToFunction>;
+
+    //! reduced values of the hot keys, flushed only by FlushAll().
+    HotKeyMap hot_keys_;
+
+    //! Misra-Gries frequency sketch over the sampled keys.
+    SketchMap sketch_;
+
+    //! number of items to insert until the next sample. The gaps are random
+    //! to avoid aliasing with periodic input.
+    size_t sample_countdown_ = ReduceConfig::hot_key_sample_interval_;
+
+    //! random generator for the sample gaps
+    std::minstd_rand sample_rng_;
+
+    //! total number of sampled items
+    size_t num_samples_ = 0;
+
+    //! reduce kv into the hot key table if its key is hot, and sample on
+    //! average every hot_key_sample_interval_-th item. Returns true if kv was
+    //! consumed.
+    bool InsertHotKey(const KeyValuePair& kv) {
+        if (!hot_keys_.empty()) {
+            typename HotKeyMap::iterator it = hot_keys_.find(kv.first);
+            if (it != hot_keys_.end()) {
+                it->second = table_.reduce_function()(it->second, kv.second);
+                return true;
+            }
+        }
+
+        if (--sample_countdown_ != 0)
+            return false;
+        sample_countdown_ =
+            1 + sample_rng_() % (2 * ReduceConfig::hot_key_sample_interval_ - 1);
+        ++num_samples_;
+
+        // promote the key if its estimated frequency is four times the error
+        // bound of the sketch. Items of the key already in the table are
+        // reduced later.
+        size_t count = UpdateSketch(kv.first);
+        if (hot_keys_.size() < hot_key_capacity_ &&
+            num_samples_ >= hot_key_min_samples_ &&
+            count * hot_key_capacity_ >= 4 * num_samples_) {
+            sLOG << "ReducePreStage detected hot key with" << count
+                 << "of" << num_samples_ << "samples";
+            sketch_.erase(kv.first);
+            hot_keys_.emplace(kv.first, kv.second);
+            return true;
+        }
+        return false;
+    }
+
+    //! count a sampled key in the Misra-Gries sketch and return its estimated
+    //! frequency, which is at most num_samples_ / hot_key_capacity_ too low.
+    size_t UpdateSketch(const Key& key) {
+        typename SketchMap::iterator it = sketch_.find(key);
+        if (it != sketch_.end())
+            return ++it->second;
+
+        if (sketch_.size() < hot_key_capacity_) {
+            sketch_.emplace(key, 1);
+            return 1;
+        }
+
+        // sketch full: decrement all counters and drop those reaching zero.
+        for (it = sketch_.begin(); it != sketch_.end(); ) {
+            if (--it->second == 0)
+                it = sketch_.erase(it);
+            else
+                ++it;
+        }
+        return 0;
+    }
+
+    //! emit the reduced values of all hot keys into their partitions.
+    void FlushHotKeys() {
+        if (hot_keys_.empty()) return;
+        sLOG << "ReducePreStage flushing" << hot_keys_.size() << "hot keys";
+
+        for (const typename HotKeyMap::value_type& hk : hot_keys_) {
+            typename IndexFunction::Result h = table_.index_function()(
+                hk.first, table_.num_partitions(),
+                table_.num_buckets_per_partition(), table_.num_buckets());
+            emit_.Emit(h.partition_id, KeyValuePair(hk.first, hk.second));
+        }
+
+        // swap with empty maps to free the memory, keeping the hashers.
+        HotKeyMap(0, hot_keys_.hash_function(), hot_keys_.key_eq())
+        .swap(hot_keys_);
+        SketchMap(0, sketch_.hash_function(), sketch_.key_eq())
+        .swap(sketch_);
+    }
+
+    //! \}
+
+    //! \name Adaptive Bypass
+    //! \{
+
+    //! whether items are currently sent bypassing the hash table
+    bool bypass_ = false;
+
+    //! number of items inserted in the current window
+    size_t window_items_ = 0;
+
+    //! number of emitted items and of items in the table at the start of the
+    //! current window
+    size_t window_emitted_ = 0;
+    size_t window_table_items_ = 0;
+
+    //! number of windows bypassed since the last measurement
+    size_t bypass_windows_ = 0;
+
+    //! total number of items sent bypassing the hash table
+    size_t num_bypassed_ = 0;
+
+    //! insert kv into the hash table, or emit it directly into its partition
+    //! if the table is bypassed.
+    void InsertAdaptive(const KeyValuePair& kv) {
+        if (bypass_) {
+            typename IndexFunction::Result h = table_.index_function()(
+                kv.first, table_.num_partitions(),
+                table_.num_buckets_per_partition(), table_.num_buckets());
+            emit_.Emit(h.partition_id, kv);
+            ++num_bypassed_;
+        }
+        else {
+            table_.Insert(kv);
+        }
+
+        if (++window_items_ == ReduceConfig::bypass_window_)
+            UpdateBypass();
+    }
+
+    //! at the end of a window: decide from the reduction ratio whether to
+    //! bypass the hash table, or periodically return to the table to measure
+    //! it again.
+    void UpdateBypass() {
+        window_items_ = 0;
+
+        if (bypass_) {
+            if (++bypass_windows_ < ReduceConfig::bypass_probe_interval_)
+                return;
+            bypass_ = false;
+            bypass_windows_ = 0;
+        }
+        else {
+            // items of the window which were not reduced either remain in the
+            // table or have been emitted by spills. The tables also count
+            // reductions into the sentinel key as items, hence this is only an
+            // estimate, which can even become negative after a spill.
+            double output =
+                static_cast<double>(emit_.num_emitted() + table_.num_items())
+                - static_cast<double>(window_emitted_ + window_table_items_);
+            double reduction =
+                1.0 - std::max(output, 0.0) / ReduceConfig::bypass_window_;
+
+            bypass_ = reduction < ReduceConfig::bypass_min_reduction_;
+            sLOG << "ReducePreStage reduction" << reduction
+                 << (bypass_ ? "bypassing" : "keeping") << "hash table";
+
+            // the items in the table cannot be reduced with bypassed ones,
+            // and the next measurement should start with an empty table.
+            if (bypass_) {
+                for (size_t id = 0; id < table_.num_partitions(); ++id)
+                    FlushPartition(id, /* consume */ true);
+            }
+        }
+
+        window_emitted_ = emit_.num_emitted();
+        window_table_items_ = table_.num_items();
+    }
+
+    //! \}
 };
 
 } // namespace core
@@ -0,0 +1,525 @@
+/*******************************************************************************
+ * thrill/core/reduce_swiss_hash_table.hpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+#define THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+
+#include <thrill/core/reduce_functional.hpp>
+#include <thrill/core/reduce_table.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace thrill {
+namespace core {
+
+/*!
+ * A reduce hash table with a Swiss table layout: the slots of each partition
+ * are organized in groups of 16, and each slot has a one byte control tag,
+ * which is either empty or contains seven bits of the key's hash. A lookup
+ * compares the 16 tags of a group with the key's tag in parallel (using SSE2
+ * if available) and only compares the keys of matching slots. Groups are
+ * probed linearly.
+ *
+ * The key/value slots of a group are contiguous and the slot array is aligned
+ * to cache lines. Contrary to ReduceProbingHashTable, the table needs no
+ * sentinel key, as empty slots are marked in the control bytes.
+ *
+ * The table requires the remaining hash bits of ReduceByHash and hence cannot
+ * be used with ReduceByIndex.
+ *
+ *     Partition 0               Partition 1
+ *     Group 0       Group 1     Group 0       Group 1
+ *    +-------------+-----------+-------------+-----------+
+ *    | 16 tags     | 16 tags   | 16 tags     | 16 tags   |  control bytes
+ *    +-------------+-----------+-------------+-----------+
+ *    | 16 slots    | 16 slots  | 16 slots    | 16 slots  |  key/value pairs
+ *    +-------------+-----------+-------------+-----------+
+ */
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction, typename Emitter,
+          const bool VolatileKey,
+          typename ReduceConfig_,
+          typename IndexFunction,
+          typename EqualToFunction = std::equal_to<Key> >
+class ReduceSwissHashTable
+    : public ReduceTable<ValueType, Key, Value,
+                         KeyExtractor, ReduceFunction, Emitter,
+                         VolatileKey, ReduceConfig_,
+                         IndexFunction, EqualToFunction>
+{
+    using Super = ReduceTable<ValueType, Key, Value,
+                              KeyExtractor, ReduceFunction, Emitter,
+                              VolatileKey, ReduceConfig_, IndexFunction,
+                              EqualToFunction>;
+    using Super::debug;
+    static constexpr bool debug_items = false;
+
+    static_assert(!std::is_same<IndexFunction, ReduceByIndex<Key> >::value,
+                  "ReduceSwissHashTable requires a hash index function");
+
+public:
+    using KeyValuePair = std::pair<Key, Value>;
+    using ReduceConfig = ReduceConfig_;
+
+    //! number of slots in a group, which are matched in parallel.
+    static constexpr size_t group_size_ = 16;
+
+    //! control byte of an empty slot, full slots store seven hash bits.
+    static constexpr uint8_t ctrl_empty_ = 0x80;
+
+    ReduceSwissHashTable(
+        Context& ctx, size_t dia_id,
+        const KeyExtractor& key_extractor,
+        const ReduceFunction& reduce_function,
+        Emitter& emitter,
+        size_t num_partitions,
+        const ReduceConfig& config = ReduceConfig(),
+        bool immediate_flush = false,
+        const IndexFunction& index_function = IndexFunction(),
+        const EqualToFunction& equal_to_function = EqualToFunction())
+        : Super(ctx, dia_id,
+                key_extractor, reduce_function, emitter,
+                num_partitions, config, immediate_flush,
+                index_function, equal_to_function)
+    { assert(num_partitions > 0); }
+
+    //! Construct the hash table itself and mark all slots as empty.
+    void Initialize(size_t limit_memory_bytes) {
+        assert(!slots_);
+
+        limit_memory_bytes_ = limit_memory_bytes;
+
+        // calculate num_groups_per_partition_ from the memory limit and the
+        // number of partitions required, each slot also needs a control byte.
+
+        num_groups_per_partition_ = std::max<size_t>(
+            1,
+            (size_t)(static_cast<double>(limit_memory_bytes_)
+                     / static_cast<double>(
+                         group_size_ * (sizeof(KeyValuePair) + 1))
+                     / static_cast<double>(num_partitions_)));
+
+        num_buckets_per_partition_ = num_groups_per_partition_ * group_size_;
+        num_buckets_ = num_buckets_per_partition_ * num_partitions_;
+
+        partition_groups_.resize(
+            num_partitions_,
+            std::min(
+                (size_t(config_.initial_items_per_partition_) + group_size_ - 1)
+                / group_size_,
+                num_groups_per_partition_));
+
+        // calculate limit on the number of items in a partition before these
+        // are spilled to disk or flushed to network.
+
+        double limit_fill_rate = config_.limit_partition_fill_rate();
+
+        assert(limit_fill_rate >= 0.0 && limit_fill_rate <= 1.0
+               && "limit_partition_fill_rate must be between 0.0 and 1.0. "
+               "with a fill rate of 0.0, items are immediately flushed.");
+
+        limit_items_per_partition_ = (size_t)(
+            static_cast<double>(num_buckets_per_partition_) * limit_fill_rate);
+
+        // allocate the slots aligned to cache lines, they are constructed on
+        // insertion.
+
+        slots_memory_ = operator new (
+            num_buckets_ * sizeof(KeyValuePair) + cache_line_size_);
+        slots_ = reinterpret_cast<KeyValuePair*>(
+            (reinterpret_cast<uintptr_t>(slots_memory_) + cache_line_size_ - 1)
+            & ~uintptr_t(cache_line_size_ - 1));
+
+        ctrl_ = new uint8_t[num_buckets_];
+        std::memset(ctrl_, ctrl_empty_, num_buckets_);
+    }
+
+    ~ReduceSwissHashTable() {
+        if (slots_) Dispose();
+    }
+
+    /*!
+     * Inserts a value. Calls the key_extractor_, makes a key-value-pair and
+     * inserts the pair via the Insert() function.
+     */
+    void Insert(const Value& p) {
+        Insert(std::make_pair(key_extractor_(p), p));
+    }
+
+    /*!
+     * Inserts a value into the table, potentially reducing it in case both the
+     * key of the value already in the table and the key of the value to be
+     * inserted are the same.
+     *
+     * An insert may trigger a partial flush of the partition with the most
+     * items if the maximal number of items in the table (max_num_items_table)
+     * is reached, or if all groups of the partition are full.
+     *
+     * \param kv Value to be inserted into the table.
+     */
+    void Insert(const KeyValuePair& kv) {
+
+        while (mem::memory_exceeded && num_items_ != 0)
+            SpillAnyPartition();
+
+        typename IndexFunction::Result h = index_function_(
+            kv.first, num_partitions_,
+            num_buckets_per_partition_, num_buckets_);
+
+        assert(h.partition_id < num_partitions_);
+
+        // low seven bits are the tag, the remaining select the group
+        const uint8_t tag = static_cast<uint8_t>(h.remaining_hash & 0x7F);
+        const size_t num_groups = partition_groups_[h.partition_id];
+
+        const size_t pbegin = h.partition_id * num_buckets_per_partition_;
+        const size_t begin_group = (h.remaining_hash >> 7) % num_groups;
+        size_t group = begin_group;
+
+        do {
+            const size_t gbegin = pbegin + group * group_size_;
+
+            // compare keys of slots with matching tags
+            for (uint32_t match = MatchByte(ctrl_ + gbegin, tag);
+                 match != 0; match &= match - 1)
+            {
+                KeyValuePair& slot = slots_[gbegin + CountTrailingZeros(match)];
+                if (equal_to_function_(slot.first, kv.first))
+                {
+                    LOGC(debug_items)
+                        << "match of key: " << kv.first
+                        << " and " << slot.first << " ... reducing...";
+
+                    slot.second = reduce_function_(slot.second, kv.second);
+
+                    return;
+                }
+            }
+
+            // insert new pair into the first empty slot of the group
+            uint32_t empty = MatchByte(ctrl_ + gbegin, ctrl_empty_);
+            if (empty != 0) {
+                size_t index = gbegin + CountTrailingZeros(empty);
+                new (slots_ + index)KeyValuePair(kv);
+                ctrl_[index] = tag;
+
+                // increase counter for partition
+                ++items_per_partition_[h.partition_id];
+                ++num_items_;
+
+                while (items_per_partition_[h.partition_id]
+                       > limit_items_per_partition_)
+                    SpillPartition(h.partition_id);
+
+                // keep long probe sequences away by growing early
+                if (8 * items_per_partition_[h.partition_id]
+                    > 7 * num_groups * group_size_)
+                    RehashPartition(h.partition_id);
+
+                return;
+            }
+
+            // wrap around if beyond the current partition
+            if (++group == num_groups) group = 0;
+        } while (group != begin_group);
+
+        // flush partition and retry, if all slots are reserved
+        SpillPartition(h.partition_id);
+        return Insert(kv);
+    }
+
+    //! Deallocate items and memory
+    void Dispose() {
+        if (!slots_) return;
+
+        // dispose the items by destructor
+
+        for (size_t id = 0; id < num_partitions_; ++id) {
+            size_t begin = id * num_buckets_per_partition_;
+            size_t end = begin + partition_groups_[id] * group_size_;
+
+            for (size_t i = begin; i != end; ++i) {
+                if (ctrl_[i] != ctrl_empty_)
+                    slots_[i].~KeyValuePair();
+            }
+        }
+
+        operator delete (slots_memory_);
+        slots_memory_ = nullptr;
+        slots_ = nullptr;
+
+        delete[] ctrl_;
+        ctrl_ = nullptr;
+
+        Super::Dispose();
+    }
+
+    //! Grow a partition after a spill or flush (if possible). All control
+    //! bytes are already empty.
+    void GrowPartition(size_t partition_id) {
+
+        if (partition_groups_[partition_id] == num_groups_per_partition_)
+            return;
+
+        size_t new_groups = std::min(
+            num_groups_per_partition_, 2 * partition_groups_[partition_id]);
+
+        sLOG << "Growing partition" << partition_id
+             << "from" << partition_groups_[partition_id]
+             << "to" << new_groups << "groups";
+
+        partition_groups_[partition_id] = new_groups;
+    }
+
+    //! Grow a partition which is filled beyond 7/8 and move its items into
+    //! their new groups.
+    void RehashPartition(size_t partition_id) {
+
+        if (partition_groups_[partition_id] == num_groups_per_partition_)
+            return;
+
+        // move all items out of the partition
+        std::vector<KeyValuePair> items;
+        items.reserve(items_per_partition_[partition_id]);
+
+        size_t begin = partition_id * num_buckets_per_partition_;
+        size_t end = begin + partition_groups_[partition_id] * group_size_;
+
+        for (size_t i = begin; i != end; ++i) {
+            if (ctrl_[i] == ctrl_empty_) continue;
+            items.emplace_back(std::move(slots_[i]));
+            slots_[i].~KeyValuePair();
+            ctrl_[i] = ctrl_empty_;
+        }
+
+        GrowPartition(partition_id);
+
+        // insert them into the first empty slot of their probe sequence, the
+        // keys are all distinct.
+        const size_t num_groups = partition_groups_[partition_id];
+
+        for (KeyValuePair& kv : items) {
+            typename IndexFunction::Result h = index_function_(
+                kv.first, num_partitions_,
+                num_buckets_per_partition_, num_buckets_);
+            assert(h.partition_id == partition_id);
+
+            size_t group = (h.remaining_hash >> 7) % num_groups;
+            uint32_t empty;
+            while ((empty = MatchByte(
+                        ctrl_ + begin + group * group_size_, ctrl_empty_)) == 0) {
+                if (++group == num_groups) group = 0;
+            }
+
+            size_t index = begin + group * group_size_ + CountTrailingZeros(empty);
+            new (slots_ + index)KeyValuePair(std::move(kv));
+            ctrl_[index] = static_cast<uint8_t>(h.remaining_hash & 0x7F);
+        }
+    }
+
+    //! \name Spilling Mechanisms to External Memory Files
+    //! \{
+
+    //! Spill all items of a partition into an external memory File.
+    void SpillPartition(size_t partition_id) {
+
+        if (immediate_flush_)
+            return FlushPartition(partition_id, true);
+
+        LOG << "Spilling " << items_per_partition_[partition_id]
+            << " items of partition with id: " << partition_id;
+
+        if (items_per_partition_[partition_id] == 0)
+            return;
+
+        data::File::Writer writer = partition_files_[partition_id].GetWriter();
+
+        FlushPartitionEmit(
+            partition_id, /* consume */ true,
+            [&writer](const size_t& /* partition_id */, const KeyValuePair& p) {
+                writer.Put(p);
+            });
+
+        LOG << "Spilled items of partition with id: " << partition_id;
+    }
+
+    //! Spill all items of an arbitrary partition into an external memory File.
+    void SpillAnyPartition() {
+        return SpillLargestPartition();
+    }
+
+    //! Spill all items of the largest partition into an external memory File.
+    void SpillLargestPartition() {
+        // get partition with max size
+        size_t size_max = 0, index = 0;
+
+        for (size_t i = 0; i < num_partitions_; ++i)
+        {
+            if (items_per_partition_[i] > size_max)
+            {
+                size_max = items_per_partition_[i];
+                index = i;
+            }
+        }
+
+        if (size_max == 0) {
+            return;
+        }
+
+        return SpillPartition(index);
+    }
+
+    //! \}
+
+    //! \name Flushing Mechanisms to Next Stage
+    //! \{
+
+    template <typename Emit>
+    void FlushPartitionEmit(size_t partition_id, bool consume, Emit emit) {
+
+        LOG << "Flushing " << items_per_partition_[partition_id]
+            << " items of partition: " << partition_id;
+
+        size_t begin = partition_id * num_buckets_per_partition_;
+        size_t end = begin + partition_groups_[partition_id] * group_size_;
+
+        for (size_t i = begin; i != end; ++i)
+        {
+            if (ctrl_[i] == ctrl_empty_) continue;
+
+            emit(partition_id, slots_[i]);
+
+            if (consume) {
+                slots_[i].~KeyValuePair();
+                ctrl_[i] = ctrl_empty_;
+            }
+        }
+
+        if (consume) {
+            // reset partition specific counter
+            num_items_ -= items_per_partition_[partition_id];
+            items_per_partition_[partition_id] = 0;
+            assert(num_items_ == this->num_items_calc());
+        }
+
+        LOG << "Done flushed items of partition: " << partition_id;
+
+        GrowPartition(partition_id);
+    }
+
+    void FlushPartition(size_t partition_id, bool consume) {
+        FlushPartitionEmit(
+            partition_id, consume,
+            [this](const size_t& partition_id, const KeyValuePair& p) {
+                this->emitter_.Emit(partition_id, p);
+            });
+    }
+
+    void FlushAll() {
+        for (size_t i = 0; i < num_partitions_; ++i) {
+            FlushPartition(i, true);
+        }
+    }
+
+    //! \}
+
+private:
+    using Super::config_;
+    using Super::equal_to_function_;
+    using Super::immediate_flush_;
+    using Super::index_function_;
+    using Super::items_per_partition_;
+    using Super::key_extractor_;
+    using Super::limit_items_per_partition_;
+    using Super::limit_memory_bytes_;
+    using Super::num_buckets_;
+    using Super::num_buckets_per_partition_;
+    using Super::num_items_;
+    using Super::num_partitions_;
+    using Super::partition_files_;
+    using Super::reduce_function_;
+
+    static constexpr size_t cache_line_size_ = 64;
+
+    //! Allocated memory of the slots
+    void* slots_memory_ = nullptr;
+
+    //! Storing the key/value slots, aligned to a cache line
+    KeyValuePair* slots_ = nullptr;
+
+    //! Control byte of each slot: empty or seven bits of the hash
+    uint8_t* ctrl_ = nullptr;
+
+    //! Maximum number of groups in a partition
+    size_t num_groups_per_partition_;
+
+    //! Current number of groups of the partitions because the valid areas grow
+    std::vector<size_t> partition_groups_;
+
+    //! Returns a bit mask of the bytes in the 16 byte group equal to byte.
+    static uint32_t MatchByte(const uint8_t* group, uint8_t byte) {
+#if defined(__SSE2__)
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(
+                                         _mm_cmpeq_epi8(
+                                             ctrl, _mm_set1_epi8(
+                                                 static_cast<char>(byte)))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_size_; ++i)
+            mask |= uint32_t(group[i] == byte) << i;
+        return mask;
+#endif
+    }
+
+    //! Returns the index of the lowest set bit of a nonzero mask.
+    static size_t CountTrailingZeros(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_t>(__builtin_ctz(mask));
+#else
+        size_t i = 0;
+        while (!(mask & 1)) mask >>= 1, ++i;
+        return i;
+#endif
+    }
+};
+
+template <typename ValueType, typename Key, typename Value,
+          typename KeyExtractor, typename ReduceFunction,
+          typename Emitter, const bool VolatileKey,
+          typename ReduceConfig, typename IndexFunction,
+          typename EqualToFunction>
+class ReduceTableSelect<
+        ReduceTableImpl::SWISS,
+        ValueType, Key, Value, KeyExtractor, ReduceFunction,
+        Emitter, VolatileKey, ReduceConfig, IndexFunction, EqualToFunction>
+{
+public:
+    using type = ReduceSwissHashTable<
+              ValueType, Key, Value, KeyExtractor, ReduceFunction,
+              Emitter, VolatileKey, ReduceConfig,
+              IndexFunction, EqualToFunction>;
+};
+
+} // namespace core
+} // namespace thrill
+
+#endif // !THRILL_CORE_REDUCE_SWISS_HASH_TABLE_HEADER
+
+/******************************************************************************/
@@ -27,7 +27,7 @@ namespace core {
 
 //! Enum class to select a hash table implementation.
 enum class ReduceTableImpl {
-    PROBING, OLD_PROBING, BUCKET
+    PROBING, OLD_PROBING, BUCKET, SWISS
 };
 
 /*!
@@ -64,6 +64,64 @@ public:
     //! the pre and post stages simultaneously.
     static constexpr bool use_post_thread_ = true;
 
+    //! detect frequent keys in the ReducePreStage by sampling and reduce them
+    //! in a separate small table, which is only flushed at the end. Hence,
+    //! each worker transmits one item per hot key. Hot keys are emitted before
+    //! the remaining items, hence not in index order for ReduceToIndex.
+    static constexpr bool use_hot_key_detection_ = false;
+
+    //! only for hot key detection: sample on average every n-th inserted item.
+    static constexpr size_t hot_key_sample_interval_ = 16;
+
+    //! only for hot key detection: maximum number of hot keys and of counters
+    //! in the frequency sketch. A key is hot if it accounts for at least
+    //! 4/hot_key_capacity_ of the sampled items.
+    static constexpr size_t hot_key_capacity_ = 64;
+
+    //! measure the reduction ratio of the ReducePreStage at run time, and send
+    //! items directly to the network bypassing the hash table while it
+    //! reduces too few items.
+    static constexpr bool use_adaptive_bypass_ = false;
+
+    //! only for adaptive bypass: number of inserted items over which the
+    //! reduction ratio is measured.
+    static constexpr size_t bypass_window_ = 4096;
+
+    //! only for adaptive bypass: the hash table is bypassed if less than this
+    //! fraction of the items in a window were reduced.
+    static constexpr double bypass_min_reduction_ = 0.1;
+
+    //! only for adaptive bypass: number of bypassed windows after which the
+    //! reduction ratio is measured again with the hash table.
+    static constexpr size_t bypass_probe_interval_ = 16;
+
+    //! switch the post stage of ReduceNode from hashing to sorting if the
+    //! sampled key cardinality shows that the hash table would spill most
+    //! items. Requires operator < on the key.
+    static constexpr bool use_sort_fallback_ = false;
+
+    //! only for sort fallback: number of items inserted into the post stage
+    //! between two evaluations of the cost model.
+    static constexpr size_t sort_fallback_sample_ = 4096;
+
+    //! only for sort fallback: the cost model decides once the hash table
+    //! holds this fraction of the items it can hold before spilling.
+    static constexpr double sort_fallback_min_fill_ = 0.5;
+
+    //! only for sort fallback: sort if at least this fraction of the items
+    //! inserted so far had distinct keys.
+    static constexpr double sort_fallback_min_distinct_ = 0.5;
+
+    //! only for sort-based post stage: a sorted and reduced buffer is written
+    //! as a run if it still holds this fraction of its capacity.
+    static constexpr double sort_run_fill_rate_ = 0.5;
+
+    //! maximum level of recursively re-reducing spilled partitions in the
+    //! ReduceByHashPostStage. Distinct keys with equal hash values land in the
+    //! same partition on every level, hence partitions spilled beyond this
+    //! level are reduced by sorting, which requires operator < on the key.
+    static constexpr size_t max_spill_levels_ = 8;
+
     //! \name Accessors
     //! \{
 
@@ -134,6 +192,9 @@ public:
         if (!immediate_flush_) {
             for (size_t i = 0; i < num_partitions_; i++) {
                 partition_files_.push_back(ctx.GetFile(dia_id_));
+                // spilled items are read once when re-reducing the partition
+                partition_files_.back().set_eviction_hint(
+                    data::EvictionHint::ConsumeOnce);
             }
         }
     }
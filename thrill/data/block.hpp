@@ -19,6 +19,7 @@
 #include <thrill/mem/pool.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <ostream>
 #include <string>
 
@@ -353,6 +354,8 @@ private:
     PinnedBlock block_;
     //! running read request
     io::RequestPtr req_;
+    //! time when the read request was issued, to measure read latency
+    std::chrono::steady_clock::time_point read_start_;
 
     //! indication that the PinnedBlocks ready
     std::atomic<bool> ready_;
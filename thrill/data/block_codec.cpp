@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * thrill/data/block_codec.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/block_codec.hpp>
+
+#include <thrill/common/die.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace thrill {
+namespace data {
+
+/******************************************************************************/
+// LZ4 block format: a sequence consists of a token byte holding the literal
+// length and the match length in four bits each, extension bytes of the
+// literal length, the literals, a 16-bit little-endian match offset, and
+// extension bytes of the match length. The last sequence has no match.
+
+//! minimum length of a match
+static constexpr size_t lz4_min_match = 4;
+
+//! the last match must start at least this many bytes before the end
+static constexpr size_t lz4_mf_limit = 12;
+
+//! the last bytes of the input are always literals
+static constexpr size_t lz4_last_literals = 5;
+
+//! maximum offset of a match
+static constexpr size_t lz4_max_offset = 65535;
+
+//! log2 of the number of entries in the compressor's hash table
+static constexpr size_t lz4_hash_log = 12;
+
+static inline uint32_t LZ4Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t LZ4Hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - lz4_hash_log);
+}
+
+//! write the extension bytes of a length field which was saturated at 15.
+static inline uint8_t * LZ4WriteLength(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+//! read the extension bytes of a length field which was saturated at 15.
+static inline size_t LZ4ReadLength(const uint8_t*& ip, const uint8_t* iend) {
+    size_t len = 0;
+    uint8_t b;
+    do {
+        die_unless(ip < iend && "corrupt compressed block");
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return len;
+}
+
+//! write a sequence of literals [anchor, anchor + lit) and a match, if mlen is
+//! not zero. returns nullptr if the sequence does not fit.
+static inline uint8_t * LZ4WriteSequence(
+    uint8_t* op, uint8_t* oend, const uint8_t* anchor, size_t lit,
+    size_t offset, size_t mlen) {
+
+    // worst-case size of the sequence
+    size_t max_size = 1 + lit / 255 + 1 + lit;
+    if (mlen) max_size += 2 + mlen / 255 + 1;
+    if (static_cast<size_t>(oend - op) < max_size) return nullptr;
+
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>(std::min<size_t>(lit, 15) << 4);
+    if (lit >= 15) op = LZ4WriteLength(op, lit - 15);
+
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    if (!mlen) return op;
+
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+
+    mlen -= lz4_min_match;
+    *token |= static_cast<uint8_t>(std::min<size_t>(mlen, 15));
+    if (mlen >= 15) op = LZ4WriteLength(op, mlen - 15);
+
+    return op;
+}
+
+static size_t LZ4Compress(const uint8_t* src, size_t size,
+                          uint8_t* dst, size_t dst_capacity) {
+    assert(size < (size_t(1) << 32));
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const iend = src + size;
+
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_capacity;
+
+    if (size > lz4_mf_limit)
+    {
+        const uint8_t* const mflimit = iend - lz4_mf_limit;
+        const uint8_t* const matchlimit = iend - lz4_last_literals;
+
+        // positions of the last occurrence of each hashed four byte sequence,
+        // the zero-initialized entries point to the beginning of the input.
+        uint32_t table[size_t(1) << lz4_hash_log] = { 0 };
+
+        while (ip < mflimit)
+        {
+            uint32_t seq = LZ4Read32(ip);
+            uint32_t h = LZ4Hash(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+
+            if (ref >= ip || static_cast<size_t>(ip - ref) > lz4_max_offset ||
+                LZ4Read32(ref) != seq) {
+                // skip faster over incompressible data
+                ip += 1 + (static_cast<size_t>(ip - anchor) >> 6);
+                continue;
+            }
+
+            // extend the match backwards and forwards
+            while (ip > anchor && ref > src && ip[-1] == ref[-1])
+                --ip, --ref;
+
+            const uint8_t* mp = ip + lz4_min_match;
+            const uint8_t* rp = ref + lz4_min_match;
+            while (mp < matchlimit && *mp == *rp)
+                ++mp, ++rp;
+
+            op = LZ4WriteSequence(
+                op, oend, anchor, static_cast<size_t>(ip - anchor),
+                static_cast<size_t>(ip - ref), static_cast<size_t>(mp - ip));
+            if (!op) return 0;
+
+            ip = anchor = mp;
+        }
+    }
+
+    // last literals
+    op = LZ4WriteSequence(
+        op, oend, anchor, static_cast<size_t>(iend - anchor), 0, 0);
+    if (!op) return 0;
+
+    return static_cast<size_t>(op - dst);
+}
+
+static size_t LZ4Decompress(const uint8_t* src, size_t size,
+                            uint8_t* dst, size_t dst_capacity) {
+
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + size;
+
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + dst_capacity;
+
+    while (ip < iend)
+    {
+        const uint8_t token = *ip++;
+
+        size_t lit = token >> 4;
+        if (lit == 15) lit += LZ4ReadLength(ip, iend);
+
+        die_unless(lit <= static_cast<size_t>(iend - ip) &&
+                   lit <= static_cast<size_t>(oend - op) &&
+                   "corrupt compressed block");
+
+        memcpy(op, ip, lit);
+        op += lit, ip += lit;
+
+        // the last sequence has no match
+        if (ip == iend) break;
+
+        die_unless(iend - ip >= 2 && "corrupt compressed block");
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+
+        die_unless(offset != 0 && offset <= static_cast<size_t>(op - dst) &&
+                   "corrupt compressed block");
+
+        size_t mlen = token & 15;
+        if (mlen == 15) mlen += LZ4ReadLength(ip, iend);
+        mlen += lz4_min_match;
+
+        die_unless(mlen <= static_cast<size_t>(oend - op) &&
+                   "corrupt compressed block");
+
+        // matches may overlap their own output
+        const uint8_t* match = op - offset;
+        if (offset >= mlen) {
+            memcpy(op, match, mlen);
+        }
+        else {
+            for (size_t i = 0; i < mlen; ++i)
+                op[i] = match[i];
+        }
+        op += mlen;
+    }
+
+    return static_cast<size_t>(op - dst);
+}
+
+/******************************************************************************/
+
+size_t BlockCompress(BlockCodec codec, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t dst_capacity) {
+    switch (codec) {
+    case BlockCodec::None:
+        if (size > dst_capacity) return 0;
+        memcpy(dst, src, size);
+        return size;
+    case BlockCodec::LZ4:
+        return LZ4Compress(src, size, dst, dst_capacity);
+    }
+    die("Invalid BlockCodec " << static_cast<unsigned>(codec));
+}
+
+size_t BlockDecompress(BlockCodec codec, const uint8_t* src, size_t size,
+                       uint8_t* dst, size_t dst_capacity) {
+    switch (codec) {
+    case BlockCodec::None:
+        die_unless(size <= dst_capacity && "corrupt block");
+        memcpy(dst, src, size);
+        return size;
+    case BlockCodec::LZ4:
+        return LZ4Decompress(src, size, dst, dst_capacity);
+    }
+    die("Invalid BlockCodec " << static_cast<unsigned>(codec));
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
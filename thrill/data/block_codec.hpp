@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * thrill/data/block_codec.hpp
+ *
+ * Fast in-process compression of ByteBlocks for eviction and transmission.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_BLOCK_CODEC_HEADER
+#define THRILL_DATA_BLOCK_CODEC_HEADER
+
+#include <cstddef>
+#include <cstdint>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+//! Codec applied to the bytes of a Block when evicted to disk or sent over
+//! the network.
+enum class BlockCodec : uint8_t {
+    //! raw bytes
+    None = 0,
+    //! LZ77 with byte-aligned sequences in the LZ4 block format: fast but
+    //! weak compression, intended for serialized items.
+    LZ4 = 1
+};
+
+/*!
+ * Compress size bytes at src into at most dst_capacity bytes at dst using the
+ * given codec. Returns the compressed size, or zero if the compressed data
+ * does not fit into dst_capacity bytes, in which case the raw data should be
+ * used.
+ */
+size_t BlockCompress(BlockCodec codec, const uint8_t* src, size_t size,
+                     uint8_t* dst, size_t dst_capacity);
+
+/*!
+ * Decompress size bytes at src into at most dst_capacity bytes at dst using the
+ * given codec. Returns the decompressed size, and dies if the compressed data
+ * is corrupt.
+ */
+size_t BlockDecompress(BlockCodec codec, const uint8_t* src, size_t size,
+                       uint8_t* dst, size_t dst_capacity);
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_BLOCK_CODEC_HEADER
+
+/******************************************************************************/
@@ -10,18 +10,21 @@
 
 #include <thrill/common/die.hpp>
 #include <thrill/common/logger.hpp>
-#include <thrill/common/lru_cache.hpp>
 #include <thrill/common/math.hpp>
+#include <thrill/common/numa.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/block_pool.hpp>
+#include <thrill/data/eviction_policy.hpp>
 #include <thrill/io/file_base.hpp>
 #include <thrill/io/iostats.hpp>
 #include <thrill/mem/aligned_allocator.hpp>
 #include <thrill/mem/pool.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -75,7 +78,7 @@ static void OurNewHandler() {
     if (!req) {
         // if no writing active, evict a block
         for (size_t i = 0; i < s_blockpools.size(); ++i) {
-            req = s_blockpools[s_iter]->EvictBlockLRU();
+            req = s_blockpools[s_iter]->EvictNextBlock();
             ++s_iter %= s_blockpools.size();
             if (req) break;
         }
@@ -241,9 +244,11 @@ public:
     //! is reached. 0 for no limit.
     size_t hard_ram_limit_;
 
-    //! list of all blocks that are _in_memory_ but are _not_ pinned.
-    common::LruCacheSet<
-        ByteBlock*, mem::GPoolAllocator<ByteBlock*> > unpinned_blocks_;
+    //! set of all blocks that are _in_memory_ but are _not_ pinned, ordered
+    //! by the eviction policy.
+    std::unique_ptr<EvictionPolicy> unpinned_blocks_ {
+        std::make_unique<CostAwareEvictionPolicy>()
+    };
 
     //! set of ByteBlocks currently begin written to EM.
     WritingMap writing_;
@@ -251,6 +256,15 @@ public:
     //! set of ByteBlocks currently begin read from EM.
     ReadingMap reading_;
 
+    //! set of ByteBlocks currently being compressed outside the lock before
+    //! they are written to EM.
+    std::unordered_set<
+        ByteBlock*, std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
+        mem::GPoolAllocator<ByteBlock*> > compressing_;
+
+    //! For waiting on ByteBlocks in compressing_
+    std::condition_variable cv_compress_complete_;
+
     //! set of ByteBlock currently in EM.
     std::unordered_set<
         ByteBlock*, std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
@@ -290,6 +304,20 @@ public:
     //! number of bytes currently being read from to EM.
     Counter reading_bytes_;
 
+    //! moving average of the latency of reads from EM in seconds, zero if no
+    //! Block was read yet.
+    double read_latency_ = 0;
+
+    //! NUMA node of each local worker
+    std::vector<size_t> worker_node_;
+
+    //! free lists per NUMA node of buffers of destroyed ByteBlocks and their
+    //! sizes, which are still counted in total_ram_bytes_.
+    std::vector<std::vector<std::pair<Byte*, size_t> > > free_data_;
+
+    //! total number of bytes in free_data_
+    Counter free_bytes_;
+
     //! total number of ByteBlocks allocated
     size_t total_byte_blocks_ = 0;
 
@@ -318,12 +346,36 @@ public:
           hard_ram_limit_(hard_ram_limit),
           bm_(io::BlockManager::GetInstance()),
           aligned_alloc_(mem::Allocator<char>(block_pool.mem_manager_)),
-          pin_count_(workers_per_host) { }
+          pin_count_(workers_per_host),
+          worker_node_(workers_per_host, 0),
+          free_data_(common::NumaTopology::Get().num_nodes()) { }
+
+    //! maximum number of buffers in the free list of each NUMA node
+    static constexpr size_t max_free_data_per_node = 16;
+
+    //! Take a buffer of given size from the free list of the NUMA node, its
+    //! memory is already counted. Returns nullptr if there is none.
+    Byte * IntTakeFreeData(size_t size, size_t node);
+
+    //! Allocate a buffer preferably on the NUMA node. Called without lock.
+    Byte * AllocateData(size_t size, size_t node);
+
+    //! Keep the buffer of a destroyed ByteBlock in the free list of its NUMA
+    //! node for reuse, or deallocate it and release its memory.
+    void IntReleaseData(Byte* data, size_t size, size_t node);
+
+    //! Deallocate all buffers in the free lists and release their memory.
+    void IntDropFreeData();
 
     //! Updates the memory manager for internal memory. If the hard limit is
     //! reached, the call is blocked intil memory is free'd
     void IntRequestInternalMemory(std::unique_lock<std::mutex>& lock, size_t size);
 
+    //! Updates the memory manager for a temporary buffer, if this does not
+    //! exceed the hard limit. Never blocks or evicts blocks, returns false if
+    //! the memory is not available.
+    bool IntTryRequestInternalMemory(size_t size);
+
     //! Updates the memory manager for the internal memory, wakes up waiting
     //! BlockPool::RequestInternalMemory calls
     void IntReleaseInternalMemory(size_t size);
@@ -333,12 +385,13 @@ public:
     void IntUnpinBlock(
         BlockPool& bp, ByteBlock* block_ptr, size_t local_worker_id);
 
-    //! Evict a block from the lru list into external memory
-    io::RequestPtr IntEvictBlockLRU();
+    //! Evict the block selected by the eviction policy into external memory
+    io::RequestPtr IntEvictNextBlock(std::unique_lock<std::mutex>& lock);
 
     //! Evict a block into external memory. The block must be unpinned and not
-    //! swapped.
-    io::RequestPtr IntEvictBlock(ByteBlock* block_ptr);
+    //! swapped. Releases the lock while compressing the block.
+    io::RequestPtr IntEvictBlock(
+        std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr);
 
     //! \name Block Statistics
     //! \{
@@ -389,6 +442,10 @@ BlockPool::BlockPool(size_t soft_ram_limit, size_t hard_ram_limit,
 BlockPool::~BlockPool() {
     std::unique_lock<std::mutex> lock(mutex_);
 
+    // wait for blocks being compressed, they are then found in writing_.
+    d_->cv_compress_complete_.wait(
+        lock, [this]() { return d_->compressing_.empty(); });
+
     // check that not writing any block.
     while (d_->writing_.begin() != d_->writing_.end()) {
 
@@ -446,9 +503,10 @@ BlockPool::~BlockPool() {
         lock, [this]() { return d_->total_byte_blocks_ == 0; });
 
     d_->pin_count_.AssertZero();
+    d_->IntDropFreeData();
     die_unequal(d_->total_ram_bytes_, 0u);
     die_unequal(d_->total_bytes_, 0u);
-    die_unequal(d_->unpinned_blocks_.size(), 0u);
+    die_unequal(d_->unpinned_blocks_->size(), 0u);
 
     LOGC(debug_pin)
         << "~BlockPool()"
@@ -469,6 +527,22 @@ PinnedByteBlockPtr
 BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
     assert(local_worker_id < workers_per_host_);
     std::unique_lock<std::mutex> lock(mutex_);
+    return IntAllocateByteBlock(
+        lock, size, local_worker_id, d_->worker_node_[local_worker_id]);
+}
+
+PinnedByteBlockPtr
+BlockPool::AllocateByteBlock(
+    size_t size, size_t local_worker_id, size_t numa_node) {
+    assert(local_worker_id < workers_per_host_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    return IntAllocateByteBlock(lock, size, local_worker_id, numa_node);
+}
+
+PinnedByteBlockPtr
+BlockPool::IntAllocateByteBlock(
+    std::unique_lock<std::mutex>& lock,
+    size_t size, size_t local_worker_id, size_t numa_node) {
 
     if (!(size % THRILL_DEFAULT_ALIGN == 0 && common::IsPowerOfTwo(size))
         // make exception to block_size constraint for test programs, which use
@@ -478,17 +552,22 @@ BlockPool::AllocateByteBlock(size_t size, size_t local_worker_id) {
             "ByteBlocks must be >= " << THRILL_DEFAULT_ALIGN << " and a power of two.");
     }
 
-    d_->IntRequestInternalMemory(lock, size);
+    // reuse a buffer on the NUMA node, else request and allocate memory.
+    Byte* data = d_->IntTakeFreeData(size, numa_node);
+    if (!data) {
+        d_->IntRequestInternalMemory(lock, size);
 
-    // allocate block memory. -- unlock mutex for that time, since it may
-    // require block eviction.
-    lock.unlock();
-    Byte* data = d_->aligned_alloc_.allocate(size);
-    lock.lock();
+        // allocate block memory. -- unlock mutex for that time, since it may
+        // require block eviction.
+        lock.unlock();
+        data = d_->AllocateData(size, numa_node);
+        lock.lock();
+    }
 
     // create common::CountingPtr, no need for special make_shared()-equivalent
     PinnedByteBlockPtr block_ptr(
         mem::GPool().make<ByteBlock>(this, data, size), local_worker_id);
+    block_ptr->numa_node_ = numa_node;
     ++d_->total_byte_blocks_;
     d_->total_bytes_ += size;
     d_->max_total_bytes_ = std::max(d_->max_total_bytes_, d_->total_bytes_.value);
@@ -539,7 +618,7 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
         // PinnedBlock become Blocks when transfered between Files or delivered
         // via GetItemRange() or Scatter().
 
-        die_unless(!d_->unpinned_blocks_.exists(block_ptr));
+        die_unless(!d_->unpinned_blocks_->Exists(block_ptr));
         die_unless(d_->reading_.find(block_ptr) == d_->reading_.end());
 
         LOGC(debug_pin)
@@ -556,7 +635,7 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
         // This block was already pinned by another thread, hence we only need
         // to get a pin for the new thread.
 
-        die_unless(!d_->unpinned_blocks_.exists(block_ptr));
+        die_unless(!d_->unpinned_blocks_->Exists(block_ptr));
         die_unless(d_->reading_.find(block_ptr) == d_->reading_.end());
 
         LOGC(debug_pin)
@@ -571,6 +650,10 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
                                  this, PinnedBlock(block, local_worker_id)));
     }
 
+    // wait until the block is compressed and its write was issued.
+    while (d_->compressing_.count(block_ptr))
+        d_->cv_compress_complete_.wait(lock);
+
     // check that not writing the block.
     WritingMap::iterator write_it;
     while ((write_it = d_->writing_.find(block_ptr)) != d_->writing_.end()) {
@@ -619,8 +702,8 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
         // unpinned block in memory, no need to load from EM.
 
         // remove from unpinned list
-        die_unless(d_->unpinned_blocks_.exists(block_ptr));
-        d_->unpinned_blocks_.erase(block_ptr);
+        die_unless(d_->unpinned_blocks_->Exists(block_ptr));
+        d_->unpinned_blocks_->Erase(block_ptr);
         d_->unpinned_bytes_ -= block_ptr->size();
 
         IntIncBlockPinCount(block_ptr, local_worker_id);
@@ -639,9 +722,12 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
 
     die_unless(block_ptr->em_bid_.storage);
 
-    // maybe blocking call until memory is available, this also swaps out other
-    // blocks.
-    d_->IntRequestInternalMemory(lock, block_ptr->size());
+    // reuse a buffer on the worker's NUMA node, else maybe blocking call until
+    // memory is available, this also swaps out other blocks.
+    size_t numa_node = d_->worker_node_[local_worker_id];
+    Byte* data = d_->IntTakeFreeData(block_ptr->size(), numa_node);
+    if (!data)
+        d_->IntRequestInternalMemory(lock, block_ptr->size());
 
     // the requested memory is already counted as a pin.
     d_->pin_count_.Increment(local_worker_id, block_ptr->size());
@@ -653,10 +739,16 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
             this, PinnedBlock(block, local_worker_id), /* ready */ false));
     d_->reading_[block_ptr] = read;
 
-    // allocate block memory.
+    // allocate block memory, and a buffer for compressed data.
     lock.unlock();
-    Byte* data = read->byte_block()->data_ =
-                     d_->aligned_alloc_.allocate(block_ptr->size());
+    if (!data)
+        data = d_->AllocateData(block_ptr->size(), numa_node);
+    read->byte_block()->data_ = data;
+    block_ptr->numa_node_ = numa_node;
+    if (block_ptr->em_compressed_size_) {
+        data = block_ptr->em_buffer_ =
+                   d_->aligned_alloc_.allocate(block_ptr->size());
+    }
     lock.lock();
 
     if (!block_ptr->ext_file_) {
@@ -670,10 +762,11 @@ PinRequestPtr BlockPool::PinBlock(const Block& block, size_t local_worker_id) {
         << d_->pin_count_;
 
     // issue I/O request, hold the reference to the request in the hashmap
+    read->read_start_ = std::chrono::steady_clock::now();
     read->req_ =
         block_ptr->em_bid_.storage->aread(
             // parameters for the read
-            data, block_ptr->em_bid_.offset, block_ptr->size(),
+            data, block_ptr->em_bid_.offset, block_ptr->em_bid_.size,
             // construct an immediate CompletionHandler callback
             io::CompletionHandler::make<
                 PinRequest, & PinRequest::OnComplete>(*read));
@@ -689,11 +782,26 @@ void PinRequest::OnComplete(io::Request* req, bool success) {
 
 void BlockPool::OnReadComplete(
     PinRequest* read, io::Request* req, bool success) {
-    std::unique_lock<std::mutex> lock(mutex_);
 
     ByteBlock* block_ptr = read->block_.byte_block().get();
     size_t block_size = block_ptr->size();
 
+    if (block_ptr->em_compressed_size_) {
+        // decompress outside the lock, the block is reserved by reading_.
+        if (success) {
+            die_unequal(
+                BlockDecompress(
+                    block_ptr->codec(), block_ptr->em_buffer_,
+                    block_ptr->em_compressed_size_,
+                    block_ptr->data_, block_size),
+                block_size);
+        }
+        d_->aligned_alloc_.deallocate(block_ptr->em_buffer_, block_size);
+        block_ptr->em_buffer_ = nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
     LOGC(debug_em)
         << "OnReadComplete():"
         << " req " << req << " block " << block_ptr
@@ -712,9 +820,8 @@ void BlockPool::OnReadComplete(
         }
 
         // release memory
-        d_->aligned_alloc_.deallocate(read->byte_block()->data_, block_size);
-
-        d_->IntReleaseInternalMemory(block_size);
+        d_->IntReleaseData(
+            read->byte_block()->data_, block_size, block_ptr->numa_node_);
 
         // the requested memory was already counted as a pin.
         d_->pin_count_.Decrement(read->block_.local_worker_id_, block_size);
@@ -724,12 +831,20 @@ void BlockPool::OnReadComplete(
     }
     else    // success
     {
+        // update moving average of read latency, which includes queueing in
+        // the I/O layer and decompression.
+        double latency = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - read->read_start_).count();
+        d_->read_latency_ = d_->read_latency_ == 0 ? latency
+                            : 0.875 * d_->read_latency_ + 0.125 * latency;
+
         // set pin on ByteBlock
         IntIncBlockPinCount(block_ptr, read->block_.local_worker_id_);
 
         if (!block_ptr->ext_file_) {
             d_->bm_->delete_block(block_ptr->em_bid_);
             block_ptr->em_bid_ = io::BID<0>();
+            block_ptr->em_compressed_size_ = 0;
         }
     }
 
@@ -809,8 +924,8 @@ void BlockPool::Data::IntUnpinBlock(
     }
 
     // if all per-thread pins are zero, allow this Block to be swapped out.
-    die_unless(!unpinned_blocks_.exists(block_ptr));
-    unpinned_blocks_.put(block_ptr);
+    die_unless(!unpinned_blocks_->Exists(block_ptr));
+    unpinned_blocks_->Put(block_ptr);
     unpinned_bytes_ += block_ptr->size();
 
     LOGC(debug_pin)
@@ -829,13 +944,13 @@ size_t BlockPool::Data::int_total_blocks() noexcept {
 
     LOG << "BlockPool::total_blocks()"
         << " pinned_blocks_=" << pin_count_.total_pins_
-        << " unpinned_blocks_=" << unpinned_blocks_.size()
+        << " unpinned_blocks_=" << unpinned_blocks_->size()
         << " writing_.size()=" << writing_.size()
         << " swapped_.size()=" << swapped_.size()
         << " reading_.size()=" << reading_.size();
 
     return pin_count_.total_pins_
-           + unpinned_blocks_.size() + writing_.size()
+           + unpinned_blocks_->size() + writing_.size()
            + swapped_.size() + reading_.size();
 }
 
@@ -869,7 +984,7 @@ size_t BlockPool::pinned_blocks() noexcept {
 
 size_t BlockPool::unpinned_blocks() noexcept {
     std::unique_lock<std::mutex> lock(mutex_);
-    return d_->unpinned_blocks_.size();
+    return d_->unpinned_blocks_->size();
 }
 
 size_t BlockPool::writing_blocks() noexcept {
@@ -899,6 +1014,10 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
     // pinned blocks cannot be destroyed since they are always unpinned first
     die_unless(block_ptr->total_pins_ == 0);
 
+    // wait until the block is compressed and its write was issued.
+    while (d_->compressing_.count(block_ptr))
+        d_->cv_compress_complete_.wait(lock);
+
     do {
         if (block_ptr->in_memory())
         {
@@ -953,15 +1072,14 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
             << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
             << " external block, in memory: release memory.";
 
-        die_unless(d_->unpinned_blocks_.exists(block_ptr));
-        d_->unpinned_blocks_.erase(block_ptr);
+        die_unless(d_->unpinned_blocks_->Exists(block_ptr));
+        d_->unpinned_blocks_->Erase(block_ptr);
         d_->unpinned_bytes_ -= block_ptr->size();
 
         // release memory
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->IntReleaseData(
+            block_ptr->data_, block_ptr->size(), block_ptr->numa_node_);
         block_ptr->data_ = nullptr;
-
-        d_->IntReleaseInternalMemory(block_ptr->size());
     }
     else if (block_ptr->ext_file_)
     {
@@ -976,15 +1094,14 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
             << "BlockPool::DestroyBlock() block_ptr=" << block_ptr
             << " unpinned block in memory, remove from list";
 
-        die_unless(d_->unpinned_blocks_.exists(block_ptr));
-        d_->unpinned_blocks_.erase(block_ptr);
+        die_unless(d_->unpinned_blocks_->Exists(block_ptr));
+        d_->unpinned_blocks_->Erase(block_ptr);
         d_->unpinned_bytes_ -= block_ptr->size();
 
         // release memory
-        d_->aligned_alloc_.deallocate(block_ptr->data_, block_ptr->size());
+        d_->IntReleaseData(
+            block_ptr->data_, block_ptr->size(), block_ptr->numa_node_);
         block_ptr->data_ = nullptr;
-
-        d_->IntReleaseInternalMemory(block_ptr->size());
     }
     else
     {
@@ -1000,6 +1117,7 @@ void BlockPool::DestroyBlock(ByteBlock* block_ptr) {
 
         d_->bm_->delete_block(block_ptr->em_bid_);
         block_ptr->em_bid_ = io::BID<0>();
+        block_ptr->em_compressed_size_ = 0;
     }
 
     assert(d_->total_byte_blocks_ > 0);
@@ -1019,6 +1137,15 @@ void BlockPool::Data::IntRequestInternalMemory(
 
     requested_bytes_ += size;
 
+    // free lists are dropped before evicting any blocks
+    if (free_bytes_ != 0 &&
+        ((soft_ram_limit_ != 0 &&
+          total_ram_bytes_ + requested_bytes_ > soft_ram_limit_) ||
+         (hard_ram_limit_ != 0 &&
+          total_ram_bytes_ + requested_bytes_ > hard_ram_limit_))) {
+        IntDropFreeData();
+    }
+
     LOGC(debug_mem)
         << "BlockPool::RequestInternalMemory()"
         << " size=" << size
@@ -1028,15 +1155,15 @@ void BlockPool::Data::IntRequestInternalMemory(
         << " soft_ram_limit_=" << soft_ram_limit_
         << " hard_ram_limit_=" << hard_ram_limit_
         << pin_count_
-        << " unpinned_blocks_.size()=" << unpinned_blocks_.size()
+        << " unpinned_blocks_->size()=" << unpinned_blocks_->size()
         << " swapped_.size()=" << swapped_.size();
 
     while (soft_ram_limit_ != 0 &&
-           unpinned_blocks_.size() &&
+           unpinned_blocks_->size() &&
            total_ram_bytes_ + requested_bytes_ > soft_ram_limit_ + writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        IntEvictBlockLRU();
+        IntEvictNextBlock(lock);
     }
 
     // wait up to 60 seconds for other threads to free up memory or pins
@@ -1048,11 +1175,11 @@ void BlockPool::Data::IntRequestInternalMemory(
     while (hard_ram_limit_ != 0 && total_ram_bytes_ + size > hard_ram_limit_)
     {
         while (hard_ram_limit_ != 0 &&
-               unpinned_blocks_.size() &&
+               unpinned_blocks_->size() &&
                total_ram_bytes_ + requested_bytes_ > hard_ram_limit_ + writing_bytes_)
         {
             // evict blocks: schedule async writing which increases writing_bytes_.
-            IntEvictBlockLRU();
+            IntEvictNextBlock(lock);
         }
 
         cv_memory_change_.wait_for(lock, std::chrono::seconds(1));
@@ -1065,7 +1192,7 @@ void BlockPool::Data::IntRequestInternalMemory(
             << " soft_ram_limit_=" << soft_ram_limit_
             << " hard_ram_limit_=" << hard_ram_limit_
             << pin_count_
-            << " unpinned_blocks_.size()=" << unpinned_blocks_.size()
+            << " unpinned_blocks_->size()=" << unpinned_blocks_->size()
             << " swapped_.size()=" << swapped_.size();
 
         if (writing_bytes_ == 0 &&
@@ -1078,7 +1205,7 @@ void BlockPool::Data::IntRequestInternalMemory(
                  << " soft_ram_limit_=" << soft_ram_limit_
                  << " hard_ram_limit_=" << hard_ram_limit_
                  << pin_count_
-                 << " unpinned_blocks_.size()=" << unpinned_blocks_.size()
+                 << " unpinned_blocks_->size()=" << unpinned_blocks_->size()
                  << " swapped_.size()=" << swapped_.size();
 
             if (writing_bytes_ == last_writing_bytes) {
@@ -1108,14 +1235,14 @@ void BlockPool::AdviseFree(size_t size) {
         << " soft_ram_limit_=" << d_->soft_ram_limit_
         << " hard_ram_limit_=" << d_->hard_ram_limit_
         << d_->pin_count_
-        << " unpinned_blocks_.size()=" << d_->unpinned_blocks_.size()
+        << " unpinned_blocks_->size()=" << d_->unpinned_blocks_->size()
         << " swapped_.size()=" << d_->swapped_.size();
 
-    while (d_->soft_ram_limit_ != 0 && d_->unpinned_blocks_.size() &&
+    while (d_->soft_ram_limit_ != 0 && d_->unpinned_blocks_->size() &&
            d_->total_ram_bytes_ + d_->requested_bytes_ + size > d_->hard_ram_limit_ + d_->writing_bytes_)
     {
         // evict blocks: schedule async writing which increases writing_bytes_.
-        d_->IntEvictBlockLRU();
+        d_->IntEvictNextBlock(lock);
     }
 }
 void BlockPool::ReleaseInternalMemory(size_t size) {
@@ -1123,6 +1250,60 @@ void BlockPool::ReleaseInternalMemory(size_t size) {
     return d_->IntReleaseInternalMemory(size);
 }
 
+Byte* BlockPool::Data::IntTakeFreeData(size_t size, size_t node) {
+    if (node >= free_data_.size()) return nullptr;
+    std::vector<std::pair<Byte*, size_t> >& list = free_data_[node];
+    for (size_t i = list.size(); i-- > 0; ) {
+        if (list[i].second != size) continue;
+        Byte* data = list[i].first;
+        list.erase(list.begin() + i);
+        free_bytes_ -= size;
+        return data;
+    }
+    return nullptr;
+}
+
+Byte* BlockPool::Data::AllocateData(size_t size, size_t node) {
+    Byte* data = aligned_alloc_.allocate(size);
+    // fresh pages of whole blocks are placed on the node when first touched
+    if (size % THRILL_DEFAULT_ALIGN == 0 &&
+        reinterpret_cast<uintptr_t>(data) % THRILL_DEFAULT_ALIGN == 0)
+        common::NumaTopology::Get().PreferNode(data, size, node);
+    return data;
+}
+
+bool BlockPool::Data::IntTryRequestInternalMemory(size_t size) {
+    if (hard_ram_limit_ != 0 &&
+        total_ram_bytes_ + requested_bytes_ + size > hard_ram_limit_)
+        return false;
+
+    total_ram_bytes_ += size;
+    return true;
+}
+
+void BlockPool::Data::IntReleaseData(Byte* data, size_t size, size_t node) {
+    if (node < free_data_.size() &&
+        free_data_[node].size() < max_free_data_per_node &&
+        (soft_ram_limit_ == 0 || total_ram_bytes_ <= soft_ram_limit_)) {
+        free_data_[node].emplace_back(data, size);
+        free_bytes_ += size;
+        return;
+    }
+    aligned_alloc_.deallocate(data, size);
+    IntReleaseInternalMemory(size);
+}
+
+void BlockPool::Data::IntDropFreeData() {
+    for (std::vector<std::pair<Byte*, size_t> >& list : free_data_) {
+        for (const std::pair<Byte*, size_t>& d : list) {
+            aligned_alloc_.deallocate(d.first, d.second);
+            free_bytes_ -= d.second;
+            IntReleaseInternalMemory(d.second);
+        }
+        list.clear();
+    }
+}
+
 void BlockPool::Data::IntReleaseInternalMemory(size_t size) {
 
     LOGC(debug_mem)
@@ -1141,11 +1322,52 @@ void BlockPool::EvictBlock(ByteBlock* block_ptr) {
 
     die_unless(block_ptr->in_memory());
 
-    die_unless(d_->unpinned_blocks_.exists(block_ptr));
-    d_->unpinned_blocks_.erase(block_ptr);
+    die_unless(d_->unpinned_blocks_->Exists(block_ptr));
+    d_->unpinned_blocks_->Erase(block_ptr);
     d_->unpinned_bytes_ -= block_ptr->size();
 
-    d_->IntEvictBlock(block_ptr);
+    d_->IntEvictBlock(lock, block_ptr);
+}
+
+void BlockPool::set_worker_numa_node(size_t local_worker_id, size_t node) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(local_worker_id < workers_per_host_);
+    d_->worker_node_[local_worker_id] = node;
+    if (node >= d_->free_data_.size())
+        d_->free_data_.resize(node + 1);
+}
+
+size_t BlockPool::worker_numa_node(size_t local_worker_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    assert(local_worker_id < workers_per_host_);
+    return d_->worker_node_[local_worker_id];
+}
+
+double BlockPool::read_latency() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return d_->read_latency_;
+}
+
+size_t BlockPool::ReadAheadWindow(size_t block_size, double interval) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Little's law: cover the read latency with Blocks in flight
+    size_t window = max_read_ahead;
+    if (interval > 0 && d_->read_latency_ / interval < max_read_ahead)
+        window = 1 + static_cast<size_t>(d_->read_latency_ / interval);
+
+    if (d_->hard_ram_limit_ != 0) {
+        // each worker may use a quarter of its share of the unpinned memory
+        size_t pinned =
+            d_->pin_count_.total_pinned_bytes_ + d_->requested_bytes_;
+        size_t avail =
+            d_->hard_ram_limit_ - std::min(d_->hard_ram_limit_, pinned);
+        window = std::min(
+            window,
+            avail / (4 * workers_per_host_ * std::max<size_t>(block_size, 1)));
+    }
+
+    return std::max<size_t>(window, 1);
 }
 
 io::RequestPtr BlockPool::GetAnyWriting() {
@@ -1154,23 +1376,35 @@ io::RequestPtr BlockPool::GetAnyWriting() {
     return d_->writing_.begin()->second;
 }
 
-io::RequestPtr BlockPool::EvictBlockLRU() {
+io::RequestPtr BlockPool::EvictNextBlock() {
     std::unique_lock<std::mutex> lock(mutex_);
-    return d_->IntEvictBlockLRU();
+    return d_->IntEvictNextBlock(lock);
 }
 
-io::RequestPtr BlockPool::Data::IntEvictBlockLRU() {
+void BlockPool::set_eviction_policy(std::unique_ptr<EvictionPolicy> policy) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    die_unless(policy && policy->size() == 0);
+    while (d_->unpinned_blocks_->size())
+        policy->Put(d_->unpinned_blocks_->Pop());
+
+    d_->unpinned_blocks_ = std::move(policy);
+}
 
-    if (!unpinned_blocks_.size()) return io::RequestPtr();
+io::RequestPtr BlockPool::Data::IntEvictNextBlock(
+    std::unique_lock<std::mutex>& lock) {
 
-    ByteBlock* block_ptr = unpinned_blocks_.pop();
+    if (!unpinned_blocks_->size()) return io::RequestPtr();
+
+    ByteBlock* block_ptr = unpinned_blocks_->Pop();
     die_unless(block_ptr);
     unpinned_bytes_ -= block_ptr->size();
 
-    return IntEvictBlock(block_ptr);
+    return IntEvictBlock(lock, block_ptr);
 }
 
-io::RequestPtr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
+io::RequestPtr BlockPool::Data::IntEvictBlock(
+    std::unique_lock<std::mutex>& lock, ByteBlock* block_ptr) {
 
     // die_unless(block_ptr->block_pool_ == this);
 
@@ -1191,8 +1425,51 @@ io::RequestPtr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
 
     die_unless(block_ptr->em_bid_.storage == nullptr);
 
+    // compress the block if requested and if this saves I/O
+    Byte* em_data = block_ptr->data_;
+    size_t em_size = block_ptr->size();
+
+    if (block_ptr->codec() != BlockCodec::None &&
+        em_size % THRILL_DEFAULT_ALIGN == 0 && em_size > THRILL_DEFAULT_ALIGN &&
+        IntTryRequestInternalMemory(block_ptr->size()))
+    {
+        // the buffer is released together with the block's memory once the
+        // write is complete, hence it is counted as being written.
+        writing_bytes_ += block_ptr->size();
+
+        // compress outside the lock, the block is reserved by compressing_.
+        compressing_.insert(block_ptr);
+        lock.unlock();
+
+        Byte* buffer = aligned_alloc_.allocate(block_ptr->size());
+
+        size_t compressed_size = BlockCompress(
+            block_ptr->codec(), block_ptr->data_, block_ptr->size(),
+            buffer, block_ptr->size() - THRILL_DEFAULT_ALIGN);
+
+        if (compressed_size == 0) {
+            aligned_alloc_.deallocate(buffer, block_ptr->size());
+            buffer = nullptr;
+        }
+
+        lock.lock();
+        compressing_.erase(block_ptr);
+        cv_compress_complete_.notify_all();
+
+        if (buffer) {
+            block_ptr->em_buffer_ = em_data = buffer;
+            block_ptr->em_compressed_size_ = compressed_size;
+            em_size = THRILL_DEFAULT_ALIGN * common::IntegerDivRoundUp(
+                compressed_size, size_t(THRILL_DEFAULT_ALIGN));
+        }
+        else {
+            writing_bytes_ -= block_ptr->size();
+            IntReleaseInternalMemory(block_ptr->size());
+        }
+    }
+
     // allocate EM block
-    block_ptr->em_bid_.size = block_ptr->size();
+    block_ptr->em_bid_.size = em_size;
     bm_->new_block(io::FullyRandom(), block_ptr->em_bid_);
 
     LOGC(debug_em)
@@ -1204,7 +1481,7 @@ io::RequestPtr BlockPool::Data::IntEvictBlock(ByteBlock* block_ptr) {
     // initiate writing to EM.
     io::RequestPtr req =
         block_ptr->em_bid_.storage->awrite(
-            block_ptr->data_, block_ptr->em_bid_.offset, block_ptr->size(),
+            em_data, block_ptr->em_bid_.offset, em_size,
             // construct an immediate CompletionHandler callback
             io::CompletionHandler::make<
                 ByteBlock, & ByteBlock::OnWriteComplete>(block_ptr));
@@ -1225,17 +1502,27 @@ void BlockPool::OnWriteComplete(
     die_unequal(d_->writing_.erase(block_ptr), 1u);
     d_->writing_bytes_ -= block_ptr->size();
 
+    if (block_ptr->em_buffer_) {
+        // release buffer of compressed data
+        d_->aligned_alloc_.deallocate(block_ptr->em_buffer_, block_ptr->size());
+        block_ptr->em_buffer_ = nullptr;
+
+        d_->writing_bytes_ -= block_ptr->size();
+        d_->IntReleaseInternalMemory(block_ptr->size());
+    }
+
     if (!success)
     {
         // request was canceled. this is not an I/O error, but intentional,
         // e.g. because the block was deleted.
 
-        die_unless(!d_->unpinned_blocks_.exists(block_ptr));
-        d_->unpinned_blocks_.put(block_ptr);
+        die_unless(!d_->unpinned_blocks_->Exists(block_ptr));
+        d_->unpinned_blocks_->Put(block_ptr);
         d_->unpinned_bytes_ += block_ptr->size();
 
         d_->bm_->delete_block(block_ptr->em_bid_);
         block_ptr->em_bid_ = io::BID<0>();
+        block_ptr->em_compressed_size_ = 0;
     }
     else    // success
     {
@@ -1281,7 +1568,7 @@ void BlockPool::RunTask(const std::chrono::steady_clock::time_point& tp) {
             << (unpinned_bytes + pinned_bytes + writing_bytes + reading_bytes)
             << "pinned_blocks" << d_->pin_count_.total_pins_
             << "pinned_bytes" << pinned_bytes
-            << "unpinned_blocks" << d_->unpinned_blocks_.size()
+            << "unpinned_blocks" << d_->unpinned_blocks_->size()
             << "unpinned_bytes" << unpinned_bytes
             << "swapped_blocks" << d_->swapped_.size()
             << "swapped_bytes" << d_->swapped_bytes_.hmax_update()
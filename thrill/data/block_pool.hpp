@@ -16,12 +16,14 @@
 #include <thrill/common/profile_task.hpp>
 #include <thrill/data/block.hpp>
 #include <thrill/data/byte_block.hpp>
+#include <thrill/data/eviction_policy.hpp>
 #include <thrill/io/block_manager.hpp>
 #include <thrill/io/request.hpp>
 #include <thrill/mem/manager.hpp>
 
 #include <algorithm>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <utility>
@@ -97,12 +99,37 @@ public:
     //! future request.
     void AdviseFree(size_t size);
 
+    //! Set the NUMA node of a local worker, on which ByteBlocks allocated or
+    //! pinned by the worker are placed. Defaults to node 0.
+    void set_worker_numa_node(size_t local_worker_id, size_t node);
+
+    //! Returns the NUMA node of a local worker.
+    size_t worker_numa_node(size_t local_worker_id);
+
+    //! maximum number of Blocks read ahead by a sequential reader
+    static constexpr size_t max_read_ahead = 64;
+
+    //! Returns the moving average of the latency of Block reads from external
+    //! memory in seconds, zero if no Block was read yet.
+    double read_latency();
+
+    //! Returns the number of Blocks of block_size bytes a sequential reader
+    //! consuming one Block every interval seconds should have in flight to
+    //! hide the measured read latency, bounded by max_read_ahead and the
+    //! unpinned memory.
+    size_t ReadAheadWindow(size_t block_size, double interval);
+
     //! Return any currently being written block (for waiting on completion)
     io::RequestPtr GetAnyWriting();
 
-    //! Evict a Block from the LRU chain into external memory. This can return
-    //! nullptr if no blocks available, or if the Block was not dirty.
-    io::RequestPtr EvictBlockLRU();
+    //! Evict the Block selected by the EvictionPolicy into external
+    //! memory. This can return nullptr if no blocks available, or if the Block
+    //! was not dirty.
+    io::RequestPtr EvictNextBlock();
+
+    //! Replace the EvictionPolicy, which defaults to CostAwareEvictionPolicy.
+    //! Currently unpinned ByteBlocks are moved over oldest first.
+    void set_eviction_policy(std::unique_ptr<EvictionPolicy> policy);
 
     //! Allocates a byte block with the request size. May block this thread if
     //! the hard memory limit is reached, until memory is freed by another
@@ -110,6 +137,11 @@ public:
     //! count.
     PinnedByteBlockPtr AllocateByteBlock(size_t size, size_t local_worker_id);
 
+    //! Allocates a byte block like above, but preferably on the given NUMA
+    //! node, e.g. that of the worker consuming the block.
+    PinnedByteBlockPtr AllocateByteBlock(
+        size_t size, size_t local_worker_id, size_t numa_node);
+
     //! Allocate a byte block from an external file, used to directly map system
     //! files to data::File.
     ByteBlockPtr MapExternalBlock(
@@ -199,6 +231,11 @@ private:
     //! Increment a ByteBlock's pin count - without locking the mutex
     void IntIncBlockPinCount(ByteBlock* block_ptr, size_t local_worker_id);
 
+    //! Allocate a ByteBlock preferably on the NUMA node - with the mutex held
+    PinnedByteBlockPtr IntAllocateByteBlock(
+        std::unique_lock<std::mutex>& lock,
+        size_t size, size_t local_worker_id, size_t numa_node);
+
     //! callback for async write of blocks during eviction
     void OnWriteComplete(ByteBlock* block_ptr, io::Request* req, bool success);
 
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -35,10 +36,16 @@ namespace data {
  * a) serializable Items or b) arbitray data from the Block sequence. It takes
  * care of fetching the next Block when the previous one underruns and also of
  * data items split between two Blocks.
+ *
+ * Blocks written by a BlockWriter with an IntegerEncoding other than None
+ * must be read by a BlockReader with the same Encoding parameter, which
+ * decodes integral values read via GetRaw(). The default reads raw bytes
+ * without any additional branches.
  */
-template <typename BlockSource>
+template <typename BlockSource,
+          IntegerEncoding Encoding = IntegerEncoding::None>
 class BlockReader
-    : public common::ItemReaderToolsBase<BlockReader<BlockSource> >
+    : public common::ItemReaderToolsBase<BlockReader<BlockSource, Encoding> >
 {
 public:
     static constexpr bool self_verify = common::g_self_verify;
@@ -63,6 +70,24 @@ public:
     //! move-assignment operator: default
     BlockReader& operator = (BlockReader&&) = default;
 
+    //! move-construct from a BlockReader with another integer encoding,
+    //! usually before it read the first Block.
+    template <IntegerEncoding OtherEncoding,
+              typename = typename std::enable_if<
+                  OtherEncoding != Encoding>::type>
+    explicit BlockReader(BlockReader<BlockSource, OtherEncoding>&& br)
+        : source_(std::move(br.source_)),
+          block_(std::move(br.block_)),
+          current_(br.current_),
+          end_(br.end_),
+          num_items_(br.num_items_),
+          block_collect_(br.block_collect_),
+          typecode_verify_(br.typecode_verify_),
+          int_encoding_(br.int_encoding_),
+          int_base_(br.int_base_) {
+        br.current_ = br.end_ = nullptr;
+    }
+
     //! return current block for debugging
     PinnedBlock CopyBlock() const {
         if (!block_.byte_block()) return PinnedBlock();
@@ -78,6 +103,9 @@ public:
     //! Returns typecode_verify_
     size_t typecode_verify() const { return typecode_verify_; }
 
+    //! Returns the encoding of integers in the current Block
+    IntegerEncoding int_encoding() const { return int_encoding_; }
+
     //! \name Reading (Generic) Items
     //! \{
 
@@ -91,7 +119,7 @@ public:
 
         if (self_verify && typecode_verify_) {
             // for self-verification, T is prefixed with its hash code
-            size_t code = GetRaw<size_t>();
+            size_t code = GetUnencoded<size_t>();
             if (code != typeid(T).hash_code()) {
                 die("BlockReader::Next() attempted to retrieve item "
                     "with different typeid! - expected "
@@ -133,7 +161,8 @@ public:
 
     //! Read n items, however, do not deserialize them but deliver them as a
     //! vector of (unpinned) Block objects. This is used to take out a range of
-    //! items, the internal item cursor is advanced by n.
+    //! items, the internal item cursor is advanced by n. Items in Blocks with
+    //! encoded integers are decoded one by one to find the end of the range.
     template <typename ItemType>
     std::vector<Block> GetItemBatch(size_t n) {
         static constexpr bool debug = false;
@@ -230,7 +259,8 @@ public:
         std::vector<PinnedBlock> out_pinned;
 
         block_collect_ = &out_pinned;
-        if (Serialization<BlockReader, ItemType>::is_fixed_size) {
+        if (Serialization<BlockReader, ItemType>::is_fixed_size &&
+            int_encoding_ == IntegerEncoding::None) {
             Skip(n, n * ((self_verify && typecode_verify_ ? sizeof(size_t) : 0) +
                          Serialization<BlockReader, ItemType>::fixed_size));
         }
@@ -327,6 +357,19 @@ public:
         static_assert(std::is_pod<Type>::value,
                       "You only want to GetRaw() POD types as raw values.");
 
+        return GetEncodedInteger<Type>(
+            std::integral_constant<
+                bool, Encoding != IntegerEncoding::None &&
+                IsEncodedInteger<Type>::value>());
+    }
+
+    //! \}
+
+private:
+    //! Fetch the raw bytes of a single item of type Type, regardless of the
+    //! integer encoding.
+    template <typename Type>
+    Type GetUnencoded() {
         Type ret;
 
         // fast path for reading item from block if it fits.
@@ -341,9 +384,37 @@ public:
         return ret;
     }
 
-    //! \}
+    //! Fetch an integral value encoded by BlockWriter::PutEncodedInteger().
+    template <typename Type>
+    Type GetEncodedInteger(std::true_type) {
+        // the value is encoded relative to the Block in which it starts.
+        while (THRILL_UNLIKELY(current_ == end_)) {
+            if (!NextBlock())
+                throw std::runtime_error("Data underflow in BlockReader.");
+        }
+        // Blocks of writers without encoding may be mixed in.
+        if (int_encoding_ == IntegerEncoding::None)
+            return GetUnencoded<Type>();
+
+        uint64_t base = int_base_;
+
+        Byte b = *current_++;
+        bool absolute = (b & 1) != 0;
+        uint64_t v = (b >> 1) & 0x3F;
+        for (size_t shift = 6; b & 0x80; shift += 7) {
+            b = GetByte();
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        }
+
+        return static_cast<Type>(absolute ? v : base + ZigZagDecode(v));
+    }
+
+    //! non-integral values and all values without encoding are read raw.
+    template <typename Type>
+    Type GetEncodedInteger(std::false_type) {
+        return GetUnencoded<Type>();
+    }
 
-private:
     //! Instance of BlockSource. This is NOT a reference, as to enable embedding
     //! of FileBlockSource to compose classes into File::Reader.
     BlockSource source_;
@@ -367,6 +438,12 @@ private:
     //! BlockReader, this is false to needed to read external files.
     bool typecode_verify_;
 
+    //! encoding of integers in the current Block
+    IntegerEncoding int_encoding_ = IntegerEncoding::None;
+
+    //! base of encoded integers in the current Block
+    uint64_t int_base_ = 0;
+
     //! Call source_.NextBlock with appropriate parameters
     bool NextBlock() {
         // first release old pin.
@@ -384,8 +461,19 @@ private:
         end_ = block_.data_end();
         num_items_ = block_.num_items();
         typecode_verify_ = block_.typecode_verify();
+        int_encoding_ = block_.byte_block()->int_encoding();
+        if (int_encoding_ != IntegerEncoding::None) {
+            if (Encoding == IntegerEncoding::None)
+                die("BlockReader: Block with encoded integers must be read"
+                    " by a BlockReader with the same IntegerEncoding");
+            int_base_ = block_.byte_block()->int_base();
+        }
         return true;
     }
+
+    //! BlockReaders with other encodings are friends for moving.
+    template <typename OtherBlockSource, IntegerEncoding OtherEncoding>
+    friend class BlockReader;
 };
 
 //! \}
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <deque>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace thrill {
@@ -47,10 +48,15 @@ public:
  * item. When a Block is full it is emitted to an attached BlockSink, like a
  * File, a ChannelSink, etc. for further delivery. The BlockWriter takes care of
  * segmenting items when a Block is full.
+ *
+ * The Encoding parameter selects at compile-time how integral values written
+ * via PutRaw() are stored, see IntegerEncoding. The default writes raw bytes
+ * without any additional branches.
  */
-template <typename BlockSink>
+template <typename BlockSink,
+          IntegerEncoding Encoding = IntegerEncoding::None>
 class BlockWriter
-    : public common::ItemWriterToolsBase<BlockWriter<BlockSink> >
+    : public common::ItemWriterToolsBase<BlockWriter<BlockSink, Encoding> >
 {
 public:
     static constexpr bool debug = false;
@@ -86,6 +92,8 @@ public:
           sink_queue_(std::move(bw.sink_queue_)),
           block_size_(std::move(bw.block_size_)),
           max_block_size_(std::move(bw.max_block_size_)),
+          int_base_(std::move(bw.int_base_)),
+          int_base_set_(std::move(bw.int_base_set_)),
           closed_(std::move(bw.closed_)) {
         // set closed flag -> disables destructor
         bw.closed_ = true;
@@ -105,12 +113,31 @@ public:
         sink_queue_ = std::move(bw.sink_queue_);
         block_size_ = std::move(bw.block_size_);
         max_block_size_ = std::move(bw.max_block_size_);
+        int_base_ = std::move(bw.int_base_);
+        int_base_set_ = std::move(bw.int_base_set_);
         closed_ = std::move(bw.closed_);
         // set closed flag -> disables destructor
         bw.closed_ = true;
         return *this;
     }
 
+    //! move-construct from a BlockWriter with another integer encoding. This
+    //! flushes its current Block, since the encoding is stored per ByteBlock.
+    template <IntegerEncoding OtherEncoding,
+              typename = typename std::enable_if<
+                  OtherEncoding != Encoding>::type>
+    explicit BlockWriter(BlockWriter<BlockSink, OtherEncoding>&& bw)
+        : sink_(bw.sink_),
+          block_size_(bw.block_size_),
+          max_block_size_(bw.max_block_size_),
+          closed_(bw.closed_) {
+        assert(!bw.do_queue_);
+        bw.Flush();
+        bw.bytes_.reset();
+        // set closed flag -> disables destructor
+        bw.closed_ = true;
+    }
+
     //! On destruction, the last partial block is flushed.
     ~BlockWriter() {
         if (!closed_)
@@ -129,23 +156,30 @@ public:
     //! Return whether an actual BlockSink is attached.
     bool IsValid() const { return sink_ != nullptr; }
 
+    //! Returns the encoding of integral values, which are written via
+    //! PutRaw() by the serialization of PODs, pairs, and tuples.
+    static constexpr IntegerEncoding int_encoding() { return Encoding; }
+
     //! Flush the current block (only really meaningful for a network sink).
     void Flush() {
         if (!bytes_) return;
+        // encoded blocks start after the base of integers
+        size_t begin = block_begin();
         // don't flush if the block is truly empty.
-        if (current_ == bytes_->begin() && nitems_ == 0) return;
+        if (current_ == bytes_->begin() + begin && nitems_ == 0) return;
 
         if (do_queue_) {
             sLOG << "Flush(): queue" << bytes_.get();
             sink_queue_.emplace_back(
-                std::move(bytes_), 0, current_ - bytes_->begin(),
+                std::move(bytes_), begin, current_ - bytes_->begin(),
                 first_offset_, nitems_,
                 static_cast<bool>(/* typecode_verify */ self_verify));
         }
         else {
             sLOG << "Flush(): flush" << bytes_.get();
             sink_->AppendPinnedBlock(
-                PinnedBlock(std::move(bytes_), 0, current_ - bytes_->begin(),
+                PinnedBlock(std::move(bytes_),
+                            begin, current_ - bytes_->begin(),
                             first_offset_, nitems_,
                             static_cast<bool>(/* typecode_verify */ self_verify)));
         }
@@ -246,7 +280,7 @@ public:
             MarkItem();
             if (self_verify && !NoSelfVerify) {
                 // for self-verification, prefix T with its hash code
-                PutRaw(typeid(T).hash_code());
+                PutUnencoded(typeid(T).hash_code());
             }
             Serialization<BlockWriter, T>::Serialize(x, *this);
 
@@ -271,6 +305,12 @@ public:
                 sink_queue_.pop_back();
 
                 bytes_ = std::move(b).StealPinnedByteBlock();
+
+                if (Encoding != IntegerEncoding::None) {
+                    // continue with the base stored in the restored block
+                    int_base_ = bytes_->int_base();
+                    int_base_set_ = true;
+                }
             }
 
             sLOG << "reset" << bytes_.get();
@@ -299,7 +339,7 @@ public:
             MarkItem();
             if (self_verify && !NoSelfVerify) {
                 // for self-verification, prefix T with its hash code
-                PutRaw(typeid(T).hash_code());
+                PutUnencoded(typeid(T).hash_code());
             }
             Serialization<BlockWriter, T>::Serialize(x, *this);
         }
@@ -367,6 +407,19 @@ public:
 
         assert(!closed_);
 
+        return PutEncodedInteger(
+            item, std::integral_constant<
+                bool, Encoding != IntegerEncoding::None &&
+                IsEncodedInteger<Type>::value>());
+    }
+
+    //! \}
+
+private:
+    //! Put (append) the raw bytes of a single item of type T, regardless of
+    //! the integer encoding.
+    template <typename Type>
+    BlockWriter& PutUnencoded(const Type& item) {
         // fast path for writing item into block if it fits.
         if (THRILL_LIKELY(current_ + sizeof(Type) <= end_)) {
             *reinterpret_cast<Type*>(current_) = item;
@@ -378,9 +431,48 @@ public:
         return Append(&item, sizeof(item));
     }
 
-    //! \}
+    //! Returns the offset of the first byte of data in the current block.
+    static constexpr size_t block_begin() {
+        return Encoding != IntegerEncoding::None ? int_base_size : 0;
+    }
+
+    //! Append an integral value as tagged varint of either the zigzag encoded
+    //! difference to the base of the ByteBlock or of the value itself,
+    //! whichever is smaller. The first value in a ByteBlock becomes its base.
+    template <typename Type>
+    BlockWriter& PutEncodedInteger(const Type& item, std::true_type) {
+        // determine the base in the same Block as the reader will.
+        if (THRILL_UNLIKELY(current_ == end_))
+            Flush(), AllocateBlock();
+
+        uint64_t value = static_cast<uint64_t>(item);
+        if (!int_base_set_) {
+            bytes_->set_int_base(value);
+            int_base_ = value;
+            int_base_set_ = true;
+        }
+
+        uint64_t delta = ZigZagEncode(value - int_base_);
+        bool absolute = value < delta;
+        uint64_t v = absolute ? value : delta;
+
+        // the first byte holds the tag and six bits, the others seven bits.
+        Byte b = static_cast<Byte>((absolute ? 1 : 0) | ((v & 0x3F) << 1));
+        v >>= 6;
+        while (v != 0) {
+            PutByte(b | 0x80);
+            b = static_cast<Byte>(v & 0x7F);
+            v >>= 7;
+        }
+        return PutByte(b);
+    }
+
+    //! non-integral values and all values without encoding are put raw.
+    template <typename Type>
+    BlockWriter& PutEncodedInteger(const Type& item, std::false_type) {
+        return PutUnencoded(item);
+    }
 
-private:
     //! Allocate a new block (overwriting the existing one).
     void AllocateBlock() {
         bytes_ = sink_->AllocateByteBlock(block_size_);
@@ -396,6 +488,16 @@ private:
         end_ = bytes_->end();
         nitems_ = 0;
         first_offset_ = 0;
+
+        if (Encoding != IntegerEncoding::None) {
+            // reserve space for the base, which is set by the first integer.
+            bytes_->set_int_encoding(Encoding);
+            bytes_->set_int_base(0);
+            current_ += int_base_size;
+            first_offset_ = int_base_size;
+            int_base_ = 0;
+            int_base_set_ = false;
+        }
     }
 
     //! current block, already allocated as shared ptr, since we want to use
@@ -430,8 +532,18 @@ private:
     //! size of data blocks to construct
     size_t max_block_size_;
 
+    //! base of encoded integers in the current Block
+    uint64_t int_base_ = 0;
+
+    //! whether the first integer in the current Block has set the base
+    bool int_base_set_ = false;
+
     //! Flag if Close was called explicitly
     bool closed_ = false;
+
+    //! BlockWriters with other encodings are friends for moving.
+    template <typename OtherBlockSink, IntegerEncoding OtherEncoding>
+    friend class BlockWriter;
 };
 
 //! alias for BlockWriter which outputs to a generic BlockSink.
@@ -13,10 +13,15 @@
 #define THRILL_DATA_BYTE_BLOCK_HEADER
 
 #include <thrill/common/counting_ptr.hpp>
+#include <thrill/data/block_codec.hpp>
+#include <thrill/data/eviction_policy.hpp>
+#include <thrill/data/integer_encoding.hpp>
 #include <thrill/io/bid.hpp>
 #include <thrill/io/file_base.hpp>
 #include <thrill/mem/pool.hpp>
 
+#include <atomic>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -85,6 +90,38 @@ public:
     //! Returns whether the ByteBlock is in an external file.
     bool has_ext_file() const { return ext_file_.get() != nullptr; }
 
+    //! Returns the codec applied when evicting the block to external memory.
+    BlockCodec codec() const { return codec_; }
+
+    //! Sets the codec applied when evicting the block to external memory.
+    void set_codec(BlockCodec codec) { codec_ = codec; }
+
+    //! Returns the hint on the future use of the block for eviction.
+    EvictionHint eviction_hint() const { return eviction_hint_; }
+
+    //! Sets the hint on the future use of the block for eviction. It takes
+    //! effect when the block is next unpinned.
+    void set_eviction_hint(EvictionHint hint) { eviction_hint_ = hint; }
+
+    //! Returns the encoding of integers written into the ByteBlock.
+    IntegerEncoding int_encoding() const { return int_encoding_; }
+
+    //! Sets the encoding of integers written into the ByteBlock, this is done
+    //! by the BlockWriter creating it.
+    void set_int_encoding(IntegerEncoding e) { int_encoding_ = e; }
+
+    //! Returns the base of encoded integers, stored in the first bytes.
+    uint64_t int_base() const {
+        uint64_t base;
+        memcpy(&base, data_, sizeof(base));
+        return base;
+    }
+
+    //! Stores the base of encoded integers in the first bytes.
+    void set_int_base(uint64_t base) {
+        memcpy(data_, &base, sizeof(base));
+    }
+
     //! return current pin count
     size_t pin_count(size_t local_worker_id) const {
         return pin_count_[local_worker_id];
@@ -130,6 +167,27 @@ private:
     //! was created for directly reading binary files.
     io::FileBasePtr ext_file_;
 
+    //! codec applied when evicting the block to external memory, set by the
+    //! Files containing the block.
+    std::atomic<BlockCodec> codec_ { BlockCodec::None };
+
+    //! hint on the future use of the block, set by the Files containing it.
+    std::atomic<EvictionHint> eviction_hint_ { EvictionHint::Default };
+
+    //! encoding of integers written into the ByteBlock
+    IntegerEncoding int_encoding_ = IntegerEncoding::None;
+
+    //! number of compressed bytes in external memory, zero if the block was
+    //! written raw.
+    size_t em_compressed_size_ = 0;
+
+    //! buffer holding the compressed bytes while they are written to or read
+    //! from external memory.
+    Byte* em_buffer_ = nullptr;
+
+    //! NUMA node of the worker for which data_ was allocated
+    size_t numa_node_ = 0;
+
     // BlockPool is a friend to call ctor and to manipulate data_.
     friend class BlockPool;
     // Block is a friend to call {Increase,Reduce}PinCount()
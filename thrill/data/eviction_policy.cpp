@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * thrill/data/eviction_policy.cpp
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#include <thrill/data/eviction_policy.hpp>
+
+#include <thrill/common/die.hpp>
+#include <thrill/data/byte_block.hpp>
+
+#include <cassert>
+
+namespace thrill {
+namespace data {
+
+/******************************************************************************/
+// LruEvictionPolicy
+
+void LruEvictionPolicy::Put(ByteBlock* block_ptr) {
+    lru_.put(block_ptr);
+}
+
+void LruEvictionPolicy::Erase(ByteBlock* block_ptr) {
+    lru_.erase(block_ptr);
+}
+
+bool LruEvictionPolicy::Exists(ByteBlock* block_ptr) const {
+    return lru_.exists(block_ptr);
+}
+
+size_t LruEvictionPolicy::size() const {
+    return lru_.size();
+}
+
+ByteBlock* LruEvictionPolicy::Pop() {
+    return lru_.pop();
+}
+
+/******************************************************************************/
+// CostAwareEvictionPolicy
+
+size_t CostAwareEvictionPolicy::EvictionCost(EvictionHint hint) {
+    switch (hint) {
+    case EvictionHint::ConsumeOnce:
+        // one write and one read
+        return 2;
+    case EvictionHint::Default:
+        // one write, and maybe a few reads
+        return 3;
+    case EvictionHint::WillReread:
+        // one write, and a read per iteration over the data
+        return 8;
+    case EvictionHint::Hot:
+        return 32;
+    }
+    die("Invalid EvictionHint " << static_cast<unsigned>(hint));
+}
+
+void CostAwareEvictionPolicy::Put(ByteBlock* block_ptr) {
+    size_t hint = static_cast<size_t>(block_ptr->eviction_hint());
+    assert(hint < num_hints_);
+    die_unless(map_.find(block_ptr) == map_.end());
+
+    lists_[hint].emplace_front(block_ptr, ++clock_);
+    map_.emplace(block_ptr, std::make_pair(hint, lists_[hint].begin()));
+}
+
+void CostAwareEvictionPolicy::Erase(ByteBlock* block_ptr) {
+    auto it = map_.find(block_ptr);
+    die_unless(it != map_.end());
+
+    lists_[it->second.first].erase(it->second.second);
+    map_.erase(it);
+}
+
+bool CostAwareEvictionPolicy::Exists(ByteBlock* block_ptr) const {
+    return map_.find(block_ptr) != map_.end();
+}
+
+size_t CostAwareEvictionPolicy::size() const {
+    return map_.size();
+}
+
+ByteBlock* CostAwareEvictionPolicy::Pop() {
+    assert(size());
+
+    // select the list whose oldest ByteBlock has the largest age per cost:
+    // compare age_a / cost_a < age_b / cost_b via cross multiplication.
+    size_t best = num_hints_;
+    uint64_t best_age = 0, best_cost = 1;
+
+    for (size_t h = 0; h < num_hints_; ++h) {
+        if (lists_[h].empty()) continue;
+
+        uint64_t age = clock_ - lists_[h].back().second + 1;
+        uint64_t cost = EvictionCost(static_cast<EvictionHint>(h));
+
+        if (best == num_hints_ || age * best_cost > best_age * cost) {
+            best = h;
+            best_age = age, best_cost = cost;
+        }
+    }
+    assert(best != num_hints_);
+
+    ByteBlock* block_ptr = lists_[best].back().first;
+    lists_[best].pop_back();
+    map_.erase(block_ptr);
+    return block_ptr;
+}
+
+} // namespace data
+} // namespace thrill
+
+/******************************************************************************/
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * thrill/data/eviction_policy.hpp
+ *
+ * Policies selecting which unpinned ByteBlock the BlockPool evicts next.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_EVICTION_POLICY_HEADER
+#define THRILL_DATA_EVICTION_POLICY_HEADER
+
+#include <thrill/common/lru_cache.hpp>
+#include <thrill/mem/pool.hpp>
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+class ByteBlock;
+
+//! Hint on the future use of the ByteBlocks of a File, used by the
+//! EvictionPolicy to decide which unpinned ByteBlock to evict.
+enum class EvictionHint : uint8_t {
+    //! nothing is known about the future use
+    Default = 0,
+    //! the data is read at most once more, e.g. spilled or consumed data.
+    ConsumeOnce = 1,
+    //! the data will be read again, e.g. cached DIAs and sorted runs.
+    WillReread = 2,
+    //! the data is read frequently.
+    Hot = 3
+};
+
+/*!
+ * Interface of a policy which holds the set of unpinned ByteBlocks in RAM and
+ * selects which of them the BlockPool evicts next. All methods are called with
+ * the BlockPool's mutex held.
+ */
+class EvictionPolicy
+{
+public:
+    virtual ~EvictionPolicy() { }
+
+    //! Insert an unpinned ByteBlock, which becomes a candidate for eviction.
+    virtual void Put(ByteBlock* block_ptr) = 0;
+
+    //! Remove a ByteBlock, because it was pinned or destroyed.
+    virtual void Erase(ByteBlock* block_ptr) = 0;
+
+    //! Returns whether the ByteBlock is contained.
+    virtual bool Exists(ByteBlock* block_ptr) const = 0;
+
+    //! Returns the number of contained ByteBlocks.
+    virtual size_t size() const = 0;
+
+    //! Select, remove, and return the next ByteBlock to evict. The policy must
+    //! not be empty.
+    virtual ByteBlock* Pop() = 0;
+};
+
+/*!
+ * Evicts the least recently unpinned ByteBlock, ignoring all hints.
+ */
+class LruEvictionPolicy final : public EvictionPolicy
+{
+public:
+    void Put(ByteBlock* block_ptr) final;
+    void Erase(ByteBlock* block_ptr) final;
+    bool Exists(ByteBlock* block_ptr) const final;
+    size_t size() const final;
+    ByteBlock* Pop() final;
+
+private:
+    //! list of unpinned ByteBlocks in LRU order
+    common::LruCacheSet<
+        ByteBlock*, mem::GPoolAllocator<ByteBlock*> > lru_;
+};
+
+/*!
+ * Keeps an LRU list for each EvictionHint and evicts the oldest ByteBlock of
+ * the list with the largest age relative to the expected I/O cost of evicting
+ * its ByteBlocks: writing them and reading them back once for ConsumeOnce,
+ * and repeatedly for WillReread and Hot. Ages are counted in unpins. Hence,
+ * with only Default hints this is LRU, while a cached working set is only
+ * evicted after data which is touched once has aged several times longer.
+ */
+class CostAwareEvictionPolicy final : public EvictionPolicy
+{
+public:
+    void Put(ByteBlock* block_ptr) final;
+    void Erase(ByteBlock* block_ptr) final;
+    bool Exists(ByteBlock* block_ptr) const final;
+    size_t size() const final;
+    ByteBlock* Pop() final;
+
+    //! relative cost of evicting a ByteBlock with the given hint
+    static size_t EvictionCost(EvictionHint hint);
+
+private:
+    //! number of EvictionHint values
+    static constexpr size_t num_hints_ = 4;
+
+    //! ByteBlock with the clock value when it was unpinned.
+    using Entry = std::pair<ByteBlock*, uint64_t>;
+
+    using List = std::list<Entry, mem::GPoolAllocator<Entry> >;
+
+    //! LRU lists of ByteBlocks per hint, most recently unpinned at the front.
+    List lists_[num_hints_];
+
+    //! map of ByteBlocks to their hint list and list entry
+    std::unordered_map<
+        ByteBlock*, std::pair<size_t, List::iterator>,
+        std::hash<ByteBlock*>, std::equal_to<ByteBlock*>,
+        mem::GPoolAllocator<
+            std::pair<ByteBlock* const, std::pair<size_t, List::iterator> > >
+    > map_;
+
+    //! logical clock, incremented on each Put()
+    uint64_t clock_ = 0;
+};
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_EVICTION_POLICY_HEADER
+
+/******************************************************************************/
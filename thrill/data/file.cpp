@@ -10,6 +10,8 @@
 
 #include <thrill/data/file.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <string>
 
@@ -41,9 +43,17 @@ File File::Copy() const {
     f.size_bytes_ = size_bytes_;
     f.stats_bytes_ = stats_bytes_;
     f.stats_items_ = stats_items_;
+    f.codec_ = codec_;
+    f.eviction_hint_ = eviction_hint_;
     return f;
 }
 
+void File::set_eviction_hint(EvictionHint hint) {
+    eviction_hint_ = hint;
+    for (const Block& b : blocks_)
+        b.byte_block()->set_eviction_hint(hint);
+}
+
 void File::Close() {
     // 2016-02-04: Files are never closed, one can always append. This is
     // current used by the ReduceTables -tb.
@@ -98,6 +108,31 @@ std::ostream& operator << (std::ostream& os, const File& f) {
     return os << "]]";
 }
 
+/******************************************************************************/
+// FileReadAhead
+
+void FileReadAhead::OnRequest(BlockPool& block_pool) {
+    if (!adaptive_ || sequential_ == 0) return;
+
+    double interval = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - last_deliver_).count();
+    interval_ = sequential_ == 1
+                ? interval : 0.75 * interval_ + 0.25 * interval;
+
+    size_t target = block_pool.ReadAheadWindow(block_size_, interval_);
+    if (target <= window_)
+        window_ = target;
+    else if (sequential_ >= window_)
+        window_ = std::min(target, 2 * window_);
+}
+
+void FileReadAhead::OnDeliver(size_t block_size) {
+    if (!adaptive_) return;
+    ++sequential_;
+    block_size_ = block_size;
+    last_deliver_ = std::chrono::steady_clock::now();
+}
+
 /******************************************************************************/
 // KeepFileBlockSource
 
@@ -106,24 +141,22 @@ KeepFileBlockSource::KeepFileBlockSource(
     size_t num_prefetch,
     size_t first_block, size_t first_item)
     : file_(file), local_worker_id_(local_worker_id),
-      num_prefetch_(num_prefetch),
+      read_ahead_(num_prefetch),
       first_block_(first_block), current_block_(first_block),
       first_item_(first_item) { }
 
 void KeepFileBlockSource::Prefetch(size_t prefetch) {
-    if (prefetch >= num_prefetch_) {
-        num_prefetch_ = prefetch;
-        // prefetch #desired blocks
-        while (fetching_blocks_.size() < num_prefetch_ &&
-               current_block_ < file_.num_blocks())
-        {
-            fetching_blocks_.emplace_back(
-                NextUnpinnedBlock().Pin(local_worker_id_));
-        }
-    }
-    else if (prefetch < num_prefetch_) {
-        num_prefetch_ = prefetch;
-        // cannot discard prefetched Blocks
+    read_ahead_.set_window(prefetch);
+    // cannot discard prefetched Blocks if the window shrinks
+    FetchAhead();
+}
+
+void KeepFileBlockSource::FetchAhead() {
+    while (fetching_blocks_.size() < read_ahead_.window() &&
+           current_block_ < file_.num_blocks())
+    {
+        fetching_blocks_.emplace_back(
+            NextUnpinnedBlock().Pin(local_worker_id_));
     }
 }
 
@@ -132,7 +165,7 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     if (current_block_ >= file_.num_blocks() && fetching_blocks_.empty())
         return PinnedBlock();
 
-    if (num_prefetch_ == 0)
+    if (read_ahead_.window() == 0)
     {
         // operate without prefetching
         return NextUnpinnedBlock().PinWait(local_worker_id_);
@@ -140,16 +173,13 @@ PinnedBlock KeepFileBlockSource::NextBlock() {
     else
     {
         // prefetch #desired blocks
-        while (fetching_blocks_.size() < num_prefetch_ &&
-               current_block_ < file_.num_blocks())
-        {
-            fetching_blocks_.emplace_back(
-                NextUnpinnedBlock().Pin(local_worker_id_));
-        }
+        read_ahead_.OnRequest(*file_.block_pool());
+        FetchAhead();
 
         // this might block if the prefetching is not finished
         PinnedBlock b = fetching_blocks_.front()->Wait();
         fetching_blocks_.pop_front();
+        read_ahead_.OnDeliver(b.size());
         return b;
     }
 }
@@ -174,54 +204,65 @@ Block KeepFileBlockSource::NextUnpinnedBlock() {
 ConsumeFileBlockSource::ConsumeFileBlockSource(
     File* file, size_t local_worker_id, size_t num_prefetch)
     : file_(file), local_worker_id_(local_worker_id),
-      num_prefetch_(num_prefetch) {
-    Prefetch(num_prefetch_);
+      read_ahead_(num_prefetch) {
+    FetchAhead();
 }
 
 ConsumeFileBlockSource::ConsumeFileBlockSource(ConsumeFileBlockSource&& s)
     : file_(s.file_), local_worker_id_(s.local_worker_id_),
-      num_prefetch_(s.num_prefetch_),
+      read_ahead_(s.read_ahead_),
       fetching_blocks_(std::move(s.fetching_blocks_)) {
     s.file_ = nullptr;
 }
 
 void ConsumeFileBlockSource::Prefetch(size_t prefetch) {
-    if (prefetch >= num_prefetch_) {
-        num_prefetch_ = prefetch;
-        while (fetching_blocks_.size() < num_prefetch_ && !file_->blocks_.empty()) {
-            fetching_blocks_.emplace_back(
-                file_->blocks_.front().Pin(local_worker_id_));
-            file_->blocks_.pop_front();
-        }
-    }
-    else if (prefetch < num_prefetch_) {
-        num_prefetch_ = prefetch;
-        // cannot discard prefetched Blocks
+    read_ahead_.set_window(prefetch);
+    // cannot discard prefetched Blocks if the window shrinks
+    FetchAhead();
+}
+
+void ConsumeFileBlockSource::FetchAhead() {
+    while (fetching_blocks_.size() < read_ahead_.window() &&
+           !file_->blocks_.empty())
+    {
+        fetching_blocks_.emplace_back(
+            file_->blocks_.front().Pin(local_worker_id_));
+        file_->blocks_.pop_front();
     }
 }
 
+bool ConsumeFileBlockSource::PrefetchOne() {
+    if (file_->blocks_.empty()) return false;
+    fetching_blocks_.emplace_back(
+        file_->blocks_.front().Pin(local_worker_id_));
+    file_->blocks_.pop_front();
+    return true;
+}
+
+size_t ConsumeFileBlockSource::num_unfetched() const {
+    return file_->blocks_.size();
+}
+
 PinnedBlock ConsumeFileBlockSource::NextBlock() {
     assert(file_);
     if (file_->blocks_.empty() && fetching_blocks_.empty())
         return PinnedBlock();
 
-    // operate without prefetching
-    if (num_prefetch_ == 0) {
+    // operate without prefetching, unless Blocks were pinned by PrefetchOne()
+    if (read_ahead_.window() == 0 && fetching_blocks_.empty()) {
         data::PinRequestPtr f = file_->blocks_.front().Pin(local_worker_id_);
         file_->blocks_.pop_front();
         return f->Wait();
     }
 
     // prefetch #desired blocks
-    while (fetching_blocks_.size() < num_prefetch_ && !file_->blocks_.empty()) {
-        fetching_blocks_.emplace_back(
-            file_->blocks_.front().Pin(local_worker_id_));
-        file_->blocks_.pop_front();
-    }
+    read_ahead_.OnRequest(*file_->block_pool());
+    FetchAhead();
 
     // this might block if the prefetching is not finished
     PinnedBlock b = fetching_blocks_.front()->Wait();
     fetching_blocks_.pop_front();
+    read_ahead_.OnDeliver(b.size());
     return b;
 }
 
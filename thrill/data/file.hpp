@@ -22,6 +22,7 @@
 #include <thrill/data/dyn_block_reader.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <limits>
@@ -60,6 +61,8 @@ public:
     using ConsumeReader = BlockReader<ConsumeFileBlockSource>;
     using DynWriter = DynBlockWriter;
 
+    //! initial number of Blocks read ahead by readers, which then adapt it to
+    //! the read latency. 0 disables read-ahead.
     static constexpr size_t default_prefetch = 2;
 
     //! Constructor from BlockPool
@@ -96,6 +99,9 @@ public:
     //! items after the offset first.
     void AppendBlock(const Block& b) final {
         if (b.size() == 0) return;
+        if (codec_ != BlockCodec::None) b.byte_block()->set_codec(codec_);
+        if (eviction_hint_ != EvictionHint::Default)
+            b.byte_block()->set_eviction_hint(eviction_hint_);
         num_items_sum_.push_back(num_items() + b.num_items());
         size_bytes_ += b.size();
         stats_bytes_ += b.size();
@@ -107,6 +113,9 @@ public:
     //! items after the offset first.
     void AppendBlock(Block&& b) final {
         if (b.size() == 0) return;
+        if (codec_ != BlockCodec::None) b.byte_block()->set_codec(codec_);
+        if (eviction_hint_ != EvictionHint::Default)
+            b.byte_block()->set_eviction_hint(eviction_hint_);
         num_items_sum_.push_back(num_items() + b.num_items());
         size_bytes_ += b.size();
         stats_bytes_ += b.size();
@@ -162,9 +171,12 @@ public:
     ConsumeReader GetConsumeReader(
         size_t num_prefetch = File::default_prefetch);
 
-    //! Get BlockReader seeked to the corresponding item index
-    template <typename ItemType>
-    KeepReader GetReaderAt(
+    //! Get BlockReader seeked to the corresponding item index. With an
+    //! IntegerEncoding, items have variable size, hence the preceding items in
+    //! the Block are decoded.
+    template <typename ItemType,
+              IntegerEncoding Encoding = IntegerEncoding::None>
+    BlockReader<KeepFileBlockSource, Encoding> GetReaderAt(
         size_t index, size_t prefetch = default_prefetch) const;
 
     //! Read complete File into a std::string, obviously, this should only be
@@ -206,7 +218,8 @@ public:
 
     //! Get item at the corresponding position. Do not use this
     //! method for reading multiple successive items.
-    template <typename ItemType>
+    template <typename ItemType,
+              IntegerEncoding Encoding = IntegerEncoding::None>
     ItemType GetItemAt(size_t index) const;
 
     /*!
@@ -253,6 +266,22 @@ public:
     //! construction)
     void set_dia_id(size_t dia_id) { dia_id_ = dia_id; }
 
+    //! Returns the codec applied to Blocks of this File when evicted.
+    BlockCodec codec() const { return codec_; }
+
+    //! Set the codec applied to Blocks appended to this File when they are
+    //! evicted to external memory. This pays off for compressible items, which
+    //! are written and read more than once.
+    void set_codec(BlockCodec codec) { codec_ = codec; }
+
+    //! Returns the hint on the future use of the Blocks of this File.
+    EvictionHint eviction_hint() const { return eviction_hint_; }
+
+    //! Set the hint on the future use of the Blocks of this File, which the
+    //! BlockPool's EvictionPolicy uses to select Blocks to evict. The hint is
+    //! applied to all contained and appended Blocks.
+    void set_eviction_hint(EvictionHint hint);
+
 private:
     //! unique file id
     size_t id_;
@@ -279,6 +308,12 @@ private:
     //! decreases.
     size_t stats_items_ = 0;
 
+    //! codec applied to appended Blocks when evicted to external memory
+    BlockCodec codec_ = BlockCodec::None;
+
+    //! hint on the future use of appended Blocks for eviction
+    EvictionHint eviction_hint_ = EvictionHint::Default;
+
     //! for access to blocks_ and num_items_sum_
     friend class data::KeepFileBlockSource;
     friend class data::ConsumeFileBlockSource;
@@ -286,6 +321,56 @@ private:
 
 using FilePtr = common::CountingPtr<File>;
 
+/*!
+ * Adaptive read-ahead of a File reader. The number of Blocks pinned ahead of
+ * the reader starts at the initial window and then follows
+ * BlockPool::ReadAheadWindow() for the reader's time between two Blocks,
+ * excluding time waiting for reads. The window grows by at most doubling and
+ * only after as many Blocks were read sequentially, hence short reads pin few
+ * Blocks, but shrinks immediately, e.g. when memory becomes scarce.
+ */
+class FileReadAhead
+{
+public:
+    //! Start with the given window, 0 disables read-ahead.
+    explicit FileReadAhead(size_t window)
+        : window_(window), adaptive_(window != 0) { }
+
+    //! number of Blocks to pin ahead of the reader
+    size_t window() const { return window_; }
+
+    //! Fix the window to the given number of Blocks, stops adaptation.
+    void set_window(size_t window) {
+        window_ = window;
+        adaptive_ = false;
+    }
+
+    //! Called when the reader requests its next Block, adapts the window.
+    void OnRequest(BlockPool& block_pool);
+
+    //! Called when a Block of the given size was delivered to the reader.
+    void OnDeliver(size_t block_size);
+
+private:
+    //! number of Blocks to pin ahead of the reader
+    size_t window_;
+
+    //! whether the window is adapted
+    bool adaptive_;
+
+    //! number of Blocks delivered sequentially
+    size_t sequential_ = 0;
+
+    //! size of the last delivered Block
+    size_t block_size_ = 0;
+
+    //! moving average of the time between two Blocks in seconds
+    double interval_ = 0;
+
+    //! time when the last Block was delivered
+    std::chrono::steady_clock::time_point last_deliver_;
+};
+
 /*!
  * A BlockSource to read Blocks from a File. The KeepFileBlockSource mainly
  * contains an index to the current block, which is incremented when the
@@ -304,13 +389,17 @@ public:
     //! BlockReader
     PinnedBlock NextBlock();
 
-    //! Perform prefetch
+    //! Perform prefetch of a fixed number of Blocks, which stops adapting the
+    //! read-ahead.
     void Prefetch(size_t prefetch);
 
 protected:
     //! Determine current unpinned Block to deliver via NextBlock()
     Block NextUnpinnedBlock();
 
+    //! Pin Blocks until the read-ahead window is full.
+    void FetchAhead();
+
 private:
     //! sentinel value for not changing the first_item item
     static constexpr size_t keep_first_item = size_t(-1);
@@ -321,8 +410,8 @@ private:
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of block prefetch operations
-    size_t num_prefetch_;
+    //! adaptive number of block prefetch operations
+    FileReadAhead read_ahead_;
 
     //! current prefetch operations
     std::deque<data::PinRequestPtr> fetching_blocks_;
@@ -362,9 +451,20 @@ public:
     //! move-constructor: default
     ConsumeFileBlockSource(ConsumeFileBlockSource&& s);
 
-    //! Perform prefetch
+    //! Perform prefetch of a fixed number of Blocks, which stops adapting the
+    //! read-ahead.
     void Prefetch(size_t prefetch);
 
+    //! Pin one more Block beyond the prefetch depth, used by forecasting
+    //! prefetchers. Returns false if there are no more Blocks to pin.
+    bool PrefetchOne();
+
+    //! Return the number of Blocks currently being prefetched.
+    size_t num_fetching() const { return fetching_blocks_.size(); }
+
+    //! Return the number of Blocks neither delivered nor prefetched yet.
+    size_t num_unfetched() const;
+
     //! Get the next block of file.
     PinnedBlock NextBlock();
 
@@ -372,22 +472,25 @@ public:
     ~ConsumeFileBlockSource();
 
 private:
+    //! Pin Blocks until the read-ahead window is full.
+    void FetchAhead();
+
     //! file to consume blocks from (ptr to make moving easier)
     File* file_;
 
     //! local worker id reading the File
     size_t local_worker_id_;
 
-    //! number of block prefetch operations
-    size_t num_prefetch_;
+    //! adaptive number of block prefetch operations
+    FileReadAhead read_ahead_;
 
     //! current prefetch operations
     std::deque<data::PinRequestPtr> fetching_blocks_;
 };
 
 //! Get BlockReader seeked to the corresponding item index
-template <typename ItemType>
-typename File::KeepReader
+template <typename ItemType, IntegerEncoding Encoding>
+BlockReader<KeepFileBlockSource, Encoding>
 File::GetReaderAt(size_t index, size_t prefetch) const {
     static constexpr bool debug = false;
 
@@ -406,8 +509,10 @@ File::GetReaderAt(size_t index, size_t prefetch) const {
          << "psum" << num_items_sum_[begin_block]
          << "first_item" << blocks_[begin_block].first_item_absolute();
 
+    using Reader = BlockReader<KeepFileBlockSource, Encoding>;
+
     // start Reader at given first valid item in located block
-    KeepReader fr(
+    Reader fr(
         KeepFileBlockSource(*this, local_worker_id_, prefetch,
                             begin_block,
                             blocks_[begin_block].first_item_absolute()));
@@ -420,16 +525,19 @@ File::GetReaderAt(size_t index, size_t prefetch) const {
          << "delta" << (index - items_before);
     assert(items_before <= index);
 
-    // use fixed_size information to accelerate jump.
-    if (Serialization<KeepReader, ItemType>::is_fixed_size)
-    {
-        // fetch a Block to get typecode_verify flag
+    // fetch a Block to get typecode_verify flag and integer encoding
+    if (Serialization<Reader, ItemType>::is_fixed_size)
         fr.HasNext();
 
+    // use fixed_size information to accelerate jump, unless encoded integers
+    // have variable size.
+    if (Serialization<Reader, ItemType>::is_fixed_size &&
+        fr.int_encoding() == IntegerEncoding::None)
+    {
         const size_t skip_items = index - items_before;
         const size_t bytes_per_item =
             (fr.typecode_verify() ? sizeof(size_t) : 0)
-            + Serialization<KeepReader, ItemType>::fixed_size;
+            + Serialization<Reader, ItemType>::fixed_size;
 
         fr.Skip(skip_items, skip_items * bytes_per_item);
     }
@@ -448,10 +556,11 @@ File::GetReaderAt(size_t index, size_t prefetch) const {
     return fr;
 }
 
-template <typename ItemType>
+template <typename ItemType, IntegerEncoding Encoding>
 ItemType File::GetItemAt(size_t index) const {
-    KeepReader reader = this->GetReaderAt<ItemType>(index, /* prefetch */ 0);
-    return reader.Next<ItemType>();
+    BlockReader<KeepFileBlockSource, Encoding> reader =
+        this->GetReaderAt<ItemType, Encoding>(index, /* prefetch */ 0);
+    return reader.template Next<ItemType>();
 }
 
 template <typename ItemType, typename CompareFunction>
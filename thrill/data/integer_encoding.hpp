@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * thrill/data/integer_encoding.hpp
+ *
+ * Lightweight encoding of integer items in Blocks written by BlockWriter.
+ *
+ * Part of Project Thrill - http://project-thrill.org
+ *
+ * All rights reserved. Published under the BSD-2 license in the LICENSE file.
+ ******************************************************************************/
+
+#pragma once
+#ifndef THRILL_DATA_INTEGER_ENCODING_HEADER
+#define THRILL_DATA_INTEGER_ENCODING_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace thrill {
+namespace data {
+
+//! \addtogroup data_layer
+//! \{
+
+/*!
+ * Encoding of integral values serialized via PutRaw() into a ByteBlock. With
+ * FrameOfReference, the first value written into a ByteBlock is stored as the
+ * block's base in its first int_base_size bytes, which precede all items. All
+ * integral values are then written as varint of either the zigzag encoded
+ * difference to the base or the value itself, whichever is smaller, tagged by
+ * the lowest bit. Hence, clustered or small-valued integers take one to three
+ * bytes instead of eight, and each ByteBlock can be decoded on its own.
+ *
+ * The encoding is a template parameter of BlockWriter and BlockReader, which
+ * must match. Encoded items have variable size: seeking via
+ * File::GetReaderAt(), File::GetItemAt(), and BlockReader::GetItemBatch()
+ * still locates the Block by item counts, but then decodes the preceding items
+ * in the Block one by one, which costs time linear in the block size instead
+ * of a constant jump by the fixed item size.
+ */
+enum class IntegerEncoding : uint8_t {
+    //! raw bytes of the integers
+    None = 0,
+    //! tagged varint of the difference to the ByteBlock's base or the value
+    FrameOfReference = 1
+};
+
+//! number of bytes at the beginning of a ByteBlock holding the base
+static constexpr size_t int_base_size = sizeof(uint64_t);
+
+//! type trait whether values of type T are subject to integer encoding.
+template <typename T>
+struct IsEncodedInteger
+    : public std::integral_constant<
+          bool, std::is_integral<T>::value && sizeof(T) <= sizeof(uint64_t)>{ };
+
+//! map a two's complement difference to an unsigned value, such that small
+//! negative and positive differences are small.
+static inline uint64_t ZigZagEncode(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t(0) - (delta >> 63));
+}
+
+//! reverse ZigZagEncode()
+static inline uint64_t ZigZagDecode(uint64_t v) {
+    return (v >> 1) ^ (uint64_t(0) - (v & 1));
+}
+
+//! \}
+
+} // namespace data
+} // namespace thrill
+
+#endif // !THRILL_DATA_INTEGER_ENCODING_HEADER
+
+/******************************************************************************/
@@ -87,6 +87,12 @@ MixBlockQueueSink::MixBlockQueueSink(
       from_global_(from_global)
 { }
 
+PinnedByteBlockPtr MixBlockQueueSink::AllocateByteBlock(size_t block_size) {
+    return block_pool()->AllocateByteBlock(
+        block_size, local_worker_id(),
+        block_pool()->worker_numa_node(dst_mix_queue_.local_worker_id()));
+}
+
 void MixBlockQueueSink::AppendBlock(const Block& b) {
     LOG << "MixBlockQueueSink::AppendBlock()"
         << " from_global_=" << from_global_ << " b=" << b;
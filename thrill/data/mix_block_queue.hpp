@@ -92,6 +92,9 @@ public:
     //! return block pool
     BlockPool& block_pool() { return block_pool_; }
 
+    //! return local worker id of the receiving worker
+    size_t local_worker_id() const { return local_worker_id_; }
+
     //! append block delivered via the network from src.
     void AppendBlock(size_t src, const Block& block);
 
@@ -150,6 +153,10 @@ public:
     MixBlockQueueSink(MixStream& dst_mix_stream,
                       size_t from_global, size_t from_local);
 
+    //! Allocate ByteBlocks on the NUMA node of the receiving worker, which
+    //! reads them after the handover.
+    PinnedByteBlockPtr AllocateByteBlock(size_t block_size) final;
+
     void AppendBlock(const Block& b) final;
 
     void AppendBlock(Block&& b) final;
@@ -319,10 +319,7 @@ void Multiplexer::OnCatStreamBlock(
          << "from worker" << header.sender_worker;
 
     stream->OnStreamBlock(
-        header.sender_worker,
-        PinnedBlock(std::move(bytes), 0, header.size,
-                    header.first_item, header.num_items,
-                    header.typecode_verify));
+        header.sender_worker, DecodeStreamBlock(header, std::move(bytes)));
 
     AsyncReadMultiplexerHeader(s);
 }
@@ -337,14 +334,54 @@ void Multiplexer::OnMixStreamBlock(
          << "from worker" << header.sender_worker;
 
     stream->OnStreamBlock(
-        header.sender_worker,
-        PinnedBlock(std::move(bytes), 0, header.size,
-                    header.first_item, header.num_items,
-                    header.typecode_verify));
+        header.sender_worker, DecodeStreamBlock(header, std::move(bytes)));
 
     AsyncReadMultiplexerHeader(s);
 }
 
+PinnedBlock Multiplexer::DecodeStreamBlock(
+    const StreamMultiplexerHeader& header, PinnedByteBlockPtr&& bytes) {
+
+    if (header.codec == BlockCodec::None &&
+        header.int_encoding == IntegerEncoding::None) {
+        return PinnedBlock(std::move(bytes), 0, header.size,
+                           header.first_item, header.num_items,
+                           header.typecode_verify);
+    }
+
+    // encoded integers need their base in front of the data
+    size_t begin =
+        header.int_encoding != IntegerEncoding::None ? int_base_size : 0;
+
+    // round of allocation size to next power of two
+    size_t alloc_size = begin + header.raw_size;
+    if (alloc_size < THRILL_DEFAULT_ALIGN) alloc_size = THRILL_DEFAULT_ALIGN;
+    alloc_size = common::RoundUpToPowerOfTwo(alloc_size);
+
+    PinnedByteBlockPtr raw = block_pool_.AllocateByteBlock(
+        alloc_size, header.receiver_local_worker);
+
+    if (header.codec == BlockCodec::None) {
+        std::copy(bytes->begin(), bytes->begin() + header.size,
+                  raw->begin() + begin);
+    }
+    else {
+        die_unequal(
+            BlockDecompress(header.codec, bytes->begin(), header.size,
+                            raw->begin() + begin, header.raw_size),
+            header.raw_size);
+    }
+
+    if (header.int_encoding != IntegerEncoding::None) {
+        raw->set_int_encoding(header.int_encoding);
+        raw->set_int_base(header.int_base);
+    }
+
+    return PinnedBlock(std::move(raw), begin, begin + header.raw_size,
+                       begin + header.first_item, header.num_items,
+                       header.typecode_verify);
+}
+
 BlockQueue* Multiplexer::CatLoopback(
     size_t stream_id, size_t from_worker_id, size_t to_worker_id) {
     std::unique_lock<std::mutex> lock(mutex_);
@@ -46,6 +46,7 @@ class BlockQueue;
 class MixBlockQueueSink;
 
 class StreamMultiplexerHeader;
+class PinnedBlock;
 
 /*!
  * Multiplexes virtual Connections on Dispatcher.
@@ -207,6 +208,11 @@ private:
     void OnMixStreamBlock(
         Connection& s, const StreamMultiplexerHeader& header,
         const MixStreamPtr& stream, PinnedByteBlockPtr&& bytes);
+
+    //! Constructs the received Block, decoding its bytes if the header names
+    //! a codec, and restoring the base of encoded integers.
+    PinnedBlock DecodeStreamBlock(
+        const StreamMultiplexerHeader& header, PinnedByteBlockPtr&& bytes);
 };
 
 //! \}
@@ -39,6 +39,14 @@ public:
     size_t size = 0;
     size_t num_items = 0;
     size_t first_item = 0;
+    //! codec applied to the Block's bytes
+    BlockCodec codec = BlockCodec::None;
+    //! size of the Block after decoding, equal to size if codec is None.
+    size_t raw_size = 0;
+    //! encoding of integers in the Block
+    IntegerEncoding int_encoding = IntegerEncoding::None;
+    //! base of encoded integers, which is not part of the Block's data.
+    uint64_t int_base = 0;
     //! typecode self verify
     bool typecode_verify = false;
 
@@ -49,11 +57,16 @@ public:
           size(b.size()),
           num_items(b.num_items()),
           first_item(b.first_item_relative()),
+          raw_size(b.size()),
+          int_encoding(b.byte_block()->int_encoding()),
+          int_base(int_encoding != IntegerEncoding::None
+                   ? b.byte_block()->int_base() : 0),
           typecode_verify(b.typecode_verify())
     { }
 
     static constexpr size_t header_size =
-        sizeof(MagicByte) + 3 * sizeof(size_t);
+        sizeof(MagicByte) + sizeof(BlockCodec) + sizeof(IntegerEncoding) +
+        4 * sizeof(size_t) + sizeof(uint64_t);
 
     static constexpr size_t total_size =
         header_size + 3 * sizeof(size_t);
@@ -71,6 +84,10 @@ public:
             bb.Put<size_t>(first_item |
                            (typecode_verify ? size_t(1) << size_t_highest : 0));
         }
+        bb.Put<BlockCodec>(codec);
+        bb.Put<size_t>(raw_size);
+        bb.Put<IntegerEncoding>(int_encoding);
+        bb.Put<uint64_t>(int_base);
     }
 
     void ParseMultiplexerHeader(net::BufferReader& br) {
@@ -83,6 +100,10 @@ public:
             typecode_verify = (first_item & (size_t(1) << size_t_highest)) != 0;
             first_item &= ~(size_t(1) << size_t_highest);
         }
+        codec = br.Get<BlockCodec>();
+        raw_size = br.Get<size_t>();
+        int_encoding = br.Get<IntegerEncoding>();
+        int_base = br.Get<uint64_t>();
     }
 };
 
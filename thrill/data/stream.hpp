@@ -68,6 +68,14 @@ public:
 
     void OnAllClosed(const char* stream_type);
 
+    //! Returns the codec applied to Blocks sent over the network.
+    BlockCodec codec() const { return codec_; }
+
+    //! Set the codec applied to Blocks sent over the network by this worker.
+    //! The receivers decode Blocks according to their header, hence the codec
+    //! must only be set on the sending side, before the first Block is sent.
+    void set_codec(BlockCodec codec) { codec_ = codec; }
+
     //! shuts the stream down.
     virtual void Close() = 0;
 
@@ -183,6 +191,9 @@ protected:
     //! Associated DIANode id.
     size_t dia_id_;
 
+    //! codec applied to Blocks sent over the network
+    BlockCodec codec_ = BlockCodec::None;
+
     //! reference to multiplexer
     Multiplexer& multiplexer_;
 
@@ -75,6 +75,24 @@ void StreamSink::AppendPinnedBlock(const PinnedBlock& block) {
 
     sLOG << "sending block" << common::Hexdump(block.ToString());
 
+    // encode the Block's bytes, if the codec saves at least an eighth.
+    PinnedBlock send_block = block;
+    if (stream_.codec() != BlockCodec::None)
+    {
+        PinnedByteBlockPtr bytes = block_pool()->AllocateByteBlock(
+            block.size(), local_worker_id_);
+
+        size_t size = BlockCompress(
+            stream_.codec(), block.data_begin(), block.size(),
+            bytes->begin(), block.size() - block.size() / 8);
+
+        if (size != 0) {
+            header.size = size;
+            header.codec = stream_.codec();
+            send_block = PinnedBlock(std::move(bytes), 0, size, 0, 0, false);
+        }
+    }
+
     net::BufferBuilder bb;
     header.Serialize(bb);
 
@@ -82,13 +100,13 @@ void StreamSink::AppendPinnedBlock(const PinnedBlock& block) {
     assert(buffer.size() == MultiplexerHeader::total_size);
 
     item_counter_ += block.num_items();
-    byte_counter_ += buffer.size() + block.size();
+    byte_counter_ += buffer.size() + send_block.size();
     ++block_counter_;
 
     stream_.multiplexer_.dispatcher_.AsyncWrite(
         *connection_,
         // send out Buffer and Block, guaranteed to be successive
-        std::move(buffer), PinnedBlock(block),
+        std::move(buffer), std::move(send_block),
         [this](net::Connection&) { sem_.signal(); });
 }
 